@@ -0,0 +1,103 @@
+/**
+\file bench_aat.cpp
+\brief Benchmark of the latency of the deferred transitions (pass states): posted in the event loop, raised as an OS signal,
+or processed by the FSM itself
+
+A FSM whose 8 states are pass states on a ring (each one has an AAT to the next one), so that once started,
+it switches forever, each hop being deferred by the event handler. The callback stops the FSM after 100000 hops.
+Three event handlers are compared:
+ - \c AsioWrapper, that posts a handler in its \c io_context (see AsioWrapper::postInnerEvent()),
+ - \c SignalWrapper (below), that does as \c AsioWrapper did before: it raises \c SIGUSR1 with \c std::raise(),
+and processes the hop in the handler of a \c boost::asio::signal_set,
+ - bench::CountingTimer, that can do neither, so the hops are processed by the FSM, in its drain loop (see SpagFSM::drainInnerEvents()).
+
+Time is per hop, including the callback (that only counts).
+
+Needs Boost. Build with <code>make bench</code>, and run with <code>make runbench</code>.
+
+This file is part of Spaghetti, a C++ library for implementing Finite State Machines
+
+Homepage: https://github.com/skramm/spaghetti
+*/
+
+#define SPAG_USE_ASIO_WRAPPER
+#define SPAG_USE_SIGNALS
+#include "spaghetti.hpp"
+#include "bench_common.hpp"
+
+#include <csignal>
+
+enum class States { NB_STATES = 8 };
+enum class Events { NB_EVENTS = 1 };
+
+constexpr size_t nbHops = 100000;
+constexpr size_t nbRuns = 5;
+
+//-----------------------------------------------------------------------------------
+/// Event handler processing the deferred transitions with an OS signal (former behavior of AsioWrapper). No timer.
+template<typename ST, typename EV, typename CBA>
+struct SignalWrapper
+{
+	boost::asio::io_context _io;
+	boost::asio::executor_work_guard<boost::asio::io_context::executor_type> _ewg;
+	boost::asio::signal_set _signals;
+
+	SignalWrapper() : _ewg( boost::asio::make_work_guard( _io ) ), _signals( _io, SIGUSR1 )
+	{}
+
+	template<typename FSM>
+	void init( FSM* fsm )
+	{
+		waitSignal( fsm );
+		_io.run();
+	}
+	template<typename FSM>
+	void waitSignal( FSM* fsm )
+	{
+		_signals.async_wait( [this,fsm]( const boost::system::error_code& err_code, int )    // lambda
+		{
+			if( err_code )
+				return;
+			fsm->processInnerEvent( fsm->getStateInfo( SPAG_P_CAST2IDX( fsm->currentState() ) ) );
+			waitSignal( fsm );
+		} );
+	}
+	void kill()
+	{
+		_signals.cancel();
+		_io.stop();
+	}
+	template<typename FSM>
+	void timerStart( const FSM* ) {}
+	void timerCancel() {}
+	void raiseSignal() { std::raise( SIGUSR1 ); }
+};
+
+//-----------------------------------------------------------------------------------
+template<typename TIM>
+void
+runCase( std::string title )
+{
+	using fsm_t = spag::SpagFSM<States,Events,TIM>;
+	bench::printResult( title, bench::bestOf( nbRuns, nbHops, [&]()
+		{
+			auto p_timer = std::make_unique<TIM>();
+			auto p_fsm   = std::make_unique<fsm_t>();
+			p_fsm->assignEventHandler( p_timer.get() );
+			for( size_t s=0; s<static_cast<size_t>(States::NB_STATES); s++ )
+				p_fsm->assignAAT( static_cast<States>(s), static_cast<States>( (s+1) % static_cast<size_t>(States::NB_STATES) ) );
+			size_t count = 0;
+			p_fsm->assignCallback( [&]( int ){ if( ++count == nbHops ) p_fsm->stop(); } );   // lambda
+			p_fsm->start();                                                                  // blocking, until stopped
+			bench::g_sink = count;
+		} ), "ns/hop" );
+}
+
+//-----------------------------------------------------------------------------------
+int main()
+{
+	bench::printHeader( "Deferred transitions (AAT), ring of 8 pass states" );
+	runCase<spag::AsioWrapper<States,Events,int>>( "posted in io_context (AsioWrapper)" );
+	runCase<SignalWrapper<States,Events,int>>(     "OS signal (std::raise + signal_set)" );
+	runCase<bench::CountingTimer<States,Events,int>>( "drained by the FSM (no event loop)" );
+}
@@ -0,0 +1,92 @@
+/**
+\file bench_aat_chain.cpp
+\brief Benchmark of the latency of an event leading to a chain of pass states, vs. the length of the chain,
+with and without collapsing the chains (see spag::FsmTraits::collapseAAT)
+
+The FSM has a state S0, then a chain of \c L pass states, then a final state. Event 0 goes from S0 to the first pass state,
+and from the final state back to S0. Time is per event, thus for half of the events, the whole chain is crossed.
+The timer class has no \c postInnerEvent() and no \c raiseSignal(), so without collapsing, each hop is processed by
+the drain loop of the FSM (see SpagFSM::drainInnerEvents()): this is the cheapest deferred processing, without any event loop.
+
+Done without callback, and with a callback on every state (then collapsing only avoids the deferred processing).
+
+Build with <code>make bench</code>, and run with <code>make runbench</code>.
+
+This file is part of Spaghetti, a C++ library for implementing Finite State Machines
+
+Homepage: https://github.com/skramm/spaghetti
+*/
+
+#include "spaghetti.hpp"
+#include "bench_common.hpp"
+
+/// States of a FSM holding a chain of \c LEN pass states
+template<size_t LEN>
+struct Chain
+{
+	enum class States { NB_STATES = LEN+2 };
+};
+enum class Events { NB_EVENTS = 1 };
+
+constexpr size_t nbEvents = 2000000;
+constexpr size_t nbRuns   = 5;
+
+struct Traits : spag::FsmTraits
+{
+	static constexpr bool innerEvents = true;
+};
+
+struct CollapseTraits : Traits
+{
+	static constexpr bool collapseAAT = true;
+};
+
+//-----------------------------------------------------------------------------------
+template<typename TRAITS,size_t LEN>
+double
+runCase( bool withCallbacks )
+{
+	using States   = typename Chain<LEN>::States;
+	using ctimer_t = bench::CountingTimer<States,Events,int>;
+	constexpr size_t length = LEN;
+	auto p_fsm = std::make_unique<spag::SpagFSM<States,Events,ctimer_t,int,TRAITS>>();
+	ctimer_t timer;
+	p_fsm->assignEventHandler( &timer );
+	p_fsm->assignTransition( static_cast<States>(0), static_cast<Events>(0), static_cast<States>(1) );
+	for( size_t s=1; s<=length; s++ )
+		p_fsm->assignAAT( static_cast<States>(s), static_cast<States>(s+1) );
+	p_fsm->assignTransition( static_cast<States>(length+1), static_cast<Events>(0), static_cast<States>(0) );
+	size_t count = 0;
+	if( withCallbacks )
+		p_fsm->assignCallback( [&count]( int ){ count++; } );    // lambda
+	p_fsm->finalize();
+	p_fsm->start();
+	std::vector<Events> v_ev( nbEvents, static_cast<Events>(0) );
+	auto t = bench::bestOf( nbRuns, nbEvents, [&](){ bench::g_sink = bench::feed( *p_fsm, v_ev ); } );
+	bench::g_sink = count;
+	return t;
+}
+
+template<size_t LEN>
+void
+runLength( bool withCallbacks )
+{
+	auto len = std::to_string( LEN );
+	bench::printResult( "length=" + len + ", drained",   runCase<Traits,LEN>( withCallbacks ) );
+	bench::printResult( "length=" + len + ", collapsed", runCase<CollapseTraits,LEN>( withCallbacks ) );
+}
+
+//-----------------------------------------------------------------------------------
+int main()
+{
+	for( bool withCallbacks: { false, true } )
+	{
+		bench::printHeader( std::string( "Chains of pass states, " ) + ( withCallbacks ? "callback on every state" : "no callback" ) );
+		runLength<1>( withCallbacks );
+		runLength<2>( withCallbacks );
+		runLength<4>( withCallbacks );
+		runLength<8>( withCallbacks );
+		runLength<16>( withCallbacks );
+		runLength<32>( withCallbacks );
+	}
+}
@@ -0,0 +1,67 @@
+/**
+\file bench_batch.cpp
+\brief Benchmark of batch event processing (processEvents()) vs. one processEvent() call per event
+
+The same random event sequence is fed to the same FSM, either with one call to processEvent() per event,
+or with a single call to processEvents(), with and without the state trace.
+Done on a small FSM (all cells valid) and on a large one (half of the cells valid), with a SplitTable and with a PackedTable.
+
+Build with <code>make bench</code>, and run with <code>make runbench</code>.
+
+This file is part of Spaghetti, a C++ library for implementing Finite State Machines
+
+Homepage: https://github.com/skramm/spaghetti
+*/
+
+#include "spaghetti.hpp"
+#include "bench_common.hpp"
+
+enum class SmallStates { NB_STATES = 8 };
+enum class SmallEvents { NB_EVENTS = 8 };
+
+enum class LargeStates { NB_STATES = 1024 };
+enum class LargeEvents { NB_EVENTS = 256 };
+
+template<typename TAB>
+struct Traits : spag::FsmTraits
+{
+	using Table = TAB;
+};
+
+constexpr size_t nbEvents = 4000000;
+constexpr size_t nbRuns   = 5;
+
+//-----------------------------------------------------------------------------------
+template<typename ST, typename EV, typename TAB>
+void
+runCase( std::string title, double density )
+{
+	using fsm_t = spag::SpagFSM<ST,EV,bench::CountingTimer<ST,EV,int>,int,Traits<TAB>>;
+	auto p_fsm = std::make_unique<fsm_t>();
+	bench::CountingTimer<ST,EV,int> timer;
+	p_fsm->assignEventHandler( &timer );
+	bench::randomConfig<ST,EV>( *p_fsm, density );
+	p_fsm->start();
+
+	auto v_ev = bench::randomEvents<EV>( nbEvents );
+	std::vector<ST> v_trace( v_ev.size() );
+
+	bench::printResult( title + ", processEvent()", bench::bestOf( nbRuns, v_ev.size(),
+		[&](){ bench::g_sink = bench::feed( *p_fsm, v_ev ); } ) );
+	bench::printResult( title + ", processEvents()", bench::bestOf( nbRuns, v_ev.size(),
+		[&](){ bench::g_sink = p_fsm->processEvents( v_ev ); } ) );
+	bench::printResult( title + ", processEvents(), trace", bench::bestOf( nbRuns, v_ev.size(),
+		[&](){ bench::g_sink = p_fsm->processEvents( v_ev, v_trace.data() ); } ) );
+}
+
+//-----------------------------------------------------------------------------------
+int main()
+{
+	bench::printHeader( "Small FSM: 8 states, 8 events" );
+	runCase<SmallStates,SmallEvents,spag::SplitTable>(  "SplitTable",  1.0 );
+	runCase<SmallStates,SmallEvents,spag::PackedTable>( "PackedTable", 1.0 );
+
+	bench::printHeader( "Large FSM: 1024 states, 256 events" );
+	runCase<LargeStates,LargeEvents,spag::SplitTable>(  "SplitTable",  0.5 );
+	runCase<LargeStates,LargeEvents,spag::PackedTable>( "PackedTable", 0.5 );
+}
@@ -0,0 +1,90 @@
+/**
+\file bench_callbacks.cpp
+\brief Benchmark of the callback dispatch cost, for each callback policy (see FsmTraits::Callback)
+
+A FSM with 16 states and 16 events, all transitions valid, is fed with 4 millions random events,
+so that every event triggers a callback. The callback only adds its argument to a counter.
+Also measured without any callback, as a reference.
+
+Build with <code>make bench</code>, and run with <code>make runbench</code>.
+
+This file is part of Spaghetti, a C++ library for implementing Finite State Machines
+
+Homepage: https://github.com/skramm/spaghetti
+*/
+
+#include "spaghetti.hpp"
+#include "bench_common.hpp"
+
+enum class States { NB_STATES = 16 };
+enum class Events { NB_EVENTS = 16 };
+
+constexpr size_t nbEvents = 4000000;
+constexpr size_t nbRuns   = 5;
+
+size_t g_count = 0;
+
+void cbFunc( int v )                { g_count += v; }
+void cbCtx( void* ctx, int v )      { *static_cast<size_t*>(ctx) += v; }
+
+struct Handler
+{
+	size_t _count = 0;
+	void operator()( States, const int& v ) { _count += v; }
+};
+
+template<typename CB>
+struct Traits : spag::FsmTraits
+{
+	using Callback = CB;
+};
+
+template<typename CB>
+using fsm_t = spag::SpagFSM<States,Events,bench::CountingTimer<States,Events,int>,int,Traits<CB>>;
+
+//-----------------------------------------------------------------------------------
+/// \c assign is a function that assigns the callbacks to the FSM
+template<typename CB, typename F>
+void
+runBench( std::string title, const std::vector<Events>& v_ev, F assign )
+{
+	auto p_fsm = std::make_unique<fsm_t<CB>>();
+	bench::CountingTimer<States,Events,int> timer;
+	p_fsm->assignEventHandler( &timer );
+	bench::randomConfig<States,Events>( *p_fsm, 1.0, 0. );
+	for( int i=0; i<static_cast<int>(States::NB_STATES); i++ )
+		p_fsm->assignCallbackValue( static_cast<States>(i), i );
+	assign( *p_fsm );
+	p_fsm->start();
+	bench::printResult( title, bench::bestOf( nbRuns, v_ev.size(), [&](){ bench::g_sink = bench::feed( *p_fsm, v_ev ); } ) );
+}
+
+//-----------------------------------------------------------------------------------
+int main()
+{
+	auto v_ev = bench::randomEvents<Events>( nbEvents );
+	size_t count = 0;
+	auto lambda = [&count]( int v ){ count += v; };   // lambda
+	Handler handler;
+
+	bench::printHeader( "Callback dispatch, 16 states, 16 events" );
+	runBench<spag::StdFunctionCallback>( "no callback", v_ev, []( auto& ){} );
+	runBench<spag::StdFunctionCallback>( "StdFunctionCallback, function", v_ev,
+		[]( auto& fsm ){ fsm.assignCallback( cbFunc ); } );
+	runBench<spag::StdFunctionCallback>( "StdFunctionCallback, lambda", v_ev,
+		[&]( auto& fsm ){ fsm.assignCallback( lambda ); } );
+	runBench<spag::FnPtrCallback>( "FnPtrCallback", v_ev,
+		[&]( auto& fsm ){ fsm.assignCallback( { cbCtx, &count } ); } );
+	runBench<spag::FunctionRefCallback>( "FunctionRefCallback, function", v_ev,
+		[]( auto& fsm ){ fsm.assignCallback( cbFunc ); } );
+	runBench<spag::FunctionRefCallback>( "FunctionRefCallback, lambda", v_ev,
+		[&]( auto& fsm ){ fsm.assignCallback( lambda ); } );
+	runBench<spag::HandlerCallback<Handler>>( "HandlerCallback", v_ev,
+		[&]( auto& fsm ){ fsm.assignCallbackHandler( &handler ); } );
+	bench::g_sink = g_count + count + handler._count;
+
+	bench::printHeader( "Size of per-state callback storage" );
+	bench::printSize( "StdFunctionCallback", sizeof(spag::StdFunctionCallback::Slot<int>) );
+	bench::printSize( "FnPtrCallback",       sizeof(spag::FnPtrCallback::Slot<int>) );
+	bench::printSize( "FunctionRefCallback", sizeof(spag::FunctionRefCallback::Slot<int>) );
+}
@@ -0,0 +1,156 @@
+/**
+\file bench_common.hpp
+\brief holds some common code shared by the benchmark programs
+
+This file is part of Spaghetti, a C++ library for implementing Finite State Machines
+
+Homepage: https://github.com/skramm/spaghetti
+*/
+
+#ifndef HG_SPAG_BENCH_COMMON_HPP
+#define HG_SPAG_BENCH_COMMON_HPP
+
+#include <chrono>
+#include <random>
+#include <vector>
+#include <string>
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+#include <memory>
+
+namespace bench {
+
+//-----------------------------------------------------------------------------------
+/// Dummy timer class: does nothing but counting the calls.
+/**
+Used so that timeouts can be assigned (and thus timers started and canceled) without running an event loop.
+*/
+template<typename ST, typename EV, typename CBA>
+struct CountingTimer
+{
+	size_t _nbStart  = 0;
+	size_t _nbCancel = 0;
+
+	template<typename FSM>
+	void timerStart( const FSM* ) { _nbStart++; }
+	template<typename FSM>
+	void init( const FSM* ) {}
+	void timerCancel() { _nbCancel++; }
+	void kill() {}
+};
+
+//-----------------------------------------------------------------------------------
+/// Runs \c func \c nbRuns times, and returns the best time, in ns, divided by \c nbOps
+template<typename F>
+double
+bestOf( size_t nbRuns, size_t nbOps, F func )
+{
+	double best = 1E30;
+	for( size_t i=0; i<nbRuns; i++ )
+	{
+		auto t0 = std::chrono::steady_clock::now();
+		func();
+		auto t1 = std::chrono::steady_clock::now();
+		double ns = std::chrono::duration<double,std::nano>( t1 - t0 ).count() / nbOps;
+		best = std::min( best, ns );
+	}
+	return best;
+}
+
+//-----------------------------------------------------------------------------------
+/// Returns a vector of \c nb random events, uniformly distributed over \c EV::NB_EVENTS
+template<typename EV>
+std::vector<EV>
+randomEvents( size_t nb, unsigned seed=42 )
+{
+	std::mt19937 gen( seed );
+	std::uniform_int_distribution<size_t> dist( 0, static_cast<size_t>(EV::NB_EVENTS) - 1 );
+	std::vector<EV> out( nb );
+	for( auto& e: out )
+		e = static_cast<EV>( dist(gen) );
+	return out;
+}
+
+//-----------------------------------------------------------------------------------
+/// Assigns random transitions: each (state,event) cell is valid with probability \c density.
+/**
+A ratio \c toRatio of the states are also assigned a timeout (only if \c withTimeOuts is true, as FSM types without
+timer can not be assigned timeouts).
+*/
+template<typename ST, typename EV, bool withTimeOuts=true, typename FSM>
+void
+randomConfig( FSM& fsm, double density, double toRatio=0.2, unsigned seed=42 )
+{
+	std::mt19937 gen( seed );
+	std::uniform_real_distribution<double> proba( 0., 1. );
+	std::uniform_int_distribution<size_t> st_dist( 0, static_cast<size_t>(ST::NB_STATES) - 1 );
+
+	for( size_t s=0; s<static_cast<size_t>(ST::NB_STATES); s++ )
+	{
+		for( size_t e=0; e<static_cast<size_t>(EV::NB_EVENTS); e++ )
+			if( proba(gen) < density )
+				fsm.assignTransition( static_cast<ST>(s), static_cast<EV>(e), static_cast<ST>( st_dist(gen) ) );
+		if constexpr( withTimeOuts )
+			if( proba(gen) < toRatio )
+				fsm.assignTimeOut( static_cast<ST>(s), 1, static_cast<ST>( st_dist(gen) ) );
+	}
+	fsm.assignTransition( static_cast<ST>(0), static_cast<EV>(0), static_cast<ST>(1) ); // so that we never stay on initial state
+}
+
+//-----------------------------------------------------------------------------------
+/// Assigns transitions so that the FSM always stays on a few "hot" states: all the events are valid on all the states,
+/// and lead to one of the \c nbHot first states.
+template<typename ST, typename EV, typename FSM>
+void
+hotStatesConfig( FSM& fsm, size_t nbHot, unsigned seed=42 )
+{
+	std::mt19937 gen( seed );
+	std::uniform_int_distribution<size_t> st_dist( 0, nbHot - 1 );
+
+	for( size_t s=0; s<static_cast<size_t>(ST::NB_STATES); s++ )
+		for( size_t e=0; e<static_cast<size_t>(EV::NB_EVENTS); e++ )
+			fsm.assignTransition( static_cast<ST>(s), static_cast<EV>(e), static_cast<ST>( st_dist(gen) ) );
+}
+
+//-----------------------------------------------------------------------------------
+/// Feeds the FSM with all the events of \c v_ev, and returns the final state (so that the compiler can't remove the loop)
+template<typename FSM, typename EV>
+size_t
+feed( const FSM& fsm, const std::vector<EV>& v_ev )
+{
+	for( const auto& ev: v_ev )
+		fsm.processEvent( ev );
+	return static_cast<size_t>( fsm.currentState() );
+}
+
+//-----------------------------------------------------------------------------------
+inline
+void
+printHeader( std::string title )
+{
+	std::cout << "\n# " << title << '\n';
+}
+
+inline
+void
+printResult( std::string label, double value, std::string unit="ns/event" )
+{
+	std::cout << " - " << std::left << std::setw(40) << label << ": "
+		<< std::right << std::fixed << std::setprecision(2) << std::setw(9) << value << ' ' << unit << '\n';
+}
+
+inline
+void
+printSize( std::string label, size_t value )
+{
+	std::cout << " - " << std::left << std::setw(40) << label << ": "
+		<< std::right << std::setw(9) << value << " bytes\n";
+}
+
+/// Used to make sure the compiler doesn't remove the benchmarked code
+inline volatile size_t g_sink;
+
+} // namespace bench
+
+#endif // HG_SPAG_BENCH_COMMON_HPP
@@ -0,0 +1,125 @@
+/**
+\file bench_drift.cpp
+\brief Drift measurement of periodic timeouts: timeouts measured from the current time (default) vs. from the previous deadline
+(see SpagFSM::setDriftFreeTimeOut())
+
+A FSM with two states switching on a 1 ms timeout (as the \c BlinkOn / \c BlinkOff pair of the traffic lights samples),
+whose callback takes 100 us (busy loop). For each of the 3000 switches, the expected time (<code>start + n * 1 ms</code>)
+is compared to the actual time the callback is called.
+
+Cases:
+ - \c AsioWrapper, default timeouts: the latency of the event loop (from the expiry to the start of the next timeout) adds up at each switch,
+ - \c AsioWrapper, drift-free timeouts,
+ - \c WheelTimer, 100 us ticks (drift-free by design, but rounded up to the tick).
+
+Measured: the lateness of the last switch (the accumulated drift), the average and maximum lateness.
+If a file name is given as argument, each switch is logged into it (CSV: case;switch;expected (us);actual (us);lateness (us)).
+
+Needs Boost. Build with <code>make bench</code>, and run with <code>make runbench</code>.
+
+This file is part of Spaghetti, a C++ library for implementing Finite State Machines
+
+Homepage: https://github.com/skramm/spaghetti
+*/
+
+#define SPAG_USE_ASIO_WRAPPER
+#define SPAG_EXTERNAL_EVENT_LOOP
+#include "spaghetti.hpp"
+#include "bench_common.hpp"
+
+#include <fstream>
+
+enum class States { BlinkOn, BlinkOff, NB_STATES };
+enum class Events { Toggle, NB_EVENTS };
+
+using Clock = std::chrono::steady_clock;
+
+constexpr size_t nbSwitches = 3000;
+constexpr auto   period     = std::chrono::milliseconds(1);
+constexpr auto   cbDuration = std::chrono::microseconds(100);
+
+std::ofstream g_log;
+
+//-----------------------------------------------------------------------------------
+/// Runs the FSM until \c nbSwitches timeouts have been processed, with a timer object of type \c TIM
+template<typename TIM>
+void
+runCase( std::string title, boost::asio::io_context& io, TIM& timer, bool driftFree )
+{
+	using fsm_t = spag::SpagFSM<States,Events,TIM>;
+
+	fsm_t fsm;
+	fsm.assignEventHandler( &timer );
+	fsm.assignTimeOut( States::BlinkOn,  1, "ms", States::BlinkOff );
+	fsm.assignTimeOut( States::BlinkOff, 1, "ms", States::BlinkOn );
+	fsm.assignTransition( States::BlinkOn,  Events::Toggle, States::BlinkOff );
+	fsm.assignTransition( States::BlinkOff, Events::Toggle, States::BlinkOn );
+	fsm.setDriftFreeTimeOuts( driftFree );
+
+	std::vector<Clock::time_point> v_time;
+	v_time.reserve( nbSwitches + 1 );
+	fsm.assignCallback( [&]( int )                        // lambda
+		{
+			auto t = Clock::now();
+			v_time.push_back( t );
+			if( v_time.size() == nbSwitches + 1 )
+				io.stop();
+			while( Clock::now() - t < cbDuration )            // the work done by the callback
+				;
+		}
+	);
+
+	auto t0 = Clock::now();
+	fsm.start();                                          // not blocking, because of SPAG_EXTERNAL_EVENT_LOOP
+	io.run();
+	fsm.stop();
+	io.restart();
+
+	double sum = 0.;
+	double max = 0.;
+	double lateness = 0.;
+	for( size_t i=1; i<v_time.size(); i++ )
+	{
+		auto expected = t0 + static_cast<int>(i) * period;
+		lateness = std::chrono::duration<double,std::micro>( v_time[i] - expected ).count();
+		sum += lateness;
+		max  = std::max( max, lateness );
+		if( g_log.is_open() )
+			g_log << title << ';' << i
+				<< ';' << std::chrono::duration<double,std::micro>( expected - t0 ).count()
+				<< ';' << std::chrono::duration<double,std::micro>( v_time[i] - t0 ).count()
+				<< ';' << lateness << '\n';
+	}
+	bench::printHeader( title );
+	bench::printResult( "lateness of last switch (drift)", lateness / 1000., "ms" );
+	bench::printResult( "average lateness",                sum / ( v_time.size() - 1 ), "us" );
+	bench::printResult( "maximum lateness",                max, "us" );
+}
+
+//-----------------------------------------------------------------------------------
+int main( int argc, const char** argv )
+{
+	if( argc > 1 )
+		g_log.open( argv[1] );
+	std::cout << nbSwitches << " switches on 1 ms timeouts, callback takes "
+		<< std::chrono::duration_cast<std::chrono::microseconds>( cbDuration ).count() << " us\n";
+	{
+		boost::asio::io_context io;
+		spag::AsioWrapper<States,Events,int> timer( io );
+		runCase( "AsioWrapper, default timeouts", io, timer, false );
+	}
+	{
+		boost::asio::io_context io;
+		spag::AsioWrapper<States,Events,int> timer( io );
+		runCase( "AsioWrapper, drift-free timeouts", io, timer, true );
+	}
+	{
+		boost::asio::io_context io;
+		spag::TimingWheel wheel( std::chrono::microseconds(100) );
+		spag::AsioWheelDriver driver( io, wheel );
+		driver.start();
+		spag::WheelTimer<States,Events,int> timer( wheel );
+		runCase( "WheelTimer, 100 us ticks", io, timer, false );
+		driver.stop();
+	}
+}
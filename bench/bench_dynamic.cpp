@@ -0,0 +1,105 @@
+/**
+\file bench_dynamic.cpp
+\brief Benchmark of DynamicSpagFSM (run-time sized) vs. SpagFSM (compile-time sized)
+
+Both FSM are given the same random configuration and are fed the same random event sequence,
+on a small FSM and on a large one, with half of the cells valid, and with all of them valid.
+Also measures the construction time, as DynamicSpagFSM does a heap allocation.
+
+Build with <code>make bench</code>, and run with <code>make runbench</code>.
+
+This file is part of Spaghetti, a C++ library for implementing Finite State Machines
+
+Homepage: https://github.com/skramm/spaghetti
+*/
+
+#include "spaghetti.hpp"
+#include "bench_common.hpp"
+
+enum class SmallStates { NB_STATES = 8 };
+enum class SmallEvents { NB_EVENTS = 8 };
+
+enum class LargeStates { NB_STATES = 1024 };
+enum class LargeEvents { NB_EVENTS = 256 };
+
+constexpr size_t nbEvents = 4000000;
+constexpr size_t nbRuns   = 5;
+constexpr size_t nbBuild  = 1000;
+
+/// A transition: source state, event, destination state
+struct Trans
+{
+	size_t _st1, _ev, _st2;
+};
+
+//-----------------------------------------------------------------------------------
+/// Each (state,event) cell is valid with probability \c density
+std::vector<Trans>
+buildConfig( size_t nbSt, size_t nbEv, double density )
+{
+	std::mt19937 gen( 42 );
+	std::uniform_real_distribution<double> proba( 0., 1. );
+	std::uniform_int_distribution<size_t> st_dist( 0, nbSt - 1 );
+	std::vector<Trans> v_trans;
+	for( size_t s=0; s<nbSt; s++ )
+		for( size_t e=0; e<nbEv; e++ )
+			if( proba(gen) < density )
+				v_trans.push_back( Trans{ s, e, st_dist(gen) } );
+	v_trans.push_back( Trans{ 0, 0, 1 } );  // so that we never stay on initial state
+	return v_trans;
+}
+
+//-----------------------------------------------------------------------------------
+template<typename ST, typename EV, typename FSM>
+double
+runBench( FSM& fsm, const std::vector<Trans>& v_trans, const std::vector<EV>& v_ev )
+{
+	bench::CountingTimer<ST,EV,int> timer;
+	fsm.assignEventHandler( &timer );
+	for( const auto& tr: v_trans )
+		fsm.assignTransition( static_cast<ST>(tr._st1), static_cast<EV>(tr._ev), static_cast<ST>(tr._st2) );
+	fsm.start();
+	return bench::bestOf( nbRuns, v_ev.size(), [&](){ bench::g_sink = bench::feed( fsm, v_ev ); } );
+}
+
+//-----------------------------------------------------------------------------------
+template<typename ST, typename EV>
+void
+runCase( std::string title )
+{
+	constexpr size_t nbSt = static_cast<size_t>(ST::NB_STATES);
+	constexpr size_t nbEv = static_cast<size_t>(EV::NB_EVENTS);
+	using static_t  = spag::SpagFSM<ST,EV,bench::CountingTimer<ST,EV,int>,int>;
+	using dynamic_t = spag::DynamicSpagFSM<bench::CountingTimer<size_t,size_t,int>>;
+
+	bench::printHeader( title + ": " + std::to_string( nbSt ) + " states, " + std::to_string( nbEv ) + " events" );
+
+	auto v_ev = bench::randomEvents<EV>( nbEvents );
+	std::vector<size_t> v_ev_idx( v_ev.size() );
+	std::transform( v_ev.begin(), v_ev.end(), v_ev_idx.begin(), []( EV e ){ return static_cast<size_t>(e); } ); // lambda
+
+	for( auto density: { 0.5, 1.0 } )
+	{
+		auto d = " (density=" + std::to_string( density ).substr( 0, 3 ) + ")";
+		auto v_trans = buildConfig( nbSt, nbEv, density );
+		{
+			auto p_fsm = std::make_unique<static_t>();
+			bench::printResult( "SpagFSM" + d, runBench<ST,EV>( *p_fsm, v_trans, v_ev ) );
+		}
+		{
+			dynamic_t fsm( nbSt, nbEv );
+			bench::printResult( "DynamicSpagFSM" + d, runBench<size_t,size_t>( fsm, v_trans, v_ev_idx ) );
+		}
+	}
+	bench::printResult( "SpagFSM, construction", bench::bestOf( nbRuns, nbBuild,
+		[&](){ for( size_t i=0; i<nbBuild; i++ ) { auto p = std::make_unique<static_t>(); bench::g_sink = p->nbStates(); } } ), "ns" );
+	bench::printResult( "DynamicSpagFSM, construction", bench::bestOf( nbRuns, nbBuild,
+		[&](){ for( size_t i=0; i<nbBuild; i++ ) { dynamic_t fsm( nbSt, nbEv ); bench::g_sink = fsm.nbStates(); } } ), "ns" );
+}
+
+//-----------------------------------------------------------------------------------
+int main()
+{
+	runCase<SmallStates,SmallEvents>( "Small FSM" );
+	runCase<LargeStates,LargeEvents>( "Large FSM" );
+}
@@ -0,0 +1,187 @@
+/**
+\file bench_epoll.cpp
+\brief Latency comparison of the two event loop classes: AsioWrapper (Boost.Asio) vs. EpollWrapper (epoll, timerfd and eventfd)
+
+A FSM with two states switching on a 1 ms timeout, or on an event (as the \c BlinkOn / \c BlinkOff pair of the traffic lights samples).
+
+Measured, for each class:
+ - timeout latency: 2000 drift-free timeouts, from the deadline to the call of the callback,
+ - pushed event latency: 10000 events pushed by another thread (see SpagFSM::pushEvent()), from the push to the call of the callback
+   (the thread waits for the callback before pushing the next one),
+ - event processing: 1 million events sent by a handler of the event loop, each one cancels the timer and starts it again.
+
+Needs Boost. Build with <code>make bench</code>, and run with <code>make runbench</code>.
+
+This file is part of Spaghetti, a C++ library for implementing Finite State Machines
+
+Homepage: https://github.com/skramm/spaghetti
+*/
+
+#define SPAG_USE_ASIO_WRAPPER
+#define SPAG_USE_EPOLL_WRAPPER
+#define SPAG_EXTERNAL_EVENT_LOOP
+#include "spaghetti.hpp"
+#include "bench_common.hpp"
+
+enum class States { BlinkOn, BlinkOff, NB_STATES };
+enum class Events { Toggle, NB_EVENTS };
+
+struct Traits : spag::FsmTraits
+{
+	static constexpr size_t inputQueueSize = 16;
+};
+
+using Clock = std::chrono::steady_clock;
+
+constexpr size_t nbTimeOuts = 2000;
+constexpr size_t nbPushed   = 10000;
+constexpr size_t nbEvents   = 1000000;
+constexpr size_t batchSize  = 100;
+
+//-----------------------------------------------------------------------------------
+/// AsioWrapper, with its \c io_context
+struct AsioLoop
+{
+	using timer_type = spag::AsioWrapper<States,Events,int>;
+
+	boost::asio::io_context io;
+	decltype( boost::asio::make_work_guard( io ) ) work = boost::asio::make_work_guard( io );   // run() waits for the pushed events
+	timer_type timer{ io };
+
+	void run()                         { io.run(); }
+	void post( std::function<void()> f ) { boost::asio::post( io, f ); }
+};
+
+/// EpollWrapper
+struct EpollLoop
+{
+	using timer_type = spag::EpollWrapper<States,Events,int>;
+
+	timer_type timer;
+
+	void run()                         { timer.run(); }
+	void post( std::function<void()> f ) { timer.post( f ); }
+};
+
+//-----------------------------------------------------------------------------------
+/// Prints the average, median and 99th percentile of the latencies in \c v_lat (in us)
+void
+printLatencies( std::string label, std::vector<double>& v_lat )
+{
+	std::sort( v_lat.begin(), v_lat.end() );
+	double sum = 0.;
+	for( auto lat: v_lat )
+		sum += lat;
+	bench::printResult( label + ", average", sum / v_lat.size(),             "us" );
+	bench::printResult( label + ", median",  v_lat[ v_lat.size() / 2 ],      "us" );
+	bench::printResult( label + ", 99%",     v_lat[ v_lat.size() * 99 / 100 ], "us" );
+}
+
+//-----------------------------------------------------------------------------------
+template<typename LOOP>
+using fsm_t = spag::SpagFSM<States,Events,typename LOOP::timer_type,int,Traits>;
+
+template<typename LOOP>
+void
+configure( fsm_t<LOOP>& fsm, LOOP& loop, bool withTimeOuts = true )
+{
+	fsm.assignEventHandler( &loop.timer );
+	if( withTimeOuts )
+	{
+		fsm.assignTimeOut( States::BlinkOn,  1, "ms", States::BlinkOff );
+		fsm.assignTimeOut( States::BlinkOff, 1, "ms", States::BlinkOn );
+	}
+	fsm.assignTransition( States::BlinkOn,  Events::Toggle, States::BlinkOff );
+	fsm.assignTransition( States::BlinkOff, Events::Toggle, States::BlinkOn );
+	fsm.setDriftFreeTimeOuts();
+}
+
+//-----------------------------------------------------------------------------------
+template<typename LOOP>
+void
+runCase( std::string title )
+{
+	bench::printHeader( title );
+	{
+		LOOP loop;
+		fsm_t<LOOP> fsm;
+		configure( fsm, loop );
+		std::vector<Clock::time_point> v_time;
+		v_time.reserve( nbTimeOuts + 1 );
+		fsm.assignCallback( [&]( int )                             // lambda
+			{
+				v_time.push_back( Clock::now() );
+				if( v_time.size() == nbTimeOuts + 1 )
+					fsm.stop();
+			}
+		);
+		auto t0 = Clock::now();
+		fsm.start();                                               // not blocking, because of SPAG_EXTERNAL_EVENT_LOOP
+		loop.run();
+		std::vector<double> v_lat;
+		for( size_t i=1; i<v_time.size(); i++ )
+			v_lat.push_back( std::chrono::duration<double,std::micro>( v_time[i] - ( t0 + static_cast<int>(i) * std::chrono::milliseconds(1) ) ).count() );
+		printLatencies( "timeout latency", v_lat );
+	}
+	{
+		LOOP loop;
+		fsm_t<LOOP> fsm;
+		configure( fsm, loop, false );                             // no timeouts: the callback is only called by the pushed events
+		std::atomic<size_t> nbDone{0};
+		Clock::time_point tSend;                                  // written by the producer before pushing, read by the callback
+		std::vector<double> v_lat;
+		v_lat.reserve( nbPushed );
+		bool started = false;
+		fsm.assignCallback( [&]( int )                             // lambda
+			{
+				if( !started )                                     // called by start()
+					return;
+				v_lat.push_back( std::chrono::duration<double,std::micro>( Clock::now() - tSend ).count() );
+				nbDone.store( v_lat.size(), std::memory_order_release );
+			}
+		);
+		fsm.start();
+		started = true;
+		std::thread th( [&]()                                     // lambda
+			{
+				for( size_t i=0; i<nbPushed; i++ )
+				{
+					tSend = Clock::now();
+					fsm.pushEvent( Events::Toggle );
+					while( nbDone.load( std::memory_order_acquire ) == i )
+						std::this_thread::yield();
+				}
+				loop.post( [&fsm](){ fsm.stop(); } );              // lambda
+			}
+		);
+		loop.run();
+		th.join();
+		printLatencies( "pushed event latency", v_lat );
+	}
+	{
+		LOOP loop;
+		fsm_t<LOOP> fsm;
+		configure( fsm, loop );
+		fsm.start();
+		size_t nbSent = 0;
+		std::function<void()> batch = [&]()                       // lambda
+		{
+			for( size_t i=0; i<batchSize; i++ )
+				fsm.processEvent( Events::Toggle );
+			nbSent += batchSize;
+			if( nbSent < nbEvents )
+				loop.post( batch );
+			else
+				fsm.stop();
+		};
+		loop.post( batch );
+		bench::printResult( "event (cancels and starts the timer)", bench::bestOf( 1, nbEvents, [&](){ loop.run(); } ) );
+	}
+}
+
+//-----------------------------------------------------------------------------------
+int main()
+{
+	runCase<AsioLoop>(  "AsioWrapper (Boost.Asio)" );
+	runCase<EpollLoop>( "EpollWrapper (epoll, timerfd, eventfd)" );
+}
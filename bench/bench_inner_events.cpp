@@ -0,0 +1,72 @@
+/**
+\file bench_inner_events.cpp
+\brief Benchmark of the cost of the inner event check in processEvent()
+
+Measures the event processing time on a FSM with 64 states and 32 events, fed with 4 millions random external events.
+Built as is, inner events are not available (symbol \c SPAG_USE_SIGNALS not defined).
+The same program is built with \c SPAG_USE_SIGNALS defined as bench_inner_events_sig.cpp,
+where the 8 last events are declared as inner events on all the states (but never activated).
+Done with and without calling SpagFSM::finalize() before starting.
+
+Build with <code>make bench</code>, and run with <code>make runbench</code>.
+
+This file is part of Spaghetti, a C++ library for implementing Finite State Machines
+
+Homepage: https://github.com/skramm/spaghetti
+*/
+
+#include "spaghetti.hpp"
+#include "bench_common.hpp"
+
+enum class States { NB_STATES = 64 };
+enum class Events { NB_EVENTS = 32 };
+
+constexpr size_t nbExtEvents = 24;  ///< the other ones are inner events, when SPAG_USE_SIGNALS is defined
+constexpr size_t nbEvents    = 4000000;
+constexpr size_t nbRuns      = 5;
+
+using fsm_t = spag::SpagFSM<States,Events,bench::CountingTimer<States,Events,int>,int>;
+
+//-----------------------------------------------------------------------------------
+void
+runCase( std::string title, bool finalize )
+{
+	auto p_fsm = std::make_unique<fsm_t>();
+	bench::CountingTimer<States,Events,int> timer;
+	p_fsm->assignEventHandler( &timer );
+
+	std::mt19937 gen( 42 );
+	std::uniform_int_distribution<size_t> st_dist( 0, static_cast<size_t>(States::NB_STATES) - 1 );
+	for( size_t s=0; s<static_cast<size_t>(States::NB_STATES); s++ )
+		for( size_t e=0; e<nbExtEvents; e++ )
+			p_fsm->assignTransition( static_cast<States>(s), static_cast<Events>(e), static_cast<States>( st_dist(gen) ) );
+#ifdef SPAG_USE_SIGNALS
+	for( size_t e=nbExtEvents; e<static_cast<size_t>(Events::NB_EVENTS); e++ )
+		p_fsm->assignInnerTransition( static_cast<Events>(e), static_cast<States>( st_dist(gen) ) );
+#endif
+	if( finalize )
+		p_fsm->finalize();
+	p_fsm->start();
+
+	std::uniform_int_distribution<size_t> ev_dist( 0, nbExtEvents - 1 );
+	std::vector<Events> v_ev( nbEvents );
+	for( auto& ev: v_ev )
+		ev = static_cast<Events>( ev_dist(gen) );
+
+	bench::printResult( title + "processEvent()", bench::bestOf( nbRuns, v_ev.size(),
+		[&](){ bench::g_sink = bench::feed( *p_fsm, v_ev ); } ) );
+	bench::printResult( title + "processEvents()", bench::bestOf( nbRuns, v_ev.size(),
+		[&](){ bench::g_sink = p_fsm->processEvents( v_ev ); } ) );
+}
+
+//-----------------------------------------------------------------------------------
+int main()
+{
+#ifdef SPAG_USE_SIGNALS
+	bench::printHeader( "SPAG_USE_SIGNALS defined, 8 inner events" );
+#else
+	bench::printHeader( "SPAG_USE_SIGNALS not defined" );
+#endif
+	runCase( "", false );
+	runCase( "finalized, ", true );
+}
@@ -0,0 +1,11 @@
+/**
+\file bench_inner_events_sig.cpp
+\brief Same as bench_inner_events.cpp, but with inner events enabled (symbol \c SPAG_USE_SIGNALS)
+
+This file is part of Spaghetti, a C++ library for implementing Finite State Machines
+
+Homepage: https://github.com/skramm/spaghetti
+*/
+
+#define SPAG_USE_SIGNALS
+#include "bench_inner_events.cpp"
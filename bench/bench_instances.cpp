@@ -0,0 +1,107 @@
+/**
+\file bench_instances.cpp
+\brief Benchmark of the memory footprint of 100k identical FSM: SpagFSM copies vs. FsmInstance objects sharing a FsmConfig
+
+Builds 100000 FSM with 16 states and 8 events, either as copies of a configured SpagFSM (with assignConfig()),
+or as FsmInstance objects sharing a FsmConfig, and prints the memory used (objects plus heap allocations).
+Then feeds 4 millions random events, each one to a random FSM, and prints the processing time.
+
+Build with <code>make bench</code>, and run with <code>make runbench</code>.
+
+This file is part of Spaghetti, a C++ library for implementing Finite State Machines
+
+Homepage: https://github.com/skramm/spaghetti
+*/
+
+#include "spaghetti.hpp"
+#include "bench_common.hpp"
+
+#include <new>
+#include <cstdlib>
+
+/// Heap allocated bytes, currently in use.
+/// Relies on sized deallocation (default since C++14), used by the standard containers.
+static size_t g_allocated = 0;
+
+void* operator new( size_t n )
+{
+	g_allocated += n;
+	if( void* p = std::malloc( n ) )
+		return p;
+	throw std::bad_alloc();
+}
+void operator delete( void* p ) noexcept { std::free( p ); }
+void operator delete( void* p, size_t n ) noexcept
+{
+	g_allocated -= n;
+	std::free( p );
+}
+
+enum class States { NB_STATES = 16 };
+enum class Events { NB_EVENTS = 8 };
+
+using timer_type = bench::CountingTimer<States,Events,int>;
+using fsm_t      = spag::SpagFSM<States,Events,timer_type,int>;
+using inst_t     = spag::FsmInstance<fsm_t>;
+
+constexpr size_t nbFsm    = 100000;
+constexpr size_t nbEvents = 4000000;
+constexpr size_t nbRuns   = 5;
+
+void cb( int ) {}
+
+//-----------------------------------------------------------------------------------
+/// Feeds event \c v_ev[i] to FSM \c v_idx[i]
+template<typename T>
+size_t
+feedAll( const std::vector<T>& v_fsm, const std::vector<Events>& v_ev, const std::vector<size_t>& v_idx )
+{
+	for( size_t i=0; i<v_ev.size(); i++ )
+		v_fsm[ v_idx[i] ].processEvent( v_ev[i] );
+	return static_cast<size_t>( v_fsm[0].currentState() );
+}
+
+//-----------------------------------------------------------------------------------
+int main()
+{
+	timer_type timer;
+	auto p_fsm = std::make_shared<fsm_t>();
+	p_fsm->assignEventHandler( &timer );
+	p_fsm->assignCallback( cb );
+	bench::randomConfig<States,Events>( *p_fsm, 1.0 );
+
+	auto v_ev = bench::randomEvents<Events>( nbEvents );
+	std::vector<size_t> v_idx( nbEvents );
+	std::mt19937 gen( 42 );
+	std::uniform_int_distribution<size_t> dist( 0, nbFsm - 1 );
+	for( auto& idx: v_idx )
+		idx = dist( gen );
+
+	bench::printHeader( "100000 FSM, 16 states, 8 events" );
+	bench::printSize( "sizeof(SpagFSM)",     sizeof(fsm_t) );
+	bench::printSize( "sizeof(FsmInstance)", sizeof(inst_t) );
+	{
+		auto alloc0 = g_allocated;
+		std::vector<fsm_t> v_fsm( nbFsm );
+		for( auto& fsm: v_fsm )
+		{
+			fsm.assignConfig( *p_fsm );
+			fsm.assignEventHandler( &timer );
+		}
+		bench::printResult( "SpagFSM copies: memory", ( g_allocated - alloc0 ) / 1024. / 1024., "MB" );
+		for( auto& fsm: v_fsm )
+			fsm.start();
+		bench::printResult( "SpagFSM copies: time", bench::bestOf( nbRuns, nbEvents, [&](){ bench::g_sink = feedAll( v_fsm, v_ev, v_idx ); } ) );
+	}
+	{
+		auto alloc0 = g_allocated;
+		spag::FsmConfig<fsm_t> config( p_fsm );
+		std::vector<inst_t> v_fsm( nbFsm, inst_t( config ) );
+		for( auto& fsm: v_fsm )
+			fsm.assignEventHandler( &timer );
+		bench::printResult( "FsmInstance: memory", ( g_allocated - alloc0 ) / 1024. / 1024., "MB" );
+		for( auto& fsm: v_fsm )
+			fsm.start();
+		bench::printResult( "FsmInstance: time", bench::bestOf( nbRuns, nbEvents, [&](){ bench::g_sink = feedAll( v_fsm, v_ev, v_idx ); } ) );
+	}
+}
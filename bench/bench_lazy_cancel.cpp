@@ -0,0 +1,94 @@
+/**
+\file bench_lazy_cancel.cpp
+\brief Benchmark of the timer cancelation of AsioWrapper at a high event rate: synchronous (default) vs. lazy (see AsioWrapper::setLazyCancel())
+
+A FSM with two states switching on a 100 ms timeout (as the \c BlinkOn / \c BlinkOff pair of the traffic lights samples),
+and an event that switches right away. A handler of the event loop sends 1 million events, by batches of 100
+(then posts itself again), so each transition cancels the timer and starts it again.
+
+Measured: time per event, and, per event, the handlers run by the event loop (other than the batches)
+and the system calls done by the asio reactor to update its timer (\c timerfd_settime()) and to wait (\c epoll_wait()),
+counted by replacing these functions.
+
+Needs Boost. Build with <code>make bench</code>, and run with <code>make runbench</code>.
+
+This file is part of Spaghetti, a C++ library for implementing Finite State Machines
+
+Homepage: https://github.com/skramm/spaghetti
+*/
+
+#define SPAG_USE_ASIO_WRAPPER
+#define SPAG_EXTERNAL_EVENT_LOOP
+#include "spaghetti.hpp"
+#include "bench_common.hpp"
+
+#include <sys/epoll.h>
+#include <sys/timerfd.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+/// System calls done by the reactor, counted by the functions below
+static size_t g_nbSyscalls = 0;
+
+extern "C" int timerfd_settime( int fd, int flags, const struct itimerspec* new_value, struct itimerspec* old_value )
+{
+	g_nbSyscalls++;
+	return syscall( SYS_timerfd_settime, fd, flags, new_value, old_value );
+}
+extern "C" int epoll_wait( int epfd, struct epoll_event* events, int maxevents, int timeout )
+{
+	g_nbSyscalls++;
+	return syscall( SYS_epoll_pwait, epfd, events, maxevents, timeout, nullptr, 8 );
+}
+
+enum class States { BlinkOn, BlinkOff, NB_STATES };
+enum class Events { Toggle, NB_EVENTS };
+
+using asio_t  = spag::AsioWrapper<States,Events,int>;
+using fsm_t   = spag::SpagFSM<States,Events,asio_t>;
+
+constexpr size_t nbEvents  = 1000000;
+constexpr size_t batchSize = 100;
+
+//-----------------------------------------------------------------------------------
+void
+runCase( std::string title, bool lazy )
+{
+	boost::asio::io_context io;
+	asio_t timer( io );
+	timer.setLazyCancel( lazy );
+	fsm_t fsm;
+	fsm.assignEventHandler( &timer );
+	fsm.assignTimeOut( States::BlinkOn,  100, "ms", States::BlinkOff );
+	fsm.assignTimeOut( States::BlinkOff, 100, "ms", States::BlinkOn );
+	fsm.assignTransition( States::BlinkOn,  Events::Toggle, States::BlinkOff );
+	fsm.assignTransition( States::BlinkOff, Events::Toggle, States::BlinkOn );
+	fsm.start();                                          // not blocking, because of SPAG_EXTERNAL_EVENT_LOOP
+
+	size_t nbSent = 0;
+	std::function<void()> batch = [&]()                   // lambda
+	{
+		for( size_t i=0; i<batchSize; i++ )
+			fsm.processEvent( Events::Toggle );
+		nbSent += batchSize;
+		if( nbSent < nbEvents )
+			boost::asio::post( io, batch );
+		else
+			fsm.stop();                                   // stops the event loop
+	};
+	boost::asio::post( io, batch );
+
+	size_t nbHandlers = 0;
+	g_nbSyscalls = 0;
+	bench::printHeader( title );
+	bench::printResult( "time", bench::bestOf( 1, nbEvents, [&](){ nbHandlers = io.run(); } ) );
+	bench::printResult( "handlers run", double( nbHandlers - nbEvents / batchSize ) / nbEvents, "per event" );
+	bench::printResult( "timerfd_settime() + epoll_wait()", double( g_nbSyscalls ) / nbEvents, "per event" );
+}
+
+//-----------------------------------------------------------------------------------
+int main()
+{
+	runCase( "AsioWrapper, synchronous cancelation (default)", false );
+	runCase( "AsioWrapper, lazy cancelation",                  true );
+}
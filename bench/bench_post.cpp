@@ -0,0 +1,111 @@
+/**
+\file bench_post.cpp
+\brief Benchmark of the events sent from a callback: recursive processEvent() vs. run-to-completion postEvent()
+
+A FSM with 16 states on a ring (event 0 moves to the next state). On each state, the callback sends again event 0,
+until a chain of \c nbHops transitions has been done. The chain is either sent with processEvent() (each hop is a nested call,
+so the stack depth grows with the chain length) or with postEvent() (each hop is queued and processed after the current one).
+As reference, the same number of transitions is done by a loop calling processEvent() from outside of the callback.
+
+Also measures the cost of the queue on regular processing, by comparing the default traits with
+<code>postQueueSize = 0</code>.
+
+Build with <code>make bench</code>, and run with <code>make runbench</code>.
+
+This file is part of Spaghetti, a C++ library for implementing Finite State Machines
+
+Homepage: https://github.com/skramm/spaghetti
+*/
+
+#include "spaghetti.hpp"
+#include "bench_common.hpp"
+
+enum class States { NB_STATES = 16 };
+enum class Events { NB_EVENTS = 4 };
+
+constexpr size_t nbHops   = 2000;   ///< chain length, kept small so that the recursive version does not overflow the stack
+constexpr size_t nbChains = 500;
+constexpr size_t nbEvents = 4000000;
+constexpr size_t nbRuns   = 5;
+
+struct NoQueueTraits : spag::FsmTraits
+{
+	static constexpr size_t postQueueSize = 0;
+};
+
+using ctimer_t = bench::CountingTimer<States,Events,int>;
+
+//-----------------------------------------------------------------------------------
+template<typename TRAITS>
+void
+ringConfig( spag::SpagFSM<States,Events,ctimer_t,int,TRAITS>& fsm, ctimer_t& timer )
+{
+	fsm.assignEventHandler( &timer );
+	for( size_t s=0; s<static_cast<size_t>(States::NB_STATES); s++ )
+		fsm.assignTransition(
+			static_cast<States>(s),
+			static_cast<Events>(0),
+			static_cast<States>( (s+1) % static_cast<size_t>(States::NB_STATES) )
+		);
+}
+
+//-----------------------------------------------------------------------------------
+/// Runs \c nbChains chains of \c nbHops transitions, each hop being sent from the callback, either by \c processEvent() or \c postEvent()
+void
+runChain( std::string title, bool post )
+{
+	using fsm_t = spag::SpagFSM<States,Events,ctimer_t>;
+	auto p_fsm = std::make_unique<fsm_t>();
+	ctimer_t timer;
+	ringConfig( *p_fsm, timer );
+	size_t count = 0;
+	p_fsm->assignCallback( [&]( int )                            // lambda
+	{
+		if( count == 0 )
+			return;
+		count--;
+		if( post )
+			p_fsm->postEvent( static_cast<Events>(0) );
+		else
+			p_fsm->processEvent( static_cast<Events>(0) );
+	} );
+	p_fsm->start();
+	bench::printResult( title, bench::bestOf( nbRuns, nbHops*nbChains, [&]()
+		{
+			for( size_t i=0; i<nbChains; i++ )
+			{
+				count = nbHops - 1;
+				p_fsm->processEvent( static_cast<Events>(0) );
+			}
+		} ), "ns/hop" );
+}
+
+//-----------------------------------------------------------------------------------
+/// Same number of transitions, sent by a loop from outside of the callback
+template<typename TRAITS>
+void
+runLoop( std::string title, size_t nb )
+{
+	using fsm_t = spag::SpagFSM<States,Events,ctimer_t,int,TRAITS>;
+	auto p_fsm = std::make_unique<fsm_t>();
+	ctimer_t timer;
+	ringConfig( *p_fsm, timer );
+	size_t count = 0;
+	p_fsm->assignCallback( [&count]( int ){ count++; } );   // lambda
+	p_fsm->start();
+	std::vector<Events> v_ev( nb, static_cast<Events>(0) );
+	bench::printResult( title, bench::bestOf( nbRuns, nb, [&](){ bench::g_sink = bench::feed( *p_fsm, v_ev ); } ), "ns/hop" );
+}
+
+//-----------------------------------------------------------------------------------
+int main()
+{
+	bench::printHeader( "Chains of " + std::to_string( nbHops ) + " events sent from the callback" );
+	runLoop<spag::FsmTraits>( "external loop (reference)", nbHops*nbChains );
+	runChain( "processEvent() from callback (recursive)", false );
+	runChain( "postEvent() from callback", true );
+
+	bench::printHeader( "Cost of the queue on regular processing" );
+	runLoop<spag::FsmTraits>( "postQueueSize = 8 (default)", nbEvents );
+	runLoop<NoQueueTraits>(   "postQueueSize = 0", nbEvents );
+}
@@ -0,0 +1,132 @@
+/**
+\file bench_push.cpp
+\brief Benchmark of the thread-safe input queue (pushEvent()), with several producer threads
+
+A FSM with 16 states and 16 events, all transitions valid, receives 4 millions random events, sent by 1 to 8 producer threads.
+The main thread acts as the event loop: it calls processPushedEvents() until all the events have been processed.
+Compared with:
+ - a single thread calling processEvent() (reference, no thread-safety),
+ - producer threads calling processEvent() while holding a \c std::mutex (what has to be done without the queue).
+
+With the "drop" policy, the number of dropped events is also given.
+
+Build with <code>make bench</code>, and run with <code>make runbench</code>.
+
+This file is part of Spaghetti, a C++ library for implementing Finite State Machines
+
+Homepage: https://github.com/skramm/spaghetti
+*/
+
+#include "spaghetti.hpp"
+#include "bench_common.hpp"
+
+#include <mutex>
+
+enum class States { NB_STATES = 16 };
+enum class Events { NB_EVENTS = 16 };
+
+constexpr size_t nbEvents = 4000000;
+constexpr size_t nbRuns   = 3;
+
+template<spag::QueueFullPolicy POLICY>
+struct Traits : spag::FsmTraits
+{
+	static constexpr size_t inputQueueSize = 1024;
+	static constexpr spag::QueueFullPolicy inputQueuePolicy = POLICY;
+};
+
+using ctimer_t = bench::CountingTimer<States,Events,int>;
+
+template<typename TRAITS>
+using fsm_t = spag::SpagFSM<States,Events,ctimer_t,int,TRAITS>;
+
+//-----------------------------------------------------------------------------------
+template<typename FSM>
+std::unique_ptr<FSM>
+buildFsm( ctimer_t& timer )
+{
+	auto p_fsm = std::make_unique<FSM>();
+	p_fsm->assignEventHandler( &timer );
+	bench::randomConfig<States,Events>( *p_fsm, 1.0, 0. );
+	p_fsm->start();
+	return p_fsm;
+}
+
+//-----------------------------------------------------------------------------------
+/// Each of the \c nbThreads producers pushes its share of \c v_ev, the main thread processes them
+template<spag::QueueFullPolicy POLICY>
+void
+runQueue( std::string title, const std::vector<Events>& v_ev, size_t nbThreads )
+{
+	using fsm2_t = fsm_t<Traits<POLICY>>;
+	ctimer_t timer;
+	auto p_fsm = buildFsm<fsm2_t>( timer );
+	auto nbPerThread = v_ev.size() / nbThreads;
+
+	bench::printResult( title + ", producers=" + std::to_string( nbThreads ), bench::bestOf( nbRuns, v_ev.size(), [&]()
+		{
+			std::atomic<size_t> nbFinished{0};
+			std::vector<std::thread> v_thread;
+			for( size_t t=0; t<nbThreads; t++ )
+				v_thread.emplace_back( [&,t]()                                                  // lambda
+				{
+					for( size_t i=t*nbPerThread; i<(t+1)*nbPerThread; i++ )
+						p_fsm->pushEvent( v_ev[i] );
+					nbFinished++;
+				} );
+			while( nbFinished < nbThreads )
+				if( p_fsm->processPushedEvents() == 0 )
+					std::this_thread::yield();
+			for( auto& th: v_thread )
+				th.join();
+			bench::g_sink = p_fsm->processPushedEvents();
+		} ) );
+	if constexpr( POLICY == spag::QueueFullPolicy::Drop )
+		bench::printResult( "  dropped events", 100. * p_fsm->nbDroppedEvents() / ( nbRuns * v_ev.size() ), "%" );
+}
+
+//-----------------------------------------------------------------------------------
+/// Each of the \c nbThreads producers calls processEvent() while holding a mutex
+void
+runMutex( const std::vector<Events>& v_ev, size_t nbThreads )
+{
+	ctimer_t timer;
+	auto p_fsm = buildFsm<fsm_t<spag::FsmTraits>>( timer );
+	std::mutex mtx;
+	auto nbPerThread = v_ev.size() / nbThreads;
+
+	bench::printResult( "mutex + processEvent(), producers=" + std::to_string( nbThreads ), bench::bestOf( nbRuns, v_ev.size(), [&]()
+		{
+			std::vector<std::thread> v_thread;
+			for( size_t t=0; t<nbThreads; t++ )
+				v_thread.emplace_back( [&,t]()                                                  // lambda
+				{
+					for( size_t i=t*nbPerThread; i<(t+1)*nbPerThread; i++ )
+					{
+						std::lock_guard<std::mutex> lock( mtx );
+						p_fsm->processEvent( v_ev[i] );
+					}
+				} );
+			for( auto& th: v_thread )
+				th.join();
+		} ) );
+}
+
+//-----------------------------------------------------------------------------------
+int main()
+{
+	auto v_ev = bench::randomEvents<Events>( nbEvents );
+	bench::printHeader( "Multi-producer event ingestion, 16 states, 16 events, hardware threads: "
+		+ std::to_string( std::thread::hardware_concurrency() ) );
+	{
+		ctimer_t timer;
+		auto p_fsm = buildFsm<fsm_t<spag::FsmTraits>>( timer );
+		bench::printResult( "processEvent(), single thread", bench::bestOf( nbRuns, v_ev.size(), [&](){ bench::g_sink = bench::feed( *p_fsm, v_ev ); } ) );
+	}
+	for( size_t nbThreads: { 1, 2, 4, 8 } )
+	{
+		runMutex( v_ev, nbThreads );
+		runQueue<spag::QueueFullPolicy::Block>( "pushEvent(), block", v_ev, nbThreads );
+		runQueue<spag::QueueFullPolicy::Drop>(  "pushEvent(), drop",  v_ev, nbThreads );
+	}
+}
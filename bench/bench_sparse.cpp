@@ -0,0 +1,143 @@
+/**
+\file bench_sparse.cpp
+\brief Benchmark of the sparse transition table storage (SparseTable) vs. dense storage (SplitTable and PackedTable)
+
+Uses a FSM with 2000 states and 300 events, with a range of densities (ratio of valid cells).
+For each case, prints out the memory used by the FSM (size of object plus heap allocations) and the event processing time.
+Each state handles the same number of events, chosen randomly, and the events fed to the FSM are chosen randomly among
+the ones that are valid for the current state (else, with a low density, nearly all of them would be ignored).
+
+Build with <code>make bench</code>, and run with <code>make runbench</code>.
+
+This file is part of Spaghetti, a C++ library for implementing Finite State Machines
+
+Homepage: https://github.com/skramm/spaghetti
+*/
+
+#include "spaghetti.hpp"
+#include "bench_common.hpp"
+
+#include <new>
+#include <cstdlib>
+#include <numeric>
+
+/// Heap allocated bytes, currently in use.
+/// Relies on sized deallocation (default since C++14), used by the standard containers.
+static size_t g_allocated = 0;
+
+void* operator new( size_t n )
+{
+	g_allocated += n;
+	if( void* p = std::malloc( n ) )
+		return p;
+	throw std::bad_alloc();
+}
+void operator delete( void* p ) noexcept { std::free( p ); }
+void operator delete( void* p, size_t n ) noexcept
+{
+	g_allocated -= n;
+	std::free( p );
+}
+
+enum class States { NB_STATES = 2000 };
+enum class Events { NB_EVENTS = 300 };
+
+template<typename TAB>
+struct Traits : spag::FsmTraits
+{
+	using Table = TAB;
+};
+
+constexpr size_t nbEvents = 2000000;
+constexpr size_t nbRuns   = 5;
+
+/// A transition: event and destination state
+using Trans = std::pair<size_t,size_t>;
+
+//-----------------------------------------------------------------------------------
+/// Builds a random configuration: each state handles \c density x NB_EVENTS events (at least one), leading to random states.
+/// The first one leads to the next state, so that all the states are reachable.
+std::vector<std::vector<Trans>>
+buildConfig( double density )
+{
+	constexpr size_t nbSt = static_cast<size_t>(States::NB_STATES);
+	constexpr size_t nbEv = static_cast<size_t>(Events::NB_EVENTS);
+	std::mt19937 gen( 42 );
+	std::uniform_int_distribution<size_t> st_dist( 0, nbSt - 1 );
+	size_t nbPerState = std::max( size_t(1), static_cast<size_t>( density * nbEv ) );
+
+	std::vector<size_t> v_ev( nbEv );
+	std::iota( v_ev.begin(), v_ev.end(), 0 );
+	std::vector<std::vector<Trans>> conf( nbSt );
+	for( auto& v_trans: conf )
+	{
+		std::shuffle( v_ev.begin(), v_ev.end(), gen );
+		for( size_t i=0; i<nbPerState; i++ )
+			v_trans.push_back( Trans( v_ev[i], st_dist(gen) ) );
+		v_trans[0].second = ( &v_trans - &conf[0] + 1 ) % nbSt;
+	}
+	return conf;
+}
+
+//-----------------------------------------------------------------------------------
+/// Builds a sequence of events that are all valid: for each step, one of the events handled by the current state.
+std::vector<Events>
+validEvents( const std::vector<std::vector<Trans>>& conf, size_t nb )
+{
+	std::mt19937 gen( 123 );
+	std::vector<Events> out( nb );
+	size_t st = 0;
+	for( auto& ev: out )
+	{
+		const auto& v_trans = conf[st];
+		const auto& tr = v_trans[ std::uniform_int_distribution<size_t>( 0, v_trans.size()-1 )( gen ) ];
+		ev = static_cast<Events>( tr.first );
+		st = tr.second;
+	}
+	return out;
+}
+
+//-----------------------------------------------------------------------------------
+template<typename TRAITS>
+std::pair<size_t,double>
+runBench( const std::vector<std::vector<Trans>>& conf, const std::vector<Events>& v_ev )
+{
+	using fsm_t = spag::SpagFSM<States,Events,bench::CountingTimer<States,Events,int>,int,TRAITS>;
+	bench::CountingTimer<States,Events,int> timer;
+
+	auto alloc0 = g_allocated;
+	auto p_fsm = std::make_unique<fsm_t>();
+	p_fsm->assignEventHandler( &timer );
+	for( size_t s=0; s<conf.size(); s++ )
+		for( const auto& tr: conf[s] )
+			p_fsm->assignTransition( static_cast<States>(s), static_cast<Events>(tr.first), static_cast<States>(tr.second) );
+	auto mem = g_allocated - alloc0;
+
+	p_fsm->start();
+	auto t = bench::bestOf( nbRuns, v_ev.size(), [&](){ bench::g_sink = bench::feed( *p_fsm, v_ev ); } );
+	return std::make_pair( mem, t );
+}
+
+//-----------------------------------------------------------------------------------
+template<typename TRAITS>
+void
+runCase( std::string name, const std::vector<std::vector<Trans>>& conf, const std::vector<Events>& v_ev )
+{
+	auto res = runBench<TRAITS>( conf, v_ev );
+	bench::printResult( name + ": memory", res.first / 1024., "kB" );
+	bench::printResult( name + ": time",   res.second );
+}
+
+//-----------------------------------------------------------------------------------
+int main()
+{
+	for( auto density: { 0.01, 0.03, 0.1, 0.3, 1.0 } )
+	{
+		bench::printHeader( "2000 states, 300 events, density=" + std::to_string( density ).substr( 0, 4 ) );
+		auto conf = buildConfig( density );
+		auto v_ev = validEvents( conf, nbEvents );
+		runCase<Traits<spag::SplitTable>>(  "SplitTable ", conf, v_ev );
+		runCase<Traits<spag::PackedTable>>( "PackedTable", conf, v_ev );
+		runCase<Traits<spag::SparseTable>>( "SparseTable", conf, v_ev );
+	}
+}
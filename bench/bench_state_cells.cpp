@@ -0,0 +1,92 @@
+/**
+\file bench_state_cells.cpp
+\brief Benchmark of the storage type of states in the transition table: \c ST (wide) vs. priv::StateCell (narrow, default)
+
+Prints out the size of the FSM objects and of the per-state data, then measures the event processing time
+on a FSM whose transition table fits in L2 cache, and on one that does not when states are stored with type \c ST.
+The transitions are random, so that the accesses to the table are random too: this measures the cost of the cache misses.
+
+Build with <code>make bench</code>, and run with <code>make runbench</code>.
+
+This file is part of Spaghetti, a C++ library for implementing Finite State Machines
+
+Homepage: https://github.com/skramm/spaghetti
+*/
+
+#include "spaghetti.hpp"
+#include "bench_common.hpp"
+
+enum MediumStates { NB_STATES = 200 };
+enum MediumEvents { NB_EVENTS = 50 };
+
+enum class LargeStates { NB_STATES = 2048 };
+enum class LargeEvents { NB_EVENTS = 256 };
+
+template<typename TAB, bool NARROW>
+struct Traits : spag::FsmTraits
+{
+	using Table = TAB;
+	static constexpr bool narrowCells = NARROW;
+};
+
+constexpr size_t nbEvents = 4000000;
+constexpr size_t nbRuns   = 5;
+
+template<typename ST, typename EV, typename TRAITS>
+using fsm_t = spag::SpagFSM<ST,EV,bench::CountingTimer<ST,EV,int>,int,TRAITS>;
+
+//-----------------------------------------------------------------------------------
+template<typename ST, typename EV, typename TRAITS>
+double
+runBench( const std::vector<EV>& v_ev )
+{
+	auto p_fsm = std::make_unique<fsm_t<ST,EV,TRAITS>>();
+	bench::CountingTimer<ST,EV,int> timer;
+	p_fsm->assignEventHandler( &timer );
+	bench::randomConfig<ST,EV>( *p_fsm, 1.0 );
+	p_fsm->start();
+
+	return bench::bestOf( nbRuns, v_ev.size(), [&](){ bench::g_sink = bench::feed( *p_fsm, v_ev ); } );
+}
+
+//-----------------------------------------------------------------------------------
+template<typename ST, typename EV, typename TAB>
+void
+runCase( std::string title )
+{
+	auto v_ev = bench::randomEvents<EV>( nbEvents );
+	bench::printResult( title + ", ST",        runBench<ST,EV,Traits<TAB,false>>( v_ev ) );
+	bench::printResult( title + ", StateCell", runBench<ST,EV,Traits<TAB,true>>( v_ev ) );
+}
+
+//-----------------------------------------------------------------------------------
+template<typename ST, typename EV>
+void
+printSizes()
+{
+	bench::printHeader( "Sizes, "
+		+ std::to_string( static_cast<size_t>(ST::NB_STATES) ) + " states, "
+		+ std::to_string( static_cast<size_t>(EV::NB_EVENTS) ) + " events" );
+	bench::printSize( "state type ST",                   sizeof(ST) );
+	bench::printSize( "priv::StateCell<ST>",             sizeof(spag::priv::StateCell<ST>) );
+	bench::printSize( "priv::TimerEvent<ST>",            sizeof(spag::priv::TimerEvent<ST>) );
+	bench::printSize( "SpagFSM, SplitTable, ST",         sizeof(fsm_t<ST,EV,Traits<spag::SplitTable,false>>) );
+	bench::printSize( "SpagFSM, SplitTable, StateCell",  sizeof(fsm_t<ST,EV,Traits<spag::SplitTable,true>>) );
+	bench::printSize( "SpagFSM, PackedTable, ST",        sizeof(fsm_t<ST,EV,Traits<spag::PackedTable,false>>) );
+	bench::printSize( "SpagFSM, PackedTable, StateCell", sizeof(fsm_t<ST,EV,Traits<spag::PackedTable,true>>) );
+}
+
+//-----------------------------------------------------------------------------------
+int main()
+{
+	printSizes<MediumStates,MediumEvents>();
+	printSizes<LargeStates,LargeEvents>();
+
+	bench::printHeader( "Processing time, 200 states x 50 events" );
+	runCase<MediumStates,MediumEvents,spag::SplitTable>(  "SplitTable" );
+	runCase<MediumStates,MediumEvents,spag::PackedTable>( "PackedTable" );
+
+	bench::printHeader( "Processing time, 2048 states x 256 events" );
+	runCase<LargeStates,LargeEvents,spag::SplitTable>(  "SplitTable" );
+	runCase<LargeStates,LargeEvents,spag::PackedTable>( "PackedTable" );
+}
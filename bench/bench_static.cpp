@@ -0,0 +1,102 @@
+/**
+\file bench_static.cpp
+\brief Benchmark of StaticSpagFSM (compile-time table) vs. SpagFSM (run-time configuration)
+
+Both FSM get the same configuration: all the (state,event) cells are valid and lead to a pseudo-random state,
+(event 0 leads to the next state, so that all the states are reachable), and 1 state over 4 has a timeout.
+For StaticSpagFSM, the rows of the table are generated with a \c std::index_sequence.
+Measures the event processing time (4 millions random events) and the construction time (including the configuration, for SpagFSM).
+
+Build with <code>make bench</code>, and run with <code>make runbench</code>.
+
+This file is part of Spaghetti, a C++ library for implementing Finite State Machines
+
+Homepage: https://github.com/skramm/spaghetti
+*/
+
+#include "spaghetti.hpp"
+#include "bench_common.hpp"
+
+enum class SmallStates { NB_STATES = 8 };
+enum class SmallEvents { NB_EVENTS = 8 };
+
+enum class LargeStates { NB_STATES = 64 };
+enum class LargeEvents { NB_EVENTS = 32 };
+
+constexpr size_t nbEvents = 4000000;
+constexpr size_t nbRuns   = 5;
+constexpr size_t nbBuild  = 1000;
+
+//-----------------------------------------------------------------------------------
+/// Destination of the transition of cell \c i (event \c i/nbSt, state \c i%nbSt)
+constexpr size_t nextState( size_t i, size_t nbSt )
+{
+	return i < nbSt ? ( i + 1 ) % nbSt : ( i * 2654435761u >> 7 ) % nbSt;
+}
+
+template<typename ST, typename EV, size_t... I>
+auto
+makeRows( std::index_sequence<I...> ) -> spag::table<
+	spag::row<
+		static_cast<ST>( I % SPAG_P_CAST2IDX(ST::NB_STATES) ),
+		static_cast<EV>( I / SPAG_P_CAST2IDX(ST::NB_STATES) ),
+		static_cast<ST>( nextState( I, SPAG_P_CAST2IDX(ST::NB_STATES) ) )
+	>...,
+	spag::timeout<static_cast<ST>(0), 100, spag::DurUnit::ms, static_cast<ST>(1)>,
+	spag::timeout<static_cast<ST>(4), 100, spag::DurUnit::ms, static_cast<ST>(1)>
+>;
+
+template<typename ST, typename EV>
+using Table_t = decltype( makeRows<ST,EV>( std::make_index_sequence<SPAG_P_CAST2IDX(ST::NB_STATES)*SPAG_P_CAST2IDX(EV::NB_EVENTS)>() ) );
+
+/// Same configuration, at run-time
+template<typename ST, typename EV, typename FSM>
+void
+configure( FSM& fsm )
+{
+	constexpr size_t nbSt = SPAG_P_CAST2IDX(ST::NB_STATES);
+	for( size_t i=0; i<nbSt*SPAG_P_CAST2IDX(EV::NB_EVENTS); i++ )
+		fsm.assignTransition( static_cast<ST>( i % nbSt ), static_cast<EV>( i / nbSt ), static_cast<ST>( nextState( i, nbSt ) ) );
+	fsm.assignTimeOut( static_cast<ST>(0), 100, spag::DurUnit::ms, static_cast<ST>(1) );
+	fsm.assignTimeOut( static_cast<ST>(4), 100, spag::DurUnit::ms, static_cast<ST>(1) );
+}
+
+//-----------------------------------------------------------------------------------
+template<typename ST, typename EV>
+void
+runCase( std::string title )
+{
+	using timer_t   = bench::CountingTimer<ST,EV,int>;
+	using dynamic_t = spag::SpagFSM<ST,EV,timer_t,int>;
+	using static_t  = spag::StaticSpagFSM<ST,EV,Table_t<ST,EV>,timer_t,int>;
+
+	bench::printHeader( title );
+	auto v_ev = bench::randomEvents<EV>( nbEvents );
+	timer_t timer;
+	{
+		auto p_fsm = std::make_unique<dynamic_t>();
+		p_fsm->assignEventHandler( &timer );
+		configure<ST,EV>( *p_fsm );
+		p_fsm->start();
+		bench::printResult( "SpagFSM", bench::bestOf( nbRuns, v_ev.size(), [&](){ bench::g_sink = bench::feed( *p_fsm, v_ev ); } ) );
+	}
+	{
+		auto p_fsm = std::make_unique<static_t>();
+		p_fsm->assignEventHandler( &timer );
+		p_fsm->start();
+		bench::printResult( "StaticSpagFSM", bench::bestOf( nbRuns, v_ev.size(), [&](){ bench::g_sink = bench::feed( *p_fsm, v_ev ); } ) );
+	}
+	bench::printResult( "SpagFSM, construction and configuration", bench::bestOf( nbRuns, nbBuild,
+		[&](){ for( size_t i=0; i<nbBuild; i++ ) { auto p = std::make_unique<dynamic_t>(); configure<ST,EV>( *p ); bench::g_sink = p->nbStates(); } } ), "ns" );
+	bench::printResult( "StaticSpagFSM, construction", bench::bestOf( nbRuns, nbBuild,
+		[&](){ for( size_t i=0; i<nbBuild; i++ ) { auto p = std::make_unique<static_t>(); bench::g_sink = p->nbStates(); } } ), "ns" );
+	bench::printSize( "sizeof( SpagFSM )",       sizeof( dynamic_t ) );
+	bench::printSize( "sizeof( StaticSpagFSM )", sizeof( static_t ) );
+}
+
+//-----------------------------------------------------------------------------------
+int main()
+{
+	runCase<SmallStates,SmallEvents>( "Small FSM: 8 states, 8 events" );
+	runCase<LargeStates,LargeEvents>( "Large FSM: 64 states, 32 events" );
+}
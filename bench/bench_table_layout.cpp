@@ -0,0 +1,82 @@
+/**
+\file bench_table_layout.cpp
+\brief A/B benchmark of the transition table storage policies: SplitTable (historical layout) vs. PackedTable
+
+Both FSM are given the same random configuration and are fed the same random event sequence,
+on a small FSM (fits in L1 cache) and on a large one (does not fit in L2 cache).
+Each case is run with half of the cells valid, and with all of the cells valid.
+
+Build with <code>make bench</code>, and run with <code>make runbench</code>.
+Also built with symbol \c SPAG_USE_VECTOR as \c bench_table_layout_vec, to compare with the \c std::vector storage.
+
+This file is part of Spaghetti, a C++ library for implementing Finite State Machines
+
+Homepage: https://github.com/skramm/spaghetti
+*/
+
+#include "spaghetti.hpp"
+#include "bench_common.hpp"
+
+enum SmallStates { NB_STATES = 8 };
+enum SmallEvents { NB_EVENTS = 8 };
+
+enum class LargeStates { NB_STATES = 1024 };
+enum class LargeEvents { NB_EVENTS = 256 };
+
+struct PackedTraits : spag::FsmTraits
+{
+	using Table = spag::PackedTable;
+};
+
+constexpr size_t nbEvents = 4000000;
+constexpr size_t nbRuns   = 5;
+
+//-----------------------------------------------------------------------------------
+template<typename ST, typename EV, typename TRAITS>
+double
+runBench( const std::vector<EV>& v_ev, double density )
+{
+	using fsm_t = spag::SpagFSM<ST,EV,bench::CountingTimer<ST,EV,int>,int,TRAITS>;
+	auto p_fsm = std::make_unique<fsm_t>();     // heap allocated, to avoid stack overflow with large FSM
+	bench::CountingTimer<ST,EV,int> timer;
+	p_fsm->assignEventHandler( &timer );
+	bench::randomConfig<ST,EV>( *p_fsm, density );
+	p_fsm->start();
+
+	return bench::bestOf( nbRuns, v_ev.size(), [&](){ bench::g_sink = bench::feed( *p_fsm, v_ev ); } );
+}
+
+//-----------------------------------------------------------------------------------
+template<typename ST, typename EV>
+void
+runCase( std::string title )
+{
+	using fsm_split_t  = spag::SpagFSM<ST,EV,bench::CountingTimer<ST,EV,int>,int>;
+	using fsm_packed_t = spag::SpagFSM<ST,EV,bench::CountingTimer<ST,EV,int>,int,PackedTraits>;
+
+	bench::printHeader( title
+		+ ": " + std::to_string( static_cast<size_t>(ST::NB_STATES) ) + " states, "
+		+ std::to_string( static_cast<size_t>(EV::NB_EVENTS) ) + " events"
+		+ ", sizeof: split=" + std::to_string( sizeof(fsm_split_t) )
+		+ " packed=" + std::to_string( sizeof(fsm_packed_t) )
+	);
+	auto v_ev = bench::randomEvents<EV>( nbEvents );
+	for( auto density: { 0.5, 1.0 } )
+	{
+		auto d = " (density=" + std::to_string( density ).substr( 0, 3 ) + ")";
+		bench::printResult( "SplitTable"  + d, runBench<ST,EV,spag::FsmTraits>( v_ev, density ) );
+		bench::printResult( "PackedTable" + d, runBench<ST,EV,PackedTraits>( v_ev, density ) );
+	}
+}
+
+//-----------------------------------------------------------------------------------
+int main()
+{
+#ifdef SPAG_USE_ARRAY
+	std::cout << "Storage: std::array\n";
+#else
+	std::cout << "Storage: std::vector\n";
+#endif
+	runCase<SmallStates,SmallEvents>( "Small FSM" );
+	runCase<LargeStates,LargeEvents>( "Large FSM" );
+}
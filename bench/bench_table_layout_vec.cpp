@@ -0,0 +1,11 @@
+/**
+\file bench_table_layout_vec.cpp
+\brief Same as bench_table_layout.cpp, but with the \c std::vector storage (symbol \c SPAG_USE_VECTOR)
+
+This file is part of Spaghetti, a C++ library for implementing Finite State Machines
+
+Homepage: https://github.com/skramm/spaghetti
+*/
+
+#define SPAG_USE_VECTOR
+#include "bench_table_layout.cpp"
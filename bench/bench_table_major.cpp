@@ -0,0 +1,66 @@
+/**
+\file bench_table_major.cpp
+\brief Benchmark of the transition table memory layouts: event-major (default) vs. state-major
+
+Two workloads are used:
+ - "hot states": the FSM only switches between 4 states, and receives all the events, uniformly distributed.
+ - "uniform": random transitions, so all the states are visited.
+
+Build with <code>make bench</code>, and run with <code>make runbench</code>.
+
+This file is part of Spaghetti, a C++ library for implementing Finite State Machines
+
+Homepage: https://github.com/skramm/spaghetti
+*/
+
+#include "spaghetti.hpp"
+#include "bench_common.hpp"
+
+enum class States { NB_STATES = 512 };
+enum class Events { NB_EVENTS = 128 };
+
+template<typename TAB, spag::TableLayout LAYOUT>
+struct Traits : spag::FsmTraits
+{
+	using Table = TAB;
+	static constexpr spag::TableLayout layout = LAYOUT;
+};
+
+constexpr size_t nbEvents = 4000000;
+constexpr size_t nbRuns   = 5;
+constexpr size_t nbHot    = 4;
+
+//-----------------------------------------------------------------------------------
+template<typename TRAITS>
+double
+runBench( const std::vector<Events>& v_ev, bool hot )
+{
+	using fsm_t = spag::SpagFSM<States,Events,bench::CountingTimer<States,Events,int>,int,TRAITS>;
+	auto p_fsm = std::make_unique<fsm_t>();
+	bench::CountingTimer<States,Events,int> timer;
+	p_fsm->assignEventHandler( &timer );
+	if( hot )
+		bench::hotStatesConfig<States,Events>( *p_fsm, nbHot );
+	else
+		bench::randomConfig<States,Events>( *p_fsm, 1.0, 0. );
+	p_fsm->start();
+
+	return bench::bestOf( nbRuns, v_ev.size(), [&](){ bench::g_sink = bench::feed( *p_fsm, v_ev ); } );
+}
+
+//-----------------------------------------------------------------------------------
+int main()
+{
+	using spag::TableLayout;
+	auto v_ev = bench::randomEvents<Events>( nbEvents );
+	for( bool hot: { true, false } )
+	{
+		bench::printHeader( std::string( hot ? "Hot states" : "Uniform" )
+			+ ", " + std::to_string( static_cast<size_t>(States::NB_STATES) ) + " states, "
+			+ std::to_string( static_cast<size_t>(Events::NB_EVENTS) ) + " events" );
+		bench::printResult( "SplitTable, event-major",  runBench<Traits<spag::SplitTable, TableLayout::EventMajor>>( v_ev, hot ) );
+		bench::printResult( "SplitTable, state-major",  runBench<Traits<spag::SplitTable, TableLayout::StateMajor>>( v_ev, hot ) );
+		bench::printResult( "PackedTable, event-major", runBench<Traits<spag::PackedTable,TableLayout::EventMajor>>( v_ev, hot ) );
+		bench::printResult( "PackedTable, state-major", runBench<Traits<spag::PackedTable,TableLayout::StateMajor>>( v_ev, hot ) );
+	}
+}
@@ -0,0 +1,80 @@
+/**
+\file bench_traits.cpp
+\brief Benchmark of the cost of the optional features, selected per FSM type with FsmTraits
+
+Built with the symbols \c SPAG_ENABLE_LOGGING, \c SPAG_ENUM_STRINGS and \c SPAG_USE_SIGNALS defined,
+so that the default FsmTraits enable all the features. In the same program, three FSM types are compared:
+ - default traits: logging, enum strings and inner events,
+ - same, without logging,
+ - minimal traits: no logging, no enum strings, no inner events.
+
+All get the same random configuration (64 states, 32 events, half of the cells valid, 1 state over 5 has a timeout).
+Measures the object size, the construction time, and the event processing time. As logging writes every transition
+to a file, that FSM is fed with less events.
+
+Build with <code>make bench</code>, and run with <code>make runbench</code>.
+
+This file is part of Spaghetti, a C++ library for implementing Finite State Machines
+
+Homepage: https://github.com/skramm/spaghetti
+*/
+
+#define SPAG_ENABLE_LOGGING
+#define SPAG_ENUM_STRINGS
+#define SPAG_USE_SIGNALS
+#include "spaghetti.hpp"
+#include "bench_common.hpp"
+
+#include <cstdio>
+
+enum class States { NB_STATES = 64 };
+enum class Events { NB_EVENTS = 32 };
+
+constexpr size_t nbRuns  = 5;
+constexpr size_t nbBuild = 1000;
+
+struct NoLogTraits : spag::FsmTraits
+{
+	static constexpr bool logging = false;
+};
+
+struct MinimalTraits : spag::FsmTraits
+{
+	static constexpr bool logging     = false;
+	static constexpr bool enumStrings = false;
+	static constexpr bool innerEvents = false;
+};
+
+using ctimer_t = bench::CountingTimer<States,Events,int>;
+
+//-----------------------------------------------------------------------------------
+template<typename TRAITS>
+void
+runCase( std::string title, size_t nbEvents )
+{
+	using fsm_t = spag::SpagFSM<States,Events,ctimer_t,int,TRAITS>;
+	bench::printHeader( title );
+	bench::printSize( "sizeof", sizeof(fsm_t) );
+
+	auto p_fsm = std::make_unique<fsm_t>();
+	ctimer_t timer;
+	p_fsm->assignEventHandler( &timer );
+	p_fsm->setLogFileName( "bench_traits.csv" );
+	bench::randomConfig<States,Events>( *p_fsm, 0.5 );
+	p_fsm->start();
+
+	auto v_ev = bench::randomEvents<Events>( nbEvents );
+	bench::printResult( "processEvent()", bench::bestOf( nbRuns, v_ev.size(),
+		[&](){ bench::g_sink = bench::feed( *p_fsm, v_ev ); } ) );
+	bench::printResult( "construction", bench::bestOf( nbRuns, nbBuild,
+		[&](){ for( size_t i=0; i<nbBuild; i++ ) { auto p = std::make_unique<fsm_t>(); bench::g_sink = p->nbStates(); } } ), "ns" );
+}
+
+//-----------------------------------------------------------------------------------
+int main()
+{
+	runCase<spag::FsmTraits>( "Default traits: logging, enum strings, inner events", 200000 );
+	runCase<NoLogTraits>(     "Enum strings, inner events, no logging", 4000000 );
+	runCase<MinimalTraits>(   "Minimal traits: no logging, no enum strings, no inner events", 4000000 );
+	std::remove( "bench_traits.csv" );
+}
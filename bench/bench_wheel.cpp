@@ -0,0 +1,120 @@
+/**
+\file bench_wheel.cpp
+\brief Benchmark of 100k concurrent FSM with timeouts: one asio timer per FSM (AsioWrapper) vs. a shared timing wheel (WheelTimer)
+
+100000 FsmInstance objects share a configuration similar to the \c BlinkOn / \c BlinkOff pair of the traffic lights samples:
+two states switching on a 200 ms timeout, and an event that switches right away (thus cancels the timer and starts it again).
+All the FSM run in the same \c io_context, their timers being either:
+ - one \c AsioWrapper per FSM, each holding a \c basic_waitable_timer,
+ - one WheelTimer per FSM, all in a TimingWheel (1 ms ticks) driven by a single AsioWheelDriver.
+
+Measured:
+ - the size of the timer object of each FSM,
+ - the time to start the 100k FSM (each one starts a timer),
+ - the time to process 1 million events sent to random FSM (each one cancels and restarts a timer),
+ - the CPU time used per timeout, while the event loop runs for 2 s.
+
+Needs Boost. Build with <code>make bench</code>, and run with <code>make runbench</code>.
+
+This file is part of Spaghetti, a C++ library for implementing Finite State Machines
+
+Homepage: https://github.com/skramm/spaghetti
+*/
+
+#define SPAG_USE_ASIO_WRAPPER
+#define SPAG_EXTERNAL_EVENT_LOOP
+#include "spaghetti.hpp"
+#include "bench_common.hpp"
+
+#include <deque>
+#include <ctime>
+
+enum class States { BlinkOn, BlinkOff, NB_STATES };
+enum class Events { Toggle, NB_EVENTS };
+
+constexpr size_t nbFsm      = 100000;
+constexpr size_t nbEvents   = 1000000;
+constexpr int    durationMs = 200;
+constexpr int    runTimeMs  = 2000;
+
+size_t g_nbTimeOuts = 0;
+
+//-----------------------------------------------------------------------------------
+/// Runs the 100k FSM, each one with a timer object built by \c makeTimer
+template<typename TIM, typename F>
+void
+runCase( std::string title, boost::asio::io_context& io, F makeTimer )
+{
+	using fsm_t  = spag::SpagFSM<States,Events,TIM>;
+	using inst_t = spag::FsmInstance<fsm_t>;
+
+	bench::printHeader( title );
+	bench::printSize( "timer object, per FSM", sizeof(TIM) );
+
+	auto p_fsm = std::make_shared<fsm_t>();
+	p_fsm->assignTimeOut( States::BlinkOn,  durationMs, "ms", States::BlinkOff );
+	p_fsm->assignTimeOut( States::BlinkOff, durationMs, "ms", States::BlinkOn );
+	p_fsm->assignTransition( States::BlinkOn,  Events::Toggle, States::BlinkOff );
+	p_fsm->assignTransition( States::BlinkOff, Events::Toggle, States::BlinkOn );
+	p_fsm->assignCallback( []( int ){ g_nbTimeOuts++; } );   // lambda
+	spag::FsmConfig<fsm_t> config( p_fsm );
+
+	std::deque<TIM>     v_timer;                          // not movable
+	std::vector<inst_t> v_fsm( nbFsm, inst_t( config ) );
+	for( auto& fsm: v_fsm )
+	{
+		makeTimer( v_timer );
+		fsm.assignEventHandler( &v_timer.back() );
+	}
+
+	bench::printResult( "start (starts a timer)", bench::bestOf( 1, nbFsm, [&]()
+		{
+			for( auto& fsm: v_fsm )
+				fsm.start();
+		} ), "ns/FSM" );
+
+	std::mt19937 gen( 42 );
+	std::uniform_int_distribution<size_t> dist( 0, nbFsm - 1 );
+	std::vector<size_t> v_idx( nbEvents );
+	for( auto& idx: v_idx )
+		idx = dist( gen );
+	bench::printResult( "event (cancels and starts a timer)", bench::bestOf( 1, nbEvents, [&]()
+		{
+			for( auto idx: v_idx )
+				v_fsm[idx].processEvent( Events::Toggle );
+		} ) );
+
+	boost::asio::steady_timer stopTimer( io, std::chrono::milliseconds( runTimeMs ) );
+	stopTimer.async_wait( [&io]( const boost::system::error_code& ){ io.stop(); } );   // lambda
+	g_nbTimeOuts = 0;
+	auto cpu0 = std::clock();
+	io.run();
+	auto cpu = double( std::clock() - cpu0 ) / CLOCKS_PER_SEC;
+	bench::printResult( "timeouts processed", g_nbTimeOuts / ( runTimeMs / 1000. ) / 1000., "k/s" );
+	bench::printResult( "CPU time per timeout", cpu * 1E9 / g_nbTimeOuts, "ns" );
+	io.restart();
+
+	for( auto& fsm: v_fsm )
+		fsm.stop();
+}
+
+//-----------------------------------------------------------------------------------
+int main()
+{
+	{
+		boost::asio::io_context io;
+		runCase<spag::AsioWrapper<States,Events,int>>( "100k FSM, one asio timer each (AsioWrapper)", io,
+			[&io]( auto& v_timer ){ v_timer.emplace_back( io ); }   // lambda
+		);
+	}
+	{
+		boost::asio::io_context io;
+		spag::TimingWheel wheel;
+		spag::AsioWheelDriver driver( io, wheel );
+		driver.start();
+		runCase<spag::WheelTimer<States,Events,int>>( "100k FSM, shared timing wheel (WheelTimer), 1 ms ticks", io,
+			[&wheel]( auto& v_timer ){ v_timer.emplace_back( wheel ); }   // lambda
+		);
+		driver.stop();
+	}
+}
@@ -33,29 +33,39 @@ DEALINGS IN THE SOFTWARE.
 #ifndef HG_SPAGHETTI_FSM_HPP
 #define HG_SPAGHETTI_FSM_HPP
 
-/// At present, data is stored into arrays if this is defined. \todo Need performance evaluation of this build option.
-/// If not defined, it defaults to std::vector
-#define SPAG_USE_ARRAY
+/// At present, data is stored into arrays if this is defined, unless symbol \c SPAG_USE_VECTOR is defined.
+/// If not defined, it defaults to std::vector.
+/**
+Performance evaluation of this build option and of the transition table layouts (see \ref FsmTraits)
+is available in docs/spaghetti_benchmarks.md, and can be reproduced with <code>make runbench</code>.
+Summary: arrays and vectors perform alike on small FSM, arrays avoid one indirection on large ones.
+*/
+#ifndef SPAG_USE_VECTOR
+	#define SPAG_USE_ARRAY
+#endif
 
 #define SPAG_VERSION "0.9.6"
 
 #include <vector>
 #include <array>
 #include <map>
+#include <bitset>
 #include <algorithm>
 #include <functional>
 #include <cassert>
 #include <iomanip>
+#include <limits>
+#include <sstream>
+#include <cstdint>
+#include <type_traits>
+#include <chrono>
+#include <memory>
 #include <fstream>
 #include <iostream> // needed for expansion of SPAG_LOG
+#include <atomic>
+#include <thread>
 
 
-#if defined (SPAG_USE_SIGNALS)
-	#ifndef SPAG_SIGNAL
-		#define SPAG_SIGNAL SIGUSR1
-	#endif
-#endif
-
 #if defined (SPAG_EMBED_ASIO_WRAPPER)
 	#define SPAG_USE_ASIO_WRAPPER
 #endif
@@ -66,8 +76,14 @@ DEALINGS IN THE SOFTWARE.
 	#include <boost/asio.hpp>
 #endif
 
-#if defined (SPAG_USE_ASIO_WRAPPER) || defined (SPAG_ENABLE_LOGGING)
-	#include <chrono>
+#if defined (SPAG_USE_EPOLL_WRAPPER)
+	#include <sys/epoll.h>
+	#include <sys/timerfd.h>
+	#include <sys/eventfd.h>
+	#include <unistd.h>
+	#include <cerrno>
+	#include <cstring>
+	#include <mutex>
 #endif
 
 #ifdef SPAG_PRINT_STATES
@@ -182,6 +198,43 @@ int g_indent;
 /// Private macro, used to convert a 'state' type into an integer
 #define SPAG_P_CAST2IDX( a ) static_cast<size_t>(a)
 
+// Private macros, default values of the FsmTraits options that can also be selected with a build symbol
+#ifdef SPAG_ENABLE_LOGGING
+	#define SPAG_P_DEFAULT_LOGGING true
+#else
+	#define SPAG_P_DEFAULT_LOGGING false
+#endif
+#ifdef SPAG_ENUM_STRINGS
+	#define SPAG_P_DEFAULT_ENUM_STRINGS true
+#else
+	#define SPAG_P_DEFAULT_ENUM_STRINGS false
+#endif
+#ifdef SPAG_USE_SIGNALS
+	#define SPAG_P_DEFAULT_INNER_EVENTS true
+#else
+	#define SPAG_P_DEFAULT_INNER_EVENTS false
+#endif
+
+/// Attribute of the data members that are empty when an option is disabled, so that they take no room in the FSM object.
+/**
+\c [[no_unique_address]] is C++20: in C++17, it is only used if the compiler provides it (GCC and Clang do),
+and MSVC has its own one. Else, each empty member takes one byte (plus padding).
+Can be defined by the user before including this file.
+*/
+#ifndef SPAG_NO_UNIQUE_ADDRESS
+	#if defined(_MSC_VER)
+		#define SPAG_NO_UNIQUE_ADDRESS [[msvc::no_unique_address]]
+	#elif defined(__has_cpp_attribute)
+		#if __has_cpp_attribute(no_unique_address)
+			#define SPAG_NO_UNIQUE_ADDRESS [[no_unique_address]]
+		#else
+			#define SPAG_NO_UNIQUE_ADDRESS
+		#endif
+	#else
+		#define SPAG_NO_UNIQUE_ADDRESS
+	#endif
+#endif
+
 
 
 /// Main library namespace
@@ -199,8 +252,192 @@ enum Item : uint8_t
 	,ItemIgnoredEvents = 0x04
 };
 
-/// Timer units
-enum class DurUnit : uint8_t { ms, sec, min };
+/// Timer units (the sub-millisecond units have been added last, so that the values of the others do not change)
+enum class DurUnit : uint8_t { ms, sec, min, us, ns };
+
+//------------------------------------------------------------------------------------
+/// Memory layout of the transition table (see FsmTraits)
+enum class TableLayout : uint8_t
+{
+	EventMajor  ///< stored as <code>[event][state]</code>: all the transitions triggered by a given event are contiguous
+	,StateMajor ///< stored as <code>[state][event]</code>: all the outgoing transitions of a given state are contiguous
+};
+
+/// What SpagFSM::pushEvent() does when the input queue is full (see FsmTraits::inputQueuePolicy)
+enum class QueueFullPolicy : uint8_t
+{
+	Drop   ///< the event is dropped, and pushEvent() returns false
+	,Block ///< pushEvent() waits until the thread running the event loop has made some room
+};
+
+/// Transition table storage policy (see FsmTraits): the transitions and the allowed events flags are stored in two separate tables.
+/// This is the historical layout.
+struct SplitTable
+{
+	static constexpr bool packed = false;
+};
+
+/// Transition table storage policy (see FsmTraits): each cell holds the next state, the allowed/inner flag,
+/// and a "source state has a timeout" flag, so that SpagFSM::processEvent() needs a single load to take its decision.
+struct PackedTable
+{
+	static constexpr bool packed = true;
+};
+
+/// Transition table storage policy (see FsmTraits), for large and sparse FSM: each state holds a sorted list of
+/// the events it handles, so memory is proportional to the number of valid cells.
+/// Lookup is a binary search in that list. The memory layout (FsmTraits::layout) is not relevant here.
+struct SparseTable
+{
+	static constexpr bool packed = true; // provides cell(), so processEvent() needs a single lookup
+};
+
+//------------------------------------------------------------------------------------
+/// Non-owning reference to a callable object, see FunctionRefCallback
+/**
+Two pointers, no heap allocation, and a single indirect call. The referenced object  must outlive the FSM.
+Can be built from a function pointer or from a callable lvalue (lambda, functor), but not from a temporary:
+for a non-capturing lambda, use the unary plus to convert it to a function pointer: <code>+[](int){...}</code>
+*/
+template<typename SIG>
+class FunctionRef;
+
+template<typename R, typename... ARGS>
+class FunctionRef<R(ARGS...)>
+{
+	public:
+		FunctionRef() = default;
+		FunctionRef( R (*func)(ARGS...) )
+			: _func( func )
+			, _call( func ? &callFunc : nullptr )
+		{}
+		template<
+			typename F,
+			typename = std::enable_if_t<!std::is_same<std::decay_t<F>,FunctionRef>::value>
+		>
+		FunctionRef( F& obj )
+			: _obj( &obj )
+			, _call( &callObj<F> )
+		{}
+		template<
+			typename F,
+			typename = std::enable_if_t<!std::is_same<std::decay_t<F>,FunctionRef>::value>
+		>
+		FunctionRef( F&& ) = delete;  // would be dangling
+		FunctionRef( const FunctionRef& ) = default;
+		FunctionRef& operator = ( const FunctionRef& ) = default;
+
+		explicit operator bool() const { return _call != nullptr; }
+
+		R operator()( ARGS... args ) const
+		{
+			return _call( *this, std::forward<ARGS>(args)... );
+		}
+
+	private:
+		static R callFunc( const FunctionRef& fr, ARGS... args )
+		{
+			return fr._func( std::forward<ARGS>(args)... );
+		}
+		template<typename F>
+		static R callObj( const FunctionRef& fr, ARGS... args )
+		{
+			return (*static_cast<F*>( fr._obj ))( std::forward<ARGS>(args)... );
+		}
+
+		union
+		{
+			void* _obj = nullptr;
+			R (*_func)(ARGS...);
+		};
+		R (*_call)( const FunctionRef&, ARGS... ) = nullptr;
+};
+
+/// A plain function pointer with its context pointer, see FnPtrCallback.
+/// The function is called as <code>func( context, arg )</code>
+template<typename CBA>
+struct FnWithContext
+{
+	void (*_func)( void*, CBA ) = nullptr;
+	void* _context = nullptr;
+
+	FnWithContext() = default;
+	FnWithContext( void (*func)( void*, CBA ), void* context=nullptr )
+		: _func( func ), _context( context )
+	{}
+	explicit operator bool() const { return _func != nullptr; }
+	void operator()( CBA arg ) const { _func( _context, arg ); }
+};
+
+namespace priv {
+/// Per-state callback slot of HandlerCallback: nothing, the handler is shared by all the states
+	struct NoCallback
+	{
+		explicit operator bool() const { return false; }
+	};
+}
+
+/// Callback policy (see FsmTraits): each state holds a \c std::function<void(CBA)>.
+/// This is the historical behavior: any callable can be assigned, including capturing lambdas and \c std::bind expressions,
+/// but calls are type-erased, and assigning a large callable allocates.
+struct StdFunctionCallback
+{
+	template<typename ARG>
+	using Slot = std::function<void(ARG)>;
+};
+
+/// Callback policy (see FsmTraits): each state holds a plain function pointer and a \c void* context, see FnWithContext
+struct FnPtrCallback
+{
+	template<typename ARG>
+	using Slot = FnWithContext<ARG>;
+};
+
+/// Callback policy (see FsmTraits): each state holds a non-owning reference to a callable, see FunctionRef
+struct FunctionRefCallback
+{
+	template<typename ARG>
+	using Slot = FunctionRef<void(ARG)>;
+};
+
+/// Callback policy (see FsmTraits): a single handler object of type \c H, called as <code>handler( state, arg )</code>
+/// on every state entry, with the argument assigned to that state. As its type is known, the call can be inlined.
+/// The handler is assigned with SpagFSM::assignCallbackHandler(), and the per-state values with SpagFSM::assignCallbackValue().
+template<typename H>
+struct HandlerCallback
+{
+	using Handler = H;
+	template<typename ARG>
+	using Slot = priv::NoCallback;
+};
+
+//------------------------------------------------------------------------------------
+/// Default traits of SpagFSM (last template parameter).
+/**
+To change some of these, derive your own struct from this one and override the needed members, for example:
+\code
+struct MyTraits : spag::FsmTraits
+{
+	using Table = spag::PackedTable;
+};
+using fsm_t = spag::SpagFSM<States,Events,spag::priv::NoTimer<States,Events,int>,int,MyTraits>;
+\endcode
+*/
+struct FsmTraits
+{
+	using Table = SplitTable;                                    ///< Transition table storage policy: SplitTable, PackedTable or SparseTable
+	static constexpr TableLayout layout = TableLayout::EventMajor; ///< Transition table memory layout
+	static constexpr bool narrowCells = true;                      ///< if true, states are stored in the transition table with the smallest possible unsigned type, see priv::StateCell
+	using Callback = StdFunctionCallback;                          ///< Callback policy: StdFunctionCallback, FnPtrCallback, FunctionRefCallback or HandlerCallback
+	static constexpr bool callbackArgByRef = false;                ///< if true, the callback functions take their argument as <code>const CBA&</code> instead of \c CBA (no copy)
+	static constexpr bool logging     = SPAG_P_DEFAULT_LOGGING;      ///< run-time logging (counters and log file), default is true if \ref SPAG_ENABLE_LOGGING is defined
+	static constexpr bool enumStrings = SPAG_P_DEFAULT_ENUM_STRINGS; ///< enum-string mapping, default is true if \ref SPAG_ENUM_STRINGS is defined
+	static constexpr bool innerEvents = SPAG_P_DEFAULT_INNER_EVENTS; ///< inner events and pass states, default is true if \ref SPAG_USE_SIGNALS is defined
+	static constexpr bool collapseAAT = false;                     ///< if true, once finalized, the chains of pass states are crossed right away, without deferred processing (requires \c innerEvents)
+	static constexpr size_t postQueueSize = 8;                     ///< capacity of the queue of the events posted by the callbacks with SpagFSM::postEvent(), 0 to disable it
+	static constexpr size_t inputQueueSize = 0;                    ///< capacity (a power of 2) of the thread-safe queue of the events pushed with SpagFSM::pushEvent(), 0 to disable it
+	static constexpr QueueFullPolicy inputQueuePolicy = QueueFullPolicy::Drop; ///< what SpagFSM::pushEvent() does when the input queue is full
+};
 
 namespace priv {
 
@@ -213,30 +450,74 @@ namespace priv {
 	struct AlwaysFalse {
 		enum { value = false };
 	};
+
+	/// Type of the handler of callback policy \c CB, or \c void if it has none (see HandlerCallback)
+	template<typename CB, typename = void>
+	struct CallbackHandler
+	{
+		using type = void;
+	};
+	template<typename CB>
+	struct CallbackHandler<CB,std::void_t<typename CB::Handler>>
+	{
+		using type = typename CB::Handler;
+	};
+
+	/// True if the timer class \c TIM provides the optional member function <code>wakeUp( const FSM* )</code>, see SpagFSM::pushEvent()
+	template<typename TIM, typename FSM, typename = void>
+	struct HasWakeUp : std::false_type
+	{};
+	template<typename TIM, typename FSM>
+	struct HasWakeUp<TIM,FSM,std::void_t<decltype( std::declval<TIM&>().wakeUp( std::declval<const FSM*>() ) )>> : std::true_type
+	{};
+
+	/// True if the FSM type provides the member function <code>isDriftFreeTimeOut( ST )</code> (see SpagFSM::setDriftFreeTimeOut()),
+	/// used by the timer classes. The other FSM types only have timeouts measured from the current time
+	template<typename FSM, typename = void>
+	struct HasDriftFree : std::false_type
+	{};
+	template<typename FSM>
+	struct HasDriftFree<FSM,std::void_t<decltype( std::declval<const FSM&>().isDriftFreeTimeOut( std::declval<const FSM&>().currentState() ) )>> : std::true_type
+	{};
+
+	/// True if the timer class \c TIM provides the member function <code>postInnerEvent( const FSM* )</code>, that
+	/// defers the processing of the inner event or AAT in its event loop. Else, its member function \c raiseSignal() is used
+	template<typename TIM, typename FSM, typename = void>
+	struct HasPostInnerEvent : std::false_type
+	{};
+	template<typename TIM, typename FSM>
+	struct HasPostInnerEvent<TIM,FSM,std::void_t<decltype( std::declval<TIM&>().postInnerEvent( std::declval<const FSM*>() ) )>> : std::true_type
+	{};
+
+	/// True if the timer class \c TIM provides the member function <code>raiseSignal()</code>. If it has neither this one
+	/// nor \c postInnerEvent(), the inner events and AAT are processed by the FSM itself, see SpagFSM::drainInnerEvents()
+	template<typename TIM, typename = void>
+	struct HasRaiseSignal : std::false_type
+	{};
+	template<typename TIM>
+	struct HasRaiseSignal<TIM,std::void_t<decltype( std::declval<TIM&>().raiseSignal() )>> : std::true_type
+	{};
 };
 
 //-----------------------------------------------------------------------------------
-#ifdef SPAG_ENABLE_LOGGING
 /// States and events counters, independent struct.
 /**
-If strings enabled, then we pass these to the constructor, else we only pass the number of states and events
+If strings are enabled for the FSM (see FsmTraits::enumStrings), then we also pass these to the constructor, for printing
 */
 struct Counters
 {
 	template<typename T1,typename T2>
 	friend struct priv::RunTimeData;
 
-#ifdef SPAG_ENUM_STRINGS
-	Counters( const std::vector<std::string>& strStates, const std::vector<std::string>& strEvents )
-		: _strStates( strStates )
-		, _strEvents( strEvents )
-	{
-		auto nb_states = strStates.size();
-		auto nb_events = strEvents.size();
-#else
-	Counters( size_t nb_states, size_t nb_events )
+	Counters(
+		size_t nb_states,
+		size_t nb_events,
+		const std::vector<std::string>* strStates = nullptr,
+		const std::vector<std::string>* strEvents = nullptr
+	)
+		: _strStates( strStates ? *strStates : std::vector<std::string>() )
+		, _strEvents( strEvents ? *strEvents : std::vector<std::string>() )
 	{
-#endif // SPAG_ENUM_STRINGS
 		assert( nb_states ); /// \todo remove this once tested
 		assert( nb_events );
 
@@ -273,12 +554,9 @@ struct Counters
 		std::vector<size_t> _eventCounter;   ///< per event counter
 		std::vector<size_t> _ignoredEventCounter;  ///< ignored events counter. No need to do "+2" as here, time outs and AAT will never be counted as ignored
 
-#ifdef SPAG_ENUM_STRINGS
-		const std::vector<std::string> _strStates;
-		const std::vector<std::string> _strEvents;
-#endif
+		const std::vector<std::string> _strStates; ///< empty if no strings
+		const std::vector<std::string> _strEvents; ///< empty if no strings
 };
-#endif // SPAG_ENABLE_LOGGING
 
 //-----------------------------------------------------------------------------------
 /// private namespace, so user code won't hit into this
@@ -290,6 +568,14 @@ inline
 std::pair<bool,DurUnit>
 timeUnitFromString( std::string str ) noexcept
 {
+	if( str == "ns" )
+		return std::make_pair( true, DurUnit::ns );
+	if( str == "nsec" )
+		return std::make_pair( true, DurUnit::ns );
+	if( str == "us" )
+		return std::make_pair( true, DurUnit::us );
+	if( str == "usec" )
+		return std::make_pair( true, DurUnit::us );
 	if( str == "ms" )
 		return std::make_pair( true, DurUnit::ms );
 	if( str == "msec" )
@@ -312,6 +598,8 @@ stringFromTimeUnit( DurUnit du )
 	std::string out;
 	switch( du )
 	{
+		case DurUnit::ns:  out = "ns";  break;
+		case DurUnit::us:  out = "us";  break;
 		case DurUnit::ms:  out = "ms";  break;
 		case DurUnit::sec: out = "sec"; break;
 		case DurUnit::min: out = "min"; break;
@@ -319,6 +607,22 @@ stringFromTimeUnit( DurUnit du )
 	return out;
 }
 //-----------------------------------------------------------------------------------
+/// Helper function, converts a duration and its unit into a \c std::chrono duration
+constexpr
+std::chrono::nanoseconds
+toChrono( Duration dur, DurUnit du )
+{
+	switch( du )
+	{
+		case DurUnit::ns:  return std::chrono::nanoseconds( dur );
+		case DurUnit::us:  return std::chrono::microseconds( dur );
+		case DurUnit::ms:  return std::chrono::milliseconds( dur );
+		case DurUnit::sec: return std::chrono::seconds( dur );
+		case DurUnit::min: return std::chrono::minutes( dur );
+	}
+	return std::chrono::nanoseconds( 0 );
+}
+//-----------------------------------------------------------------------------------
 /// returns name of lib as static string, to save space
 static std::string&
 getSpagName()
@@ -327,123 +631,373 @@ getSpagName()
 	static std::string str("Spaghetti: ");
 	return str;
 }
+//-----------------------------------------------------------------------------------
+/// Smallest unsigned integer type that can hold all the values from 0 to \c N
+template<size_t N>
+using SmallestUInt =
+	std::conditional_t<( N <= std::numeric_limits<uint8_t>::max() ),  uint8_t,
+	std::conditional_t<( N <= std::numeric_limits<uint16_t>::max() ), uint16_t,
+	uint32_t>>;
+
+/// Type used to store a state in the FSM tables: the smallest unsigned integer that can hold \c NB_STATES+1 values.
+/**
+An unscoped enum is usually \c int sized, so this divides by 4 the memory used by the tables for most FSM.
+The public API always converts back to \c ST.
+*/
+template<typename ST>
+using StateCell = SmallestUInt<SPAG_P_CAST2IDX(ST::NB_STATES)>;
+
+/// Type used to store an event in the FSM tables (same as StateCell, but also holds the timeout and AAT "events")
+template<typename EV>
+using EventCell = SmallestUInt<SPAG_P_CAST2IDX(EV::NB_EVENTS)+2>;
+
 //-----------------------------------------------------------------------------------
 /// Container holding information on timeout events. Each state will have one, event if it does not use it
+/**
+The durations are stored first, so that the other members fit in their padding.
+The duration is also stored as a \c std::chrono value, computed once when the timeout is assigned,
+so that the timer classes do not need to convert it each time they start (see SpagFSM::timeOutChrono()).
+*/
 template<typename ST>
 struct TimerEvent
 {
-	ST       _nextState = static_cast<ST>(0); ///< state to switch to
-	Duration _duration  = 0;                  ///< duration
-	bool     _enabled   = false;              ///< this state uses or not a timeout (default is no)
-	DurUnit  _durUnit   = DurUnit::sec;       ///< Duration unit
+	Duration                 _duration  = 0;            ///< duration
+	std::chrono::nanoseconds _chrono    = {};           ///< same, as a \c std::chrono value
+	StateCell<ST>            _nextState = 0;            ///< state to switch to, use nextState() to read it
+	bool                     _enabled   = false;        ///< this state uses or not a timeout (default is no)
+	bool                     _driftFree = false;        ///< timeout measured from the previous deadline, see SpagFSM::setDriftFreeTimeOut()
+	DurUnit                  _durUnit   = DurUnit::sec; ///< Duration unit
 
 	TimerEvent()
-		: _nextState(static_cast<ST>(0))
-		, _duration(0)
-		, _enabled(false)
 	{
 	}
-	TimerEvent( ST st, Duration dur, DurUnit unit ): _nextState(st), _duration(dur), _durUnit(unit)
+	TimerEvent( ST st, Duration dur, DurUnit unit, bool driftFree )
+		: _duration(dur)
+		, _chrono( toChrono( dur, unit ) )
+		, _nextState( static_cast<StateCell<ST>>(st) )
+		, _driftFree(driftFree)
+		, _durUnit(unit)
 	{
 		_enabled = true;
 	}
+	ST   nextState() const       { return static_cast<ST>( _nextState ); }
+	void setNextState( ST st )   { _nextState = static_cast<StateCell<ST>>( st ); }
 };
 //-----------------------------------------------------------------------------------
-#ifdef SPAG_USE_SIGNALS
-/// Holds information on inner events
+/// Empty type, replaces a data member that is disabled for the FSM type (see FsmTraits).
+/// \c N only makes the types distinct, so that several of them can be stored at no cost (see \ref SPAG_NO_UNIQUE_ADDRESS)
+template<int N>
+struct NoData
+{};
+
+//-----------------------------------------------------------------------------------
+/// Private struct, where the chain of pass states starting on a given state leads, see FsmTraits::collapseAAT
+template<typename ST>
+struct PassChain
+{
+	ST _target = static_cast<ST>(0);   ///< first state of the chain that is not a pass state without callback
+	ST _last   = static_cast<ST>(0);   ///< last pass state crossed, that becomes the previous state
+};
+
+//-----------------------------------------------------------------------------------
+/// Private class, sets a flag for its lifetime, and resets it even if an exception is thrown
+class FlagScope
+{
+	public:
+		explicit FlagScope( bool& flag ) : _flag(flag) { _flag = true; }
+		~FlagScope() { _flag = false; }
+		FlagScope( const FlagScope& ) = delete;
+		FlagScope& operator = ( const FlagScope& ) = delete;
+	private:
+		bool& _flag;
+};
+
+//-----------------------------------------------------------------------------------
+/// Private class, fixed-capacity FIFO (ring buffer) of the events posted with SpagFSM::postEvent() while an event is being processed.
+/**
+The events posted from the callbacks are processed once the current transition has completed (run-to-completion),
+see SpagFSM::runToCompletion().
+*/
+template<typename EV,size_t N>
+class PostedEvents
+{
+	public:
+/// Empties the queue on exit (only needed if the FSM has been stopped, or on exception)
+		class Scope
+		{
+			public:
+				explicit Scope( PostedEvents& pe ) : _pe(pe) {}
+				~Scope() { _pe.clear(); }
+				Scope( const Scope& ) = delete;
+				Scope& operator = ( const Scope& ) = delete;
+			private:
+				PostedEvents& _pe;
+		};
+
+		size_t size()       const { return _size; }
+		static constexpr size_t capacity() { return N; }
+
+/// Adds \c ev at the end of the queue, returns false if the queue is full
+		bool push( EV ev )
+		{
+			if( _size == N )
+				return false;
+			_buf[ ( _head + _size ) % N ] = static_cast<EventCell<EV>>( ev );
+			_size++;
+			return true;
+		}
+/// Removes the first event of the queue and copies it in \c ev, returns false if the queue is empty
+		bool pop( EV& ev )
+		{
+			if( _size == 0 )
+				return false;
+			ev = static_cast<EV>( _buf[ _head ] );
+			_head = static_cast<Index_t>( ( _head + 1 ) % N );
+			_size--;
+			return true;
+		}
+		void clear()
+		{
+			_head = 0;
+			_size = 0;
+		}
+
+	private:
+		using Index_t = SmallestUInt<N>;
+		std::array<EventCell<EV>,N> _buf;                  ///< stored as the table cells, to keep the FsmInstance objects small
+		Index_t                     _head = 0;
+		Index_t                     _size = 0;
+};
+
+//-----------------------------------------------------------------------------------
+/// Private class, bounded lock-free multi-producer single-consumer FIFO of the events pushed with SpagFSM::pushEvent()
+/**
+Any thread can push, only the thread running the event loop pops. Each cell holds a sequence number telling
+if it is free for the producer that has claimed its position, or ready for the consumer (D. Vyukov's bounded queue).
+Nothing is allocated, and producers only contend on the tail index.
+
+Also holds the "wake-up pending" flag, so that only the first event pushed after a drain wakes up the event loop,
+and the number of dropped events (see QueueFullPolicy).
+
+Copying gives an empty queue: the pending events belong to the FSM that received them.
+*/
+template<typename EV,size_t N>
+class InputQueue
+{
+	static_assert( N > 0 && ( N & (N-1) ) == 0, "Error, FsmTraits::inputQueueSize must be a power of 2" );
+
+	public:
+		InputQueue()
+		{
+			for( size_t i=0; i<N; i++ )
+				_cells[i]._seq.store( i, std::memory_order_relaxed );
+		}
+		InputQueue( const InputQueue& ) : InputQueue()
+		{}
+		InputQueue& operator = ( const InputQueue& )
+		{
+			return *this;
+		}
+
+		static constexpr size_t capacity() { return N; }
+
+/// Adds \c ev at the end of the queue, returns false if the queue is full. Can be called from any thread
+		bool push( EV ev )
+		{
+			size_t pos = _tail.load( std::memory_order_relaxed );
+			while( true )
+			{
+				Cell& cell = _cells[ pos & (N-1) ];
+				size_t seq = cell._seq.load( std::memory_order_acquire );
+				auto diff = static_cast<std::ptrdiff_t>( seq - pos );
+				if( diff == 0 )                                             // cell is free: try to claim it
+				{
+					if( _tail.compare_exchange_weak( pos, pos+1, std::memory_order_relaxed ) )
+					{
+						cell._ev = ev;
+						cell._seq.store( pos+1, std::memory_order_release );  // publish it
+						return true;
+					}
+				}
+				else if( diff < 0 )                                         // cell not consumed yet: full
+					return false;
+				else                                                        // claimed by another producer meanwhile
+					pos = _tail.load( std::memory_order_relaxed );
+			}
+		}
+/// Removes the first event of the queue and copies it in \c ev, returns false if the queue is empty.
+/// Must only be called by the consumer thread
+		bool pop( EV& ev )
+		{
+			Cell& cell = _cells[ _head & (N-1) ];
+			if( cell._seq.load( std::memory_order_acquire ) != _head+1 )  // empty, or not published yet
+				return false;
+			ev = cell._ev;
+			cell._seq.store( _head+N, std::memory_order_release );         // free it for the next round
+			_head++;
+			return true;
+		}
+
+/// Returns true if the caller is the first one to request a wake-up since the last call to clearWakeUp().
+/// The fences order the push (before) and the pop (after) with the flag, on both sides: either the consumer
+/// sees the pushed event, or the producer sees the cleared flag and requests a new wake-up
+		bool needsWakeUp()
+		{
+			std::atomic_thread_fence( std::memory_order_seq_cst );
+			return !_wakeUpPending.exchange( true, std::memory_order_acq_rel );
+		}
+		void clearWakeUp()
+		{
+			_wakeUpPending.exchange( false, std::memory_order_acq_rel );
+			std::atomic_thread_fence( std::memory_order_seq_cst );
+		}
+
+		void   countDropped()     { _nbDropped.fetch_add( 1, std::memory_order_relaxed ); }
+		size_t nbDropped() const  { return _nbDropped.load( std::memory_order_relaxed ); }
+
+	private:
+		struct Cell
+		{
+			std::atomic<size_t> _seq;
+			EV                  _ev;
+		};
+		std::array<Cell,N>              _cells;
+		alignas(64) std::atomic<size_t> _tail{0};              ///< next position to claim, shared by the producers
+		alignas(64) size_t              _head = 0;             ///< next position to pop, only used by the consumer
+		std::atomic<bool>               _wakeUpPending{false};
+		std::atomic<size_t>             _nbDropped{0};
+};
+
+//-----------------------------------------------------------------------------------
+/// Private class, set of \c N flags that any thread can set, read by the thread running the event loop (see SpagFSM::activateInnerEvent())
+/**
+Stored as words of 64 bits, no lock. Setting a flag is a \c fetch_or with release ordering, and the flags are read with acquire ordering,
+so that what the setting thread has written before is visible to the thread that sees the flag set.
+Clearing a flag returns its previous value, so that an activation is consumed only once.
+
+Copying copies the current values (the FSM must stay copyable), it is not atomic as a whole.
+*/
+template<size_t N>
+class AtomicBitset
+{
+	public:
+		AtomicBitset() = default;
+		AtomicBitset( const AtomicBitset& other )
+		{
+			copy( other );
+		}
+		AtomicBitset& operator = ( const AtomicBitset& other )
+		{
+			copy( other );
+			return *this;
+		}
+
+		void set( size_t i )
+		{
+			_words[i/64].fetch_or( mask( i ), std::memory_order_release );
+		}
+/// Clears flag \c i, returns true if it was set
+		bool reset( size_t i )
+		{
+			return _words[i/64].fetch_and( ~mask( i ), std::memory_order_acq_rel ) & mask( i );
+		}
+		bool test( size_t i ) const
+		{
+			return _words[i/64].load( std::memory_order_acquire ) & mask( i );
+		}
+/// Returns the flags as a \c std::bitset, to be combined with the inner transitions of a state
+		std::bitset<N> load() const
+		{
+			std::bitset<N> out;
+			for( size_t w=0; w<NbWords; w++ )
+				out |= std::bitset<N>( _words[w].load( std::memory_order_acquire ) ) << ( 64*w );
+			return out;
+		}
+
+	private:
+		static constexpr size_t NbWords = ( N + 63 ) / 64;
+		static constexpr uint64_t mask( size_t i ) { return uint64_t(1) << ( i%64 ); }
+		void copy( const AtomicBitset& other )
+		{
+			for( size_t w=0; w<NbWords; w++ )
+				_words[w].store( other._words[w].load( std::memory_order_acquire ), std::memory_order_release );
+		}
+		std::array<std::atomic<uint64_t>,NbWords> _words{};
+};
+
+//-----------------------------------------------------------------------------------
+/// Private class, holds the run-time state of a FSM: what changes while it runs.
+/// SpagFSM holds one, and so does each FsmInstance sharing a configuration.
+/**
+\c POSTED is the queue of posted events (PostedEvents), or an empty type if disabled (see FsmTraits::postQueueSize)
+
+\c INPUT is the thread-safe queue of pushed events (InputQueue), or an empty type if disabled (see FsmTraits::inputQueueSize)
+*/
+template<typename ST,typename TIM,typename POSTED=NoData<0>,typename INPUT=NoData<1>>
+struct RunState
+{
+	ST   _current      = static_cast<ST>(0);   ///< current state
+	ST   _previous     = static_cast<ST>(0);   ///< previous state
+	bool _isRunning    = false;
+	bool _innerPending = false;                ///< an inner event or AAT waits to be processed, see SpagFSM::drainInnerEvents()
+	bool _isProcessing = false;                ///< set while an event is processed, by the outermost call of SpagFSM::runToCompletion()
+	TIM* _eventHandler = nullptr;              ///< pointer on timer/ event-loop handling object
+	SPAG_NO_UNIQUE_ADDRESS POSTED _posted;      ///< events posted by the callbacks, see SpagFSM::postEvent()
+	SPAG_NO_UNIQUE_ADDRESS INPUT  _input;       ///< events pushed by other threads, see SpagFSM::pushEvent()
+};
+
+//-----------------------------------------------------------------------------------
+/// Private class, inner events part of StateInfo: empty if inner events are disabled for the FSM type (see FsmTraits::innerEvents)
+template<typename ST,typename EV,bool INNER>
+struct StateInnerInfo
+{
+	void printInner( std::ostream& ) const {}
+};
+
+/// Private class, inner events part of StateInfo, when inner events are enabled
 /**
-The type StateInfo (one for every state) hold a vector of these: each state can handle several InnerTransition
+The inner transitions of the state are stored inline, as a mask: the next state of each one is stored in the transition table,
+at the line of its inner event. Thus checking if one of them has been activated is a single AND with the activation flags.
 */
 template<typename ST,typename EV>
-struct InnerTransition
+struct StateInnerInfo<ST,EV,true>
 {
-	ST _destState;
-	EV _innerEvent;
+	bool _isPassState = false; ///< if true, the next state is stored in transition table, at line nbEvents()+1
+	std::bitset<SPAG_P_CAST2IDX(EV::NB_EVENTS)> _innerMask;  ///< the inner events that have a transition from this state
 
-	InnerTransition( EV ev, ST st ) : _destState(st), _innerEvent(ev)
-	{}
-	bool operator == ( const InnerTransition& it ) const
-	{
-		if( _destState != it._destState )
-			return false;
-		if( _innerEvent != it._innerEvent )
-			return false;
-		return true;
-	}
-	friend std::ostream& operator << ( std::ostream& s, const InnerTransition& it )
+	void printInner( std::ostream& s ) const
 	{
-		s << "InnerTransition:"
-			<< " destState=" << (int)it._destState
-			<< " innerEvent=" << (int)it._innerEvent;
-		return s;
+		s << "\n -isPassState=" << _isPassState
+			<< "\n -NbInnerTransition=" << _innerMask.count()
+			<< '\n';
+		for( size_t i=0; i<_innerMask.size(); i++ )
+			if( _innerMask[i] )
+				s << "  -innerEvent=" << i << '\n';
 	}
 };
-#endif // SPAG_USE_SIGNALS
+
 //-----------------------------------------------------------------------------------
 /// Private class, holds informations about a state. The FSM holds one of these for every state.
-template<typename ST,typename EV,typename CBA>
-struct StateInfo
+/**
+\c CBSLOT is the callback storage type, given by the callback policy (see FsmTraits::Callback)
+
+\c INNER is true if inner events are enabled (see FsmTraits::innerEvents)
+*/
+template<typename ST,typename EV,typename CBA,typename CBSLOT=std::function<void(CBA)>,bool INNER=SPAG_P_DEFAULT_INNER_EVENTS>
+struct StateInfo : StateInnerInfo<ST,EV,INNER>
 {
 	TimerEvent<ST>           _timerEvent;   ///< Holds the information on timeout
-	std::function<void(CBA)> _callback;     ///< callback function
+	CBSLOT                   _callback;     ///< callback function
 	CBA                      _callbackArg;  ///< value of argument of callback function
 
-#ifdef SPAG_USE_SIGNALS
-	bool                     _isPassState = false; ///< if true, the next state is stored in transition table, at line nbEvents()+1
-	std::vector<InnerTransition<ST,EV>> _innerTransList;
-
 	friend std::ostream& operator << ( std::ostream& s, const StateInfo& si )
 	{
 		s << "StateInfo:"
-			<< "\n -has callback=" << (si._callback==0?"NO":"YES")
-			<< "\n -callbackArg=" << si._callbackArg
-			<< "\n -isPassState=" << si._isPassState
-			<< "\n -NbInnerTransition=" << si._innerTransList.size()
-			<< '\n';
-		for( const auto& it: si._innerTransList )
-			s << "  -" << it << '\n';
+			<< "\n -has callback=" << (si._callback?"YES":"NO")
+			<< "\n -callbackArg=" << si._callbackArg;
+		si.printInner( s );
 		return s;
 	}
-
-/// Returns true if the set of internal transitions holds one with event \c ev leading to state \c st
-	bool holdsInnerTransition( EV ev, ST st ) const
-	{
-		if(
-			std::find(
-				std::begin( _innerTransList ),
-				std::end(   _innerTransList ),
-				InnerTransition<ST,EV>( ev, st )
-			)
-			== std::end( _innerTransList )
-		)
-			return false;
-		return true;
-	}
-
-#if 0 // unused
-/// Returns true if the set of internal transitions holds one using event \c ev
-	bool holdsInnerEvent( EV ev ) const
-	{
-		for( const auto& it: _innerTransList )
-			if( it._innerEvent == ev )
-				return true;
-		return false;
-	}
-#endif
-
-	typename std::vector<InnerTransition<ST,EV>>::iterator
-	findInnerEvent( EV ev )
-	{
-		for(
-			auto it=std::begin(_innerTransList);
-			it != std::end(_innerTransList);
-			++it
-		)
-			if( it->_innerEvent == ev )
-				return it;
-		return std::end( _innerTransList );
-	}
-#endif // SPAG_USE_SIGNALS
 };
 //-----------------------------------------------------------------------------------
 /// Private, helper function
@@ -492,7 +1046,6 @@ getMaxLength( const T& v_str )
 } // namespace priv
 
 //-----------------------------------------------------------------------------------
-#ifdef SPAG_ENABLE_LOGGING
 /// Holds the values of the counters, can be fetched with \c fsm.getCounters()
 /**
 Also holds the string (if option enabled), for nice printing
@@ -501,21 +1054,20 @@ inline
 void
 Counters::print( std::ostream& out, uint8_t flags, char sep ) const
 {
-#ifdef SPAG_ENUM_STRINGS
-	auto maxlength_e = priv::getMaxLength( _strEvents );
-	auto maxlength_s = priv::getMaxLength( _strStates );
-#endif
+	bool hasStrings = !_strStates.empty();
+	auto maxlength_e = hasStrings ? priv::getMaxLength( _strEvents ) : 0;
+	auto maxlength_s = hasStrings ? priv::getMaxLength( _strStates ) : 0;
 	if( flags & ItemStates )
 	{
 		out << "# State counters:\n";
 		for( size_t i=0; i<_stateCounter.size(); i++ )
 		{
-			out << i << sep,
-
-#ifdef SPAG_ENUM_STRINGS
-			priv::PrintEnumString( out, _strStates[i], maxlength_s );
-			out << sep;
-#endif
+			out << i << sep;
+			if( hasStrings )
+			{
+				priv::PrintEnumString( out, _strStates[i], maxlength_s );
+				out << sep;
+			}
 			out << _stateCounter[i] << '\n';
 		}
 	}
@@ -526,10 +1078,11 @@ Counters::print( std::ostream& out, uint8_t flags, char sep ) const
 		for( size_t i=0; i<_eventCounter.size(); i++ )
 		{
 			out << i << sep;
-#ifdef SPAG_ENUM_STRINGS
-			priv::PrintEnumString( out, _strEvents[i], maxlength_e );
-			out << sep;
-#endif
+			if( hasStrings )
+			{
+				priv::PrintEnumString( out, _strEvents[i], maxlength_e );
+				out << sep;
+			}
 			out << _eventCounter[i] << '\n';
 		}
 	}
@@ -540,20 +1093,19 @@ Counters::print( std::ostream& out, uint8_t flags, char sep ) const
 		for( size_t i=0; i<_ignoredEventCounter.size(); i++ )
 		{
 			out << i << sep;
-#ifdef SPAG_ENUM_STRINGS
-			priv::PrintEnumString( out, _strEvents[i], maxlength_e );
-			out << sep;
-#endif
+			if( hasStrings )
+			{
+				priv::PrintEnumString( out, _strEvents[i], maxlength_e );
+				out << sep;
+			}
 			out << _ignoredEventCounter[i] << '\n';
 		}
 	}
 }
-#endif // SPAG_ENABLE_LOGGING
 
 namespace priv {
 //------------------------------------------------------------------------------------
-/// Holds the FSM dynamic data: current state, and logged data (if enabled at build, see symbol \c SPAG_ENABLE_LOGGING)
-#ifdef SPAG_ENABLE_LOGGING
+/// Holds the FSM logged data (if enabled for the FSM type, see FsmTraits::logging)
 template<typename ST,typename EV>
 struct RunTimeData
 {
@@ -568,12 +1120,9 @@ struct RunTimeData
 //- - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
 
 	public:
-#ifdef SPAG_ENUM_STRINGS
-	RunTimeData( const std::vector<std::string>& str_events, const std::vector<std::string>& str_states )
+/// The strings are given only if enabled for the FSM type (see FsmTraits::enumStrings)
+	explicit RunTimeData( const std::vector<std::string>* str_events=nullptr, const std::vector<std::string>* str_states=nullptr )
 		: _strEvents_R(str_events), _strStates_R( str_states )
-#else
-	RunTimeData()
-#endif
 	{
 		_startTime = std::chrono::high_resolution_clock::now();
 		clear();
@@ -589,11 +1138,7 @@ struct RunTimeData
 /// Returns a copy of all the counters.
 	Counters buildCounters() const
 	{
-#ifdef SPAG_ENUM_STRINGS
-		Counters cnt( _strStates_R, _strEvents_R );
-#else
-		Counters cnt( _stateCounter.size(), _eventCounter.size() );
-#endif
+		Counters cnt( _stateCounter.size(), _eventCounter.size(), _strStates_R, _strEvents_R );
 
 		std::copy( std::begin(_stateCounter),  std::end(_stateCounter),  std::begin(cnt._stateCounter) );
 		std::copy( std::begin(_eventCounter),  std::end(_eventCounter),  std::begin(cnt._eventCounter) );
@@ -626,12 +1171,11 @@ Events are passed as \c size_t because we may pass values other than the ones in
 
 			_logfile << "# FSM runtime history\n# "
 				<< getSpagName() << SPAG_VERSION
-				<< "\n# index" << _sepChar << "time" << _sepChar << "event-Id" << _sepChar
-	#ifdef SPAG_ENUM_STRINGS
-				<< "event_string" << _sepChar << "state-Id" << _sepChar << "state_string\n";
-	#else
-				<< "state-Id\n";
-	#endif
+				<< "\n# index" << _sepChar << "time" << _sepChar << "event-Id" << _sepChar;
+			if( _strEvents_R )
+				_logfile << "event_string" << _sepChar << "state-Id" << _sepChar << "state_string\n";
+			else
+				_logfile << "state-Id\n";
 		}
 
 		print2LogFile( _logfile, StateChangeEvent{ st_idx, ev_idx, std::chrono::high_resolution_clock::now() - _startTime } );
@@ -654,13 +1198,11 @@ Events are passed as \c size_t because we may pass values other than the ones in
 		f << std::setw(6) << std::setfill('0') << _logIndex++
 			<< _sepChar << sce._elapsed.count() << _sepChar << sce._event << _sepChar;
 //		std::cout << "c=" << c << '\n';
-	#ifdef SPAG_ENUM_STRINGS
-		f << _strEvents_R[sce._event] << _sepChar;
-	#endif
+		if( _strEvents_R )
+			f << (*_strEvents_R)[sce._event] << _sepChar;
 		f << sce._state << _sepChar;
-	#ifdef SPAG_ENUM_STRINGS
-		f << _strStates_R[sce._state];
-	#endif
+		if( _strStates_R )
+			f << (*_strStates_R)[sce._state];
 		f << '\n';
 	}
 
@@ -677,33 +1219,268 @@ Events are passed as \c size_t because we may pass values other than the ones in
 		std::chrono::time_point<std::chrono::high_resolution_clock> _startTime;
 		std::ofstream _logfile;
 
-	#ifdef SPAG_ENUM_STRINGS
-		const std::vector<std::string>& _strEvents_R; ///< reference on vector of strings of events
-		const std::vector<std::string>& _strStates_R; ///< reference on vector of strings of states
-	#endif
+		const std::vector<std::string>* _strEvents_R; ///< pointer on vector of strings of events, null if no strings
+		const std::vector<std::string>* _strStates_R; ///< pointer on vector of strings of states, null if no strings
 
 		char _sepChar = ';';          ///< log file separator
 	public:
 		std::string _logfileName = "spaghetti.csv";
 };
-#endif // SPAG_ENABLE_LOGGING
+
+/// Replaces RunTimeData when logging is disabled for the FSM type (see FsmTraits::logging)
+struct NoRunTimeData
+{
+	template<typename... A>
+	explicit NoRunTimeData( A&&... ) {}
+};
 
 //-----------------------------------------------------------------------------------
-#ifndef SPAG_USE_ARRAY
-/// helper template function (unused if SPAG_USE_ARRAY defined)
-template<typename T>
-void
-resizemat( std::vector<std::vector<T>>& mat, std::size_t nb_lines, std::size_t nb_cols )
+/// Number of lines of the transition table: one per event, plus one for timeouts, plus one for the AAT
+/// if \c INNER is true (inner events enabled, see FsmTraits::innerEvents)
+template<typename EV,bool INNER>
+constexpr size_t
+nbTableLines()
 {
-	mat.resize( nb_lines );
-	for( auto& line: mat )
-	{
-		line.resize( nb_cols );
-		for( auto& elem: line )
-			elem = static_cast<T>(0);
-	}
+	return SPAG_P_CAST2IDX(EV::NB_EVENTS) + ( INNER ? 2 : 1 );
 }
+
+//-----------------------------------------------------------------------------------
+/// A (nbTableLines() x NB_STATES) matrix, stored in a single contiguous block, in the order given by \c LAYOUT
+/**
+Elements are accessed with <code>(ev,st)</code>, whatever the layout.
+*/
+template<typename T,typename ST,typename EV,TableLayout LAYOUT,bool INNER>
+class TableMat
+{
+	static constexpr size_t NbLines  = nbTableLines<EV,INNER>();
+	static constexpr size_t NbStates = SPAG_P_CAST2IDX(ST::NB_STATES);
+
+	public:
+		explicit TableMat( T init )
+		{
+#ifndef SPAG_USE_ARRAY
+			_data.resize( NbLines * NbStates );
+#endif
+			std::fill( std::begin(_data), std::end(_data), init );
+		}
+
+		T&       operator()( size_t ev, size_t st )       { return _data[ index( ev, st ) ]; }
+		const T& operator()( size_t ev, size_t st ) const { return _data[ index( ev, st ) ]; }
+
+	private:
+		static size_t index( size_t ev, size_t st )
+		{
+			assert( ev < NbLines && st < NbStates );
+			if constexpr( LAYOUT == TableLayout::EventMajor )
+				return ev * NbStates + st;
+			else
+				return st * NbLines + ev;     // all the transitions of a given state are contiguous
+		}
+
+#ifdef SPAG_USE_ARRAY
+		std::array<T, NbLines * NbStates> _data;
+#else
+		std::vector<T> _data;
 #endif
+};
+
+//-----------------------------------------------------------------------------------
+/// Storage of the transition table, specialized for each of the policies SplitTable and PackedTable.
+/**
+Lines are events, columns are states (whatever the memory layout \c LAYOUT). Whatever the policy, it provides:
+ - <code>ST next( size_t ev, size_t st )</code>: state to switch to
+ - <code>char allowed( size_t ev, size_t st )</code>: 0:ignore event, 1:handle external event, -1: internal event
+ - the corresponding setters, and \c setTimeOutFlag(), that must be called each time the timeout of a state is changed
+
+States are stored with type \c CELL: either \c ST or StateCell<ST> (see FsmTraits::narrowCells).
+\c INNER is true if inner events are enabled (see FsmTraits::innerEvents): then the table has a line for the AAT.
+*/
+template<typename ST,typename EV,typename TAB,TableLayout LAYOUT,typename CELL,bool INNER>
+class TableStorage;
+
+//-----------------------------------------------------------------------------------
+/// Transition table storage, historical layout: two separate tables
+template<typename ST,typename EV,TableLayout LAYOUT,typename CELL,bool INNER>
+class TableStorage<ST,EV,SplitTable,LAYOUT,CELL,INNER>
+{
+	public:
+		TableStorage()
+			: _transitionMat( static_cast<CELL>(0) )  // transition table filled with state 0
+			, _allowedMat( 0 )                        // all events will be ignored at init
+		{}
+
+		ST   next(    size_t ev, size_t st ) const { return static_cast<ST>( _transitionMat( ev, st ) ); }
+		char allowed( size_t ev, size_t st ) const { return _allowedMat( ev, st ); }
+
+		void setNext(    size_t ev, size_t st, ST next ) { _transitionMat( ev, st ) = static_cast<CELL>( next ); }
+		void setAllowed( size_t ev, size_t st, char a )  { _allowedMat( ev, st ) = a; }
+		void setTimeOutFlag( size_t, bool ) {}           ///< nothing to do here, the flag is read in the state info
+		void pack() {}                                   ///< nothing to do here, see SpagFSM::finalize()
+
+	private:
+		TableMat<CELL,ST,EV,LAYOUT,INNER> _transitionMat;  ///< describe what states the fsm switches to, when an event is received. DOES NOT hold timer events
+		TableMat<char,ST,EV,LAYOUT,INNER> _allowedMat;     ///< tells if the event is ignored or not, for a given state (0:ignore event, 1:handle external event, -1: internal event)
+};
+
+//-----------------------------------------------------------------------------------
+/// A cell of the packed transition table, see PackedTable
+template<typename CELL>
+struct PackedCell
+{
+	CELL _next       = static_cast<CELL>(0); ///< state to switch to
+	char _allowed    = 0;                    ///< 0:ignore event, 1:handle external event, -1: internal event
+	bool _hasTimeOut = false;                ///< true if the source state (column) has a timeout, that needs to be cancelled
+};
+
+//-----------------------------------------------------------------------------------
+/// Transition table storage, packed layout: a single table of PackedCell
+template<typename ST,typename EV,TableLayout LAYOUT,typename CELL,bool INNER>
+class TableStorage<ST,EV,PackedTable,LAYOUT,CELL,INNER>
+{
+	public:
+		TableStorage() : _cells( PackedCell<CELL>() )
+		{}
+
+		const PackedCell<CELL>& cell( size_t ev, size_t st ) const { return _cells( ev, st ); }
+
+		ST   next(    size_t ev, size_t st ) const { return static_cast<ST>( _cells( ev, st )._next ); }
+		char allowed( size_t ev, size_t st ) const { return _cells( ev, st )._allowed; }
+
+		void setNext(    size_t ev, size_t st, ST next ) { _cells( ev, st )._next = static_cast<CELL>( next ); }
+		void setAllowed( size_t ev, size_t st, char a )  { _cells( ev, st )._allowed = a; }
+		void setTimeOutFlag( size_t st, bool flag )
+		{
+			for( size_t i=0; i<nbTableLines<EV,INNER>(); i++ )
+				_cells( i, st )._hasTimeOut = flag;
+		}
+		void pack() {}    ///< nothing to do here, see SpagFSM::finalize()
+
+	private:
+		TableMat<PackedCell<CELL>,ST,EV,LAYOUT,INNER> _cells;
+};
+
+//-----------------------------------------------------------------------------------
+/// Transition table storage, sparse layout: for each state, a list of the non-empty cells, sorted by event
+/**
+A cell is stored as soon as its next state or its allowed flag is not null, and removed when both get back to null.
+The timeout flag is stored once per state.
+Always uses \c std::vector (whatever \c SPAG_USE_ARRAY), as the point is to have a small FSM object.
+*/
+template<typename ST,typename EV,TableLayout LAYOUT,typename CELL,bool INNER>
+class TableStorage<ST,EV,SparseTable,LAYOUT,CELL,INNER>
+{
+	struct Entry
+	{
+		EventCell<EV> _event;
+		CELL          _next;
+		char          _allowed;
+	};
+	struct StateLine
+	{
+		std::vector<Entry> _entries;           ///< sorted by event
+		bool               _hasTimeOut = false;
+	};
+
+	public:
+		TableStorage() : _lines( SPAG_P_CAST2IDX(ST::NB_STATES) )
+		{}
+
+/// Returns the cell by value, as it is built from the entry and the state line
+		PackedCell<CELL> cell( size_t ev, size_t st ) const
+		{
+			const auto& line = _lines[st];
+			const Entry* e = find( line, ev );
+			if( !e )
+				return PackedCell<CELL>{ static_cast<CELL>(0), 0, line._hasTimeOut };
+			return PackedCell<CELL>{ e->_next, e->_allowed, line._hasTimeOut };
+		}
+
+		ST next( size_t ev, size_t st ) const
+		{
+			const Entry* e = find( _lines[st], ev );
+			return static_cast<ST>( e ? e->_next : static_cast<CELL>(0) );
+		}
+		char allowed( size_t ev, size_t st ) const
+		{
+			const Entry* e = find( _lines[st], ev );
+			return e ? e->_allowed : 0;
+		}
+
+		void setNext( size_t ev, size_t st, ST next )
+		{
+			getOrCreate( ev, st )._next = static_cast<CELL>( next );
+			removeIfEmpty( ev, st );
+		}
+		void setAllowed( size_t ev, size_t st, char a )
+		{
+			getOrCreate( ev, st )._allowed = a;
+			removeIfEmpty( ev, st );
+		}
+		void setTimeOutFlag( size_t st, bool flag )
+		{
+			_lines[st]._hasTimeOut = flag;
+		}
+/// Releases the unused capacity of the lines, once the configuration is frozen (see SpagFSM::finalize())
+		void pack()
+		{
+			for( auto& line: _lines )
+				line._entries.shrink_to_fit();
+		}
+
+/// Returns the number of stored cells (used for memory estimations)
+		size_t nbEntries() const
+		{
+			size_t n = 0;
+			for( const auto& line: _lines )
+				n += line._entries.size();
+			return n;
+		}
+
+	private:
+		static typename std::vector<Entry>::const_iterator
+		lowerBound( const std::vector<Entry>& v, size_t ev )
+		{
+			return std::lower_bound(
+				std::begin(v),
+				std::end(v),
+				ev,
+				[]( const Entry& e, size_t ev ){ return e._event < ev; }  // lambda
+			);
+		}
+		static const Entry* find( const StateLine& line, size_t ev )
+		{
+			if( line._entries.size() <= 16 )   // linear search is faster on short lists
+			{
+				for( const auto& e: line._entries )
+					if( e._event >= ev )
+						return e._event == ev ? &e : nullptr;
+				return nullptr;
+			}
+			auto it = lowerBound( line._entries, ev );
+			if( it == std::end( line._entries ) || it->_event != ev )
+				return nullptr;
+			return &*it;
+		}
+		Entry& getOrCreate( size_t ev, size_t st )
+		{
+			auto& v = _lines[st]._entries;
+			auto it = v.begin() + ( lowerBound( v, ev ) - v.cbegin() );
+			if( it == std::end(v) || it->_event != ev )
+				it = v.insert( it, Entry{ static_cast<EventCell<EV>>(ev), static_cast<CELL>(0), 0 } );
+			return *it;
+		}
+		void removeIfEmpty( size_t ev, size_t st )
+		{
+			auto& v = _lines[st]._entries;
+			auto it = v.begin() + ( lowerBound( v, ev ) - v.cbegin() );
+			if( it->_next == static_cast<CELL>(0) && it->_allowed == 0 )
+				v.erase( it );
+		}
+
+	private:
+		std::vector<StateLine> _lines;   ///< one per state
+};
+
 //-----------------------------------------------------------------------------------
 /// Used for configuration errors (more to be added). Used through priv::getConfigErrorMessage()
 enum EN_ConfigError
@@ -757,57 +1534,90 @@ types:
    - timerStart( const SpagFSM* );
    - timerCancel();
  - CBA: the callback function type (single) argument
+ - TRAITS: some compile-time options, see FsmTraits
 
 Requirements: the two enums \b MUST have the following requirements:
  - the last element \b must be NB_STATES and NB_EVENTS, respectively
  - the first state must have value 0
 */
-template<typename ST, typename EV,typename TIM,typename CBA=int>
+template<typename ST, typename EV,typename TIM,typename CBA=int,typename TRAITS=FsmTraits>
 class SpagFSM
 {
-	using Callback_t = std::function<void(CBA)>;
+	using CallbackPolicy = typename TRAITS::Callback;
+	using CbArg_t        = std::conditional_t<TRAITS::callbackArgByRef, const CBA&, CBA>; ///< argument type of the callback functions
+	using Callback_t     = typename CallbackPolicy::template Slot<CbArg_t>;     ///< per-state callback storage
+	using CbHandler_t    = typename priv::CallbackHandler<CallbackPolicy>::type; ///< \c void if policy is not HandlerCallback
+	using StateInfo_t    = priv::StateInfo<ST,EV,CBA,Callback_t,TRAITS::innerEvents>;
+	static constexpr bool usePostQueue = TRAITS::postQueueSize > 0;
+	using Posted_t       = std::conditional_t<usePostQueue, priv::PostedEvents<EV,TRAITS::postQueueSize>, priv::NoData<0>>;
+	static constexpr bool useInputQueue = TRAITS::inputQueueSize > 0;
+	using Input_t        = std::conditional_t<useInputQueue, priv::InputQueue<EV,TRAITS::inputQueueSize>, priv::NoData<1>>;
+	using RunState_t     = priv::RunState<ST,TIM,Posted_t,Input_t>;
+
+	template<typename FSM>
+	friend class FsmInstance;
+	template<typename FSM>
+	friend class FsmConfig;
+	static constexpr bool hasCbHandler   = !std::is_void<CbHandler_t>::value;
+	static constexpr bool useLogging     = TRAITS::logging;
+	static constexpr bool useEnumStrings = TRAITS::enumStrings;
+	static constexpr bool useInnerEvents = TRAITS::innerEvents;
+/// True if the deferred inner events and AAT are processed by the FSM itself, because the timer class
+/// can not do it (it has neither \c postInnerEvent() nor \c raiseSignal()), see drainInnerEvents()
+	template<typename OWNER>
+	static constexpr bool drainsInnerEvents = useInnerEvents
+		&& !priv::HasPostInnerEvent<TIM,OWNER>::value
+		&& !priv::HasRaiseSignal<TIM>::value;
+	using RunTimeData_t  = std::conditional_t<useLogging, priv::RunTimeData<ST,EV>, priv::NoRunTimeData>;
+	using EventMask_t    = std::bitset<static_cast<size_t>(EV::NB_EVENTS)>;
+	using ActiveMask_t   = priv::AtomicBitset<static_cast<size_t>(EV::NB_EVENTS)>;
+	template<typename T,int N>
+	using IfStrings_t    = std::conditional_t<useEnumStrings, T, priv::NoData<N>>;
+	template<typename T,int N>
+	using IfInner_t      = std::conditional_t<useInnerEvents, T, priv::NoData<N>>;
+/// True if the states information is stored on the heap: with \c SPAG_USE_VECTOR, or with a SparseTable, whose point is to have a small FSM object
+#ifdef SPAG_USE_ARRAY
+	static constexpr bool stateInfoOnHeap = std::is_same<typename TRAITS::Table,SparseTable>::value;
+#else
+	static constexpr bool stateInfoOnHeap = true;
+#endif
+	using StateInfoStorage_t = std::conditional_t<
+		stateInfoOnHeap,
+		std::vector<StateInfo_t>,
+		std::array<StateInfo_t,static_cast<size_t>(ST::NB_STATES)>
+	>;
+	static constexpr bool useCollapseAAT = TRAITS::collapseAAT;
+	static_assert( !useCollapseAAT || useInnerEvents, "Error, FsmTraits::collapseAAT requires FsmTraits::innerEvents" );
 
 	public:
 /// Constructor
-
-#if (defined SPAG_ENABLE_LOGGING) && (defined SPAG_ENUM_STRINGS)
-		SpagFSM() : _rtdata( _strEvents, _strStates )
-#else
-		SpagFSM()
-#endif
+		SpagFSM() : _rtdata( stringsPtr( _strEvents ), stringsPtr( _strStates ) )
 		{
 			static_assert( SPAG_P_CAST2IDX(ST::NB_STATES) > 1, "Error, you need to provide at least two states" );
 
-#ifdef SPAG_USE_ARRAY
-			for( auto& e: _allowedMat )      // all events will be ignored at init
-				std::fill( e.begin(), e.end(), 0 );
-			for( auto& e: _transitionMat )      // transition table filled with state 0
-				std::fill( e.begin(), e.end(), static_cast<ST>(0) );
-#else
-			priv::resizemat( _transitionMat, nbEvents(), nbStates() );
-			priv::resizemat( _allowedMat, nbEvents(), nbStates() );
-			_stateInfo.resize( nbStates() );    // states information
-#endif
+			if constexpr( stateInfoOnHeap )
+				_stateInfo.resize( nbStates() );    // states information
 
-#ifdef SPAG_ENUM_STRINGS
-			_strEvents.resize( nbEvents()+2 );
-			_strStates.resize( nbStates() );
-			std::generate(                          // assign default strings, so it doesn't stay empty
-				_strStates.begin(),
-				_strStates.end(),
-				[](){ static int idx; std::string s = "St-"; s += std::to_string(idx++); return s; } // lambda
-			);
-			std::generate(                          // assign default strings, so it doesn't stay empty
-				_strEvents.begin(),
-				_strEvents.end(),
-				[](){ static int idx; std::string s = "Ev-"; s += std::to_string(idx++); return s; } // lambda
-			);
-			_strEvents[ nbEvents()   ] = "*Timeout*";
-			_strEvents[ nbEvents()+1 ] = "*  AAT  *"; // Always Active Transition
-#endif
+			if constexpr( useEnumStrings )
+			{
+				_strEvents.resize( nbEvents()+2 );
+				_strStates.resize( nbStates() );
+				std::generate(                          // assign default strings, so it doesn't stay empty
+					_strStates.begin(),
+					_strStates.end(),
+					[](){ static int idx; std::string s = "St-"; s += std::to_string(idx++); return s; } // lambda
+				);
+				std::generate(                          // assign default strings, so it doesn't stay empty
+					_strEvents.begin(),
+					_strEvents.end(),
+					[](){ static int idx; std::string s = "Ev-"; s += std::to_string(idx++); return s; } // lambda
+				);
+				_strEvents[ nbEvents()   ] = "*Timeout*";
+				_strEvents[ nbEvents()+1 ] = "*  AAT  *"; // Always Active Transition
+			}
 
 #ifdef SPAG_EMBED_ASIO_WRAPPER
-			_eventHandler = &_asioWrapper;
+			_rs._eventHandler = &_asioWrapper;
 #endif
 		}
 
@@ -825,15 +1635,13 @@ Type \c A can be \c bool, \c char, \c uchar, ...
 		template<typename T>
 		void assignEventMat( const T& mat )
 		{
+			checkNotFinalized();
 			SPAG_CHECK_EQUAL( mat.size(),    nbEvents() );
 			SPAG_CHECK_EQUAL( mat[0].size(), nbStates() );
 
-			auto li_out = std::begin( _allowedMat );
-			for( auto li_in : mat )
-			{
-				std::copy( std::begin(li_in), std::end(li_in), std::begin(*li_out) );
-				li_out++;
-			}
+			for( size_t i=0; i<nbEvents(); i++ )
+				for( size_t j=0; j<nbStates(); j++ )
+					_table.setAllowed( i, j, mat[i][j] );
 		}
 
 /// Assigns transition matrix
@@ -847,14 +1655,12 @@ Allowed types for \c T:
 		template<typename T>
 		void assignTransitionMat( const T& mat )
 		{
+			checkNotFinalized();
 			SPAG_CHECK_EQUAL( mat.size(),    nbEvents() );
 			SPAG_CHECK_EQUAL( mat[0].size(), nbStates() );
-			auto li_out = std::begin( _transitionMat );
-			for( auto li_in : mat )
-			{
-				std::copy( std::begin(li_in), std::end(li_in), std::begin(*li_out) );
-				li_out++;
-			}
+			for( size_t i=0; i<nbEvents(); i++ )
+				for( size_t j=0; j<nbStates(); j++ )
+					_table.setNext( i, j, mat[i][j] );
 		}
 
 /// Assigns an external transition event \c ev to switch from state \c st1 to state \c st2
@@ -863,97 +1669,99 @@ Allowed types for \c T:
 */
 		void assignTransition( ST st1, EV ev, ST st2 )
 		{
+			checkNotFinalized();
 			SPAG_CHECK_LESS( SPAG_P_CAST2IDX(st1), nbStates() );
 			SPAG_CHECK_LESS( SPAG_P_CAST2IDX(st2), nbStates() );
 			SPAG_CHECK_LESS( SPAG_P_CAST2IDX(ev),  nbEvents() );
 			auto st1_idx = SPAG_P_CAST2IDX(st1);
 
-#ifdef SPAG_USE_SIGNALS
-			if( _stateInfo[st1_idx]._isPassState )
-			{
-				std::string err_msg{ "error, attempting to assign a transition to state" };
-				err_msg += std::to_string( st1_idx );
-#ifdef SPAG_ENUM_STRINGS
-				err_msg += " (" + _strStates[ st1_idx ] + ")";
-#endif
-				err_msg += ", was previously declared as pass-state";
-				SPAG_P_THROW_ERROR_CFG( err_msg );
-			}
-#endif
-			_transitionMat[ SPAG_P_CAST2IDX(ev) ][ st1_idx ] = st2;
-			_allowedMat[    SPAG_P_CAST2IDX(ev) ][ st1_idx ] = 1;
+			if constexpr( useInnerEvents )
+				if( _stateInfo[st1_idx]._isPassState )
+				{
+					std::string err_msg{ "error, attempting to assign a transition to state" };
+					err_msg += std::to_string( st1_idx );
+					err_msg += strState( st1_idx );
+					err_msg += ", was previously declared as pass-state";
+					SPAG_P_THROW_ERROR_CFG( err_msg );
+				}
+			_table.setNext(    SPAG_P_CAST2IDX(ev), st1_idx, st2 );
+			_table.setAllowed( SPAG_P_CAST2IDX(ev), st1_idx, 1 );
 		}
 
-#ifdef SPAG_USE_SIGNALS
 /// Assigns a transition to a "pass-state" (AAT): once on state \c st1, the FSM will switch right away to \c st2
 /**
 \warning If a time out has previously been assigned to state \c st1, it will be removed
 
-\warning Only available when \ref SPAG_USE_SIGNALS is defined, see manual.
+\warning Only available when inner events are enabled (see FsmTraits::innerEvents and \ref SPAG_USE_SIGNALS), see manual.
 */
 		void assignAAT( ST st1, ST st2 )
 		{
-			auto st1_idx = SPAG_P_CAST2IDX(st1);
-			auto st2_idx = SPAG_P_CAST2IDX(st2);
-			SPAG_CHECK_LESS( st1_idx, nbStates() );
-			SPAG_CHECK_LESS( st2_idx, nbStates() );
-			if( st1 == st2 )
-				SPAG_P_THROW_ERROR_CFG(
-					"unable to assign an AAT to same states: S"
-					 + std::to_string( st1_idx ) + "and S" + std::to_string( st2_idx )
-				);
-
-			_transitionMat[ nbEvents()+1 ][st1_idx] = st2;
-			for( auto& line: _allowedMat ) // disable other transitions for that state
-				line[ st1_idx ] = 0;
-
-			auto& stinf = _stateInfo[st1_idx];
-			stinf._isPassState = true;
-
-			if( stinf._innerTransList.size() )
-				SPAG_P_LOG_ERROR << "warning, assign AAT transition from state "
-#ifdef SPAG_ENUM_STRINGS
-					<< st1_idx << " (" << _strStates[st1_idx] << ") to state "
-					<< st2_idx << " (" << _strStates[st2_idx] << ")"
-#else
-					<< st1_idx << " to state " << st2_idx
-#endif
-					<< " removes the "
-					<< stinf._innerTransList.size() << " inner transition(s) previously assigned to this state.\n";
-			stinf._innerTransList.clear();
-
-			auto& tev = stinf._timerEvent;
-			if( tev._enabled )
+			static_assert( useInnerEvents, "Error, this function is not available when FsmTraits::innerEvents is false (symbol SPAG_USE_SIGNALS not defined)" );
+			if constexpr( useInnerEvents )   // else, only the assertion above is reported
 			{
-				SPAG_P_LOG_ERROR << "warning, removal of timeout of "
-					<< tev._duration << ' ' << priv::stringFromTimeUnit( tev._durUnit )
-					<< " on state S" << std::setfill('0') << std::setw(2) << SPAG_P_CAST2IDX(st1)
-#ifdef SPAG_ENUM_STRINGS
-					<< " (" << _strStates[st1_idx] << ')'
-#endif
-					<< ".\n";
-				tev._enabled = false;
+				checkNotFinalized();
+				auto st1_idx = SPAG_P_CAST2IDX(st1);
+				auto st2_idx = SPAG_P_CAST2IDX(st2);
+				SPAG_CHECK_LESS( st1_idx, nbStates() );
+				SPAG_CHECK_LESS( st2_idx, nbStates() );
+				if( st1 == st2 )
+					SPAG_P_THROW_ERROR_CFG(
+						"unable to assign an AAT to same states: S"
+						 + std::to_string( st1_idx ) + "and S" + std::to_string( st2_idx )
+					);
+
+				_table.setNext( nbEvents()+1, st1_idx, st2 );
+				for( size_t i=0; i<nbEvents(); i++ ) // disable other transitions for that state
+					_table.setAllowed( i, st1_idx, 0 );
+
+				auto& stinf = _stateInfo[st1_idx];
+				stinf._isPassState = true;
+
+				if( stinf._innerMask.any() )
+					SPAG_P_LOG_ERROR << "warning, assign AAT transition from state "
+						<< st1_idx << strState( st1_idx ) << " to state "
+						<< st2_idx << strState( st2_idx )
+						<< " removes the "
+						<< stinf._innerMask.count() << " inner transition(s) previously assigned to this state.\n";
+				stinf._innerMask.reset();
+
+				auto& tev = stinf._timerEvent;
+				if( tev._enabled )
+				{
+					SPAG_P_LOG_ERROR << "warning, removal of timeout of "
+						<< tev._duration << ' ' << priv::stringFromTimeUnit( tev._durUnit )
+						<< " on state S" << std::setfill('0') << std::setw(2) << SPAG_P_CAST2IDX(st1)
+						<< strState( st1_idx )
+						<< ".\n";
+					tev._enabled = false;
+					_table.setTimeOutFlag( st1_idx, false );
+				}
 			}
 		}
 
 /// Assigns a inner transition between \c st1 and \c st2, triggered by internal event \c ev
-/// \warning Only available when \ref SPAG_USE_SIGNALS is defined, see manual.
+/// \warning Only available when inner events are enabled (see FsmTraits::innerEvents and \ref SPAG_USE_SIGNALS), see manual.
 		void assignInnerTransition( ST st1, EV iev, ST st2 )
 		{
-			auto st1_idx = SPAG_P_CAST2IDX(st1);
-			auto ev_idx  = SPAG_P_CAST2IDX(iev);
-			SPAG_CHECK_LESS( st1_idx,              nbStates() );
-			SPAG_CHECK_LESS( SPAG_P_CAST2IDX(st2), nbStates() );
-			SPAG_CHECK_LESS( ev_idx,               nbEvents() );
-
-			auto& stinf = _stateInfo[ st1_idx ];
-			if( stinf._isPassState )
-				SPAG_P_THROW_ERROR_CFG( "error, removing pass-state" ); /// \todo maybe a warning instead ?
-			stinf._isPassState = false;
-			stinf._innerTransList.push_back( priv::InnerTransition<ST,EV>(iev, st2) );
-			_innerEventFlag[iev] = false;
-			_transitionMat[ ev_idx ][st1_idx] = st2;
-			_allowedMat[    ev_idx ][st1_idx] = -1;
+			static_assert( useInnerEvents, "Error, this function is not available when FsmTraits::innerEvents is false (symbol SPAG_USE_SIGNALS not defined)" );
+			if constexpr( useInnerEvents )   // else, only the assertion above is reported
+			{
+				checkNotFinalized();
+				auto st1_idx = SPAG_P_CAST2IDX(st1);
+				auto ev_idx  = SPAG_P_CAST2IDX(iev);
+				SPAG_CHECK_LESS( st1_idx,              nbStates() );
+				SPAG_CHECK_LESS( SPAG_P_CAST2IDX(st2), nbStates() );
+				SPAG_CHECK_LESS( ev_idx,               nbEvents() );
+
+				auto& stinf = _stateInfo[ st1_idx ];
+				if( stinf._isPassState )
+					SPAG_P_THROW_ERROR_CFG( "error, removing pass-state" ); /// \todo maybe a warning instead ?
+				stinf._isPassState = false;
+				stinf._innerMask[ev_idx] = true;
+				_innerEventDecl[ev_idx] = true;
+				_table.setNext(    ev_idx, st1_idx, st2 );
+				_table.setAllowed( ev_idx, st1_idx, -1 );
+			}
 		}
 
 /// Whatever state we are on, when internal event \c iev occurs, we will switch to state \c st (except if we are already on that state).
@@ -962,24 +1770,26 @@ To remove afterwards the inner events on some states, use \c disableInnerTransit
 */
 		void assignInnerTransition( EV iev, ST st )
 		{
-			auto ev_idx = SPAG_P_CAST2IDX(iev);
-			auto st_idx = SPAG_P_CAST2IDX(st);
-			SPAG_CHECK_LESS( st_idx, nbStates() );
-			SPAG_CHECK_LESS( ev_idx, nbEvents() );
+			static_assert( useInnerEvents, "Error, this function is not available when FsmTraits::innerEvents is false (symbol SPAG_USE_SIGNALS not defined)" );
+			if constexpr( useInnerEvents )   // else, only the assertion above is reported
+			{
+				checkNotFinalized();
+				auto ev_idx = SPAG_P_CAST2IDX(iev);
+				auto st_idx = SPAG_P_CAST2IDX(st);
+				SPAG_CHECK_LESS( st_idx, nbStates() );
+				SPAG_CHECK_LESS( ev_idx, nbEvents() );
 
-			_innerEventFlag[iev] = false;
+				_innerEventDecl[ev_idx] = true;
 
-			assert( _stateInfo.size() == nbStates() );
-			for( size_t i=0; i<_stateInfo.size(); ++i )
-				if( i != st_idx )
-				{
-					if( !_stateInfo[i].holdsInnerTransition( iev, st ) )
+				assert( _stateInfo.size() == nbStates() );
+				for( size_t i=0; i<_stateInfo.size(); ++i )
+					if( i != st_idx )
 					{
-						_stateInfo[i]._innerTransList.push_back( priv::InnerTransition<ST,EV>( iev, st ) );
-						_transitionMat[ ev_idx ][i] = st;
-						_allowedMat   [ ev_idx ][i] = -1;
+						_stateInfo[i]._innerMask[ev_idx] = true;
+						_table.setNext(    ev_idx, i, st );
+						_table.setAllowed( ev_idx, i, -1 );
 					}
-				}
+			}
 		}
 
 /// Removes inner transition \c ev that is assigned on state \c st_from
@@ -991,36 +1801,28 @@ to remove this event on some states
 */
 		void disableInnerTransition( EV ev, ST st_from )
 		{
-			auto st_idx = SPAG_P_CAST2IDX(st_from);
-			auto& stinf = _stateInfo[st_idx];
-
-			auto it = stinf.findInnerEvent( ev );
-			if( it == std::end( stinf._innerTransList ) )
-				SPAG_P_THROW_ERROR_CFG( "state "
-					+ std::to_string( st_idx )
-#ifdef SPAG_ENUM_STRINGS
-					+ " (" + _strStates[st_idx] + ") "
-#endif
-					+ " has no inner transition"
-				);
-
-			stinf._innerTransList.erase( it );
-			_allowedMat[ev][st_from] = 0;
+			static_assert( useInnerEvents, "Error, this function is not available when FsmTraits::innerEvents is false (symbol SPAG_USE_SIGNALS not defined)" );
+			if constexpr( useInnerEvents )   // else, only the assertion above is reported
+			{
+				checkNotFinalized();
+				auto st_idx = SPAG_P_CAST2IDX(st_from);
+				auto ev_idx = SPAG_P_CAST2IDX(ev);
+				SPAG_CHECK_LESS( st_idx, nbStates() );
+				SPAG_CHECK_LESS( ev_idx, nbEvents() );
+				auto& stinf = _stateInfo[st_idx];
+
+				if( !stinf._innerMask[ev_idx] )
+					SPAG_P_THROW_ERROR_CFG( "state "
+						+ std::to_string( st_idx )
+						+ strState( st_idx )
+						+ " has no inner transition"
+					);
+
+				stinf._innerMask[ev_idx] = false;
+				_table.setAllowed( ev_idx, st_idx, 0 );
+			}
 		}
 
-#else // SPAG_USE_SIGNALS not defined
-
-		void assignInnerTransition( ST st1, EV ev, ST st2 )
-			SPAG_NOT_AVAILABLE(SPAG_USE_SIGNALS);
-		void assignInnerTransition( EV ev, ST st )
-			SPAG_NOT_AVAILABLE(SPAG_USE_SIGNALS);
-		void disableInnerTransition( EV, ST )
-			SPAG_NOT_AVAILABLE(SPAG_USE_SIGNALS);
-		void assignAAT( ST st1, ST st2 )
-			SPAG_NOT_AVAILABLE(SPAG_USE_SIGNALS);
-
-#endif // SPAG_USE_SIGNALS
-
 /// Assigns a timeout event leading to state \c st_final, on \b all states except \c st_final,
 /// using default timer unit and default timer duration value
 		void assignGlobalTimeOut( ST st_final )
@@ -1050,6 +1852,7 @@ After this, on all the states except \c st_final, if \c duration expires, the FS
 */
 		void assignGlobalTimeOut( Duration dur, DurUnit durUnit, ST st_final )
 		{
+			checkNotFinalized();
 			static_assert( std::is_same<TIM,priv::NoTimer<ST,EV,CBA>>::value == false, "Error, FSM type has no timer" );
 
 			for( size_t i=0; i<nbStates(); i++ )                                 // iterate on all the states
@@ -1057,28 +1860,20 @@ After this, on all the states except \c st_final, if \c duration expires, the FS
 				{
 					auto tev = _stateInfo[ SPAG_P_CAST2IDX( i ) ]._timerEvent;   // get its "timer event" data.
 
-#ifdef SPAG_USE_SIGNALS
-					if( _stateInfo[ SPAG_P_CAST2IDX( i ) ]._isPassState )        // if it has already been assigned an AAT, then
+					if( isPassState( i ) )                                       // if it has already been assigned an AAT, then
 					{                                                            //  issue a warning and process next one.
 						SPAG_P_LOG_ERROR << " warning: state " << i
-	#ifdef SPAG_ENUM_STRINGS
-							<< " (" << _strStates[i] << ')'
-	#endif
+							<< strState( i )
 							<< " is a pass state (holds an AAT), time out not assigned.\n";
 					}
 					else
-#endif
 					{
 						if( tev._enabled )
 						{
 							SPAG_P_LOG_ERROR << " warning, removal of previously assigned timeout leading from state " << i
-	#ifdef SPAG_ENUM_STRINGS
-								<< " (" << _strStates[i] << ')'
-	#endif
-								<< " to state " << tev._nextState
-	#ifdef SPAG_ENUM_STRINGS
-								<< " (" << _strStates.at( SPAG_P_CAST2IDX(tev._nextState)) << ')'
-	#endif
+								<< strState( i )
+								<< " to state " << tev.nextState()
+								<< strState( SPAG_P_CAST2IDX(tev.nextState()) )
 								<< " after " << tev._duration << ' ' << priv::stringFromTimeUnit( tev._durUnit ) << ".\n";
 						}
 						assignTimeOut( static_cast<ST>(i), dur, durUnit, st_final );
@@ -1095,13 +1890,18 @@ See setTimerDefaultValue() and setTimerDefaultUnit()
 */
 		void assignTimeOut( ST st_curr, ST st_next )
 		{
+			checkNotFinalized();
 			auto st_idx = SPAG_P_CAST2IDX( st_curr );
 			SPAG_CHECK_LESS( st_idx, nbStates() );
 			SPAG_CHECK_LESS( SPAG_P_CAST2IDX(st_next), nbStates() );
 			if( _stateInfo[ st_idx ]._timerEvent._enabled )         // if already one assigned,
-				_stateInfo[ st_idx ]._timerEvent._nextState = st_next;  // then just change the destination state
+				_stateInfo[ st_idx ]._timerEvent.setNextState( st_next );  // then just change the destination state
 			else
-				_stateInfo[ st_idx ]._timerEvent = priv::TimerEvent<ST>( st_next, _defaultTimerValue, _defaultTimerUnit );
+			{
+				auto& tev = _stateInfo[ st_idx ]._timerEvent;
+				tev = priv::TimerEvent<ST>( st_next, _defaultTimerValue, _defaultTimerUnit, tev._driftFree );
+			}
+			_table.setTimeOutFlag( st_idx, true );
 		}
 
 /// Assigns a timeout event on state \c st_curr, will switch to event \c st_next
@@ -1114,10 +1914,41 @@ See setTimerDefaultValue() and setTimerDefaultUnit()
 /// Assigns a timeout event on state \c st_curr, will switch to event \c st_next. With units
 		void assignTimeOut( ST st_curr, Duration dur, DurUnit unit, ST st_next )
 		{
+			checkNotFinalized();
 			static_assert( std::is_same<TIM,priv::NoTimer<ST,EV,CBA>>::value == false, "Error, FSM type has no timer" );
 			SPAG_CHECK_LESS( SPAG_P_CAST2IDX(st_curr), nbStates() );
 			SPAG_CHECK_LESS( SPAG_P_CAST2IDX(st_next), nbStates() );
-			_stateInfo[ SPAG_P_CAST2IDX( st_curr ) ]._timerEvent = priv::TimerEvent<ST>( st_next, dur, unit );
+			auto& tev = _stateInfo[ SPAG_P_CAST2IDX( st_curr ) ]._timerEvent;
+			tev = priv::TimerEvent<ST>( st_next, dur, unit, tev._driftFree );      // keeps the drift-free flag
+			_table.setTimeOutFlag( SPAG_P_CAST2IDX( st_curr ), true );
+		}
+
+/// Makes the timeout of state \c st drift-free (or not, if \c b is false). Default is not
+/**
+When the state is entered because the timeout of the previous state has expired, its own timeout is measured from
+the deadline of that previous timeout, instead of from the current time. So in a cycle of states switching on timeouts,
+the time spent in the callbacks and the scheduling latency of the event loop do not add up:
+the \c n-th switch happens at <code>start + n*duration</code>, and a late one does not delay the next ones.
+If the previous deadline is already too old (the callbacks took longer than the period), the timeout expires right away, so the missed
+switches are caught up.
+
+When the state is entered from an event (or from a pass state, processed later by the event loop), the timeout is measured from the current time.
+The flag is independent of the timeout itself: it can be set before or after assignTimeOut(), and is kept by clearTimeOut().
+This requires a timer class that supports it (\c AsioWrapper does, and \c WheelTimer is drift-free by design, see TimingWheel).
+*/
+		void setDriftFreeTimeOut( ST st, bool b = true )
+		{
+			checkNotFinalized();
+			SPAG_CHECK_LESS( SPAG_P_CAST2IDX(st), nbStates() );
+			_stateInfo[ SPAG_P_CAST2IDX( st ) ]._timerEvent._driftFree = b;
+		}
+
+/// Makes the timeouts of all the states drift-free (or not, if \c b is false), see setDriftFreeTimeOut()
+		void setDriftFreeTimeOuts( bool b = true )
+		{
+			checkNotFinalized();
+			for( size_t i=0; i<nbStates(); i++ )
+				_stateInfo[ i ]._timerEvent._driftFree = b;
 		}
 
 /// Assigns a timeout event on state \c st_curr, will switch to event \c st_next. With units as strings
@@ -1131,47 +1962,54 @@ See setTimerDefaultValue() and setTimerDefaultUnit()
 /// Removes all the timeouts
 		void clearTimeOuts()
 		{
+			checkNotFinalized();
 			static_assert( std::is_same<TIM,priv::NoTimer<ST,EV,CBA>>::value == false, "Error, FSM type has no timer" );
 			for( size_t i=0; i<nbStates(); i++ )
+			{
 				_stateInfo[ SPAG_P_CAST2IDX( i ) ]._timerEvent._enabled = false;
+				_table.setTimeOutFlag( i, false );
+			}
 		}
 /// Removes the timeout on state \c st
 		void clearTimeOut( ST st )
 		{
+			checkNotFinalized();
 			static_assert( std::is_same<TIM,priv::NoTimer<ST,EV,CBA>>::value == false, "Error, FSM type has no timer" );
 			auto st_idx = SPAG_P_CAST2IDX( st );
 			SPAG_CHECK_LESS( st_idx, nbStates() );
 			if( !_stateInfo[ st_idx ]._timerEvent._enabled )
 			{
 				SPAG_P_LOG_ERROR << "warning: asking for removal of timeout on state S" << st_idx
-#ifdef SPAG_ENUM_STRINGS
-					<< " (" << _strStates[st_idx]  << ')'
-#endif
+					<< strState( st_idx )
 					<< " but state has no timeout assigned.\n";
 			}
 			_stateInfo[ st_idx ]._timerEvent._enabled = false;
+			_table.setTimeOutFlag( st_idx, false );
 		}
 
 /// Whatever state we are on, if the (external) event \c ev occurs, we switch to state \c st.
 /// (Except for state \c st, of course)
 		void assignTransition( EV ev, ST st )
 		{
+			checkNotFinalized();
 			SPAG_CHECK_LESS( SPAG_P_CAST2IDX(st), nbStates() );
 			SPAG_CHECK_LESS( SPAG_P_CAST2IDX(ev), nbEvents() );
-			for( auto& s: _transitionMat[ ev ] ) // for all columns (=states) in the line "ev"
-					s = st;
-			for( size_t i=0; i<_allowedMat[ ev ].size(); i++ )
+			auto ev_idx = SPAG_P_CAST2IDX(ev);
+			for( size_t i=0; i<nbStates(); i++ ) // for all columns (=states) in the line "ev"
+				_table.setNext( ev_idx, i, st );
+			for( size_t i=0; i<nbStates(); i++ )
 				if( i != SPAG_P_CAST2IDX(st) )
-					_allowedMat[ ev ][ i ] = (i == SPAG_P_CAST2IDX(st) ? 0 : 1);
+					_table.setAllowed( ev_idx, i, (i == SPAG_P_CAST2IDX(st) ? 0 : 1) );
 		}
 
 /// Allow all events of the transition matrix
 /// \todo change this: for internal events, the value must not be 1
 		void allowAllEvents()
 		{
-			for( auto& line: _allowedMat )
-				for( auto& col: line )
-					col = 1;
+			checkNotFinalized();
+			for( size_t i=0; i<nbEvents(); i++ )
+				for( size_t j=0; j<nbStates(); j++ )
+					_table.setAllowed( i, j, 1 );
 		}
 
 /// Allow event \c ev when on state \c st
@@ -1181,31 +2019,35 @@ Thus it is also not usable for inner transitions.
 */
 		void allowEvent( ST st, EV ev, bool what=true )
 		{
+			checkNotFinalized();
 			auto st_idx = SPAG_P_CAST2IDX(st);
 			SPAG_CHECK_LESS( st_idx, nbStates() );
 			SPAG_CHECK_LESS( SPAG_P_CAST2IDX(ev), nbEvents() );
 
-#ifdef SPAG_USE_SIGNALS
-			if( _stateInfo[st_idx].holdsInnerTransition( ev, st ) )
-				throw std::runtime_error( "usage of allowEvent() not possible for inner events" );
-#endif // SPAG_USE_SIGNALS
+			if constexpr( useInnerEvents )
+				if( _stateInfo[st_idx]._innerMask[ SPAG_P_CAST2IDX(ev) ] )
+					throw std::runtime_error( "usage of allowEvent() not possible for inner events" );
 
-			_allowedMat[ SPAG_P_CAST2IDX(ev) ][ st_idx ] = (what?1:0);
+			_table.setAllowed( SPAG_P_CAST2IDX(ev), st_idx, (what?1:0) );
 		}
 
 /// Assigns a callback function to a state, will be called each time we arrive on this state
 		void assignCallback( ST st, Callback_t func, CBA cb_arg=CBA() )
 		{
+			checkNotFinalized();
+			static_assert( !hasCbHandler, "Error, with HandlerCallback policy, use assignCallbackHandler() and assignCallbackValue()" );
 			auto st_idx = SPAG_P_CAST2IDX(st);
 			SPAG_CHECK_LESS( st_idx, nbStates() );
-			_stateInfo[ st_idx ]._callback    = func;
-			_stateInfo[ st_idx ]._callbackArg = cb_arg;
+			_stateInfo[ st_idx ]._callback    = std::move( func );
+			_stateInfo[ st_idx ]._callbackArg = std::move( cb_arg );
 		}
 
 /// Assigns a callback function to all the states, will be called each time the state is activated
 		void assignCallback( Callback_t func )
 		{
+			checkNotFinalized();
 //			static_assert( std::is_same<Callback_t,CBA>::value, "Callback function is not of same type as the one declared in FSM" );
+			static_assert( !hasCbHandler, "Error, with HandlerCallback policy, use assignCallbackHandler()" );
 			for( size_t i=0; i<nbStates(); i++ )
 				_stateInfo[ SPAG_P_CAST2IDX(i) ]._callback = func;
 		}
@@ -1217,10 +2059,12 @@ See https://en.cppreference.com/w/cpp/types/numeric_limits/is_integer
 */
 		void assignCallbackAutoval( Callback_t func )
 		{
+			checkNotFinalized();
 			static_assert(
 				(std::numeric_limits<CBA>::is_integer || std::is_same<CBA,std::string>::value),
 				"To use this, Callback function argument MUST be an integer type, or a std::string"
 			);
+			static_assert( !hasCbHandler, "Error, with HandlerCallback policy, use assignCallbackHandler() and assignCallbackValue()" );
 			if constexpr( std::is_same<CBA,std::string>::value )
 			{
 				for( size_t i=0; i<nbStates(); i++ )
@@ -1246,40 +2090,56 @@ See https://en.cppreference.com/w/cpp/types/numeric_limits/is_integer
 /// Assigns a callback function called when an ignored event occurs
 		void assignIgnoredEventsCallback( std::function<void(ST,EV)> func )
 		{
+			checkNotFinalized();
 			_ignEventCallback = func;
 		}
 
 /// Assigns the callback function value \c cb_arg, for state \c st
+/**
+The value is moved in, so a large value can be passed with \c std::move() without any copy.
+*/
 		void assignCallbackValue( ST st, CBA cb_arg )
+		{
+			checkNotFinalized();
+			SPAG_CHECK_LESS( SPAG_P_CAST2IDX(st), nbStates() );
+			_stateInfo[ SPAG_P_CAST2IDX(st) ]._callbackArg = std::move( cb_arg );
+		}
+
+/// Returns the callback function value assigned to state \c st
+		const CBA& callbackValue( ST st ) const
 		{
 			SPAG_CHECK_LESS( SPAG_P_CAST2IDX(st), nbStates() );
-			_stateInfo[ SPAG_P_CAST2IDX(st) ]._callbackArg = cb_arg;
+			return _stateInfo[ SPAG_P_CAST2IDX(st) ]._callbackArg;
+		}
+
+/// Assigns the callback handler object, that will be called on every state entry (only with the HandlerCallback policy, see FsmTraits)
+		void assignCallbackHandler( CbHandler_t* h )
+		{
+			checkNotFinalized();
+			static_assert( hasCbHandler, "Error, callback policy is not HandlerCallback" );
+			_cbHandler = h;
 		}
 
 #ifndef SPAG_EMBED_ASIO_WRAPPER
 		void assignEventHandler( TIM* t )
 		{
 			static_assert( std::is_same<TIM,priv::NoTimer<ST,EV,CBA>>::value == false, "Error, FSM type has no timer" );
-			_eventHandler = t;
+			_rs._eventHandler = t;
 		}
 #endif
 
 /// Assign configuration from other FSM
 		void assignConfig( const SpagFSM& fsm )
 		{
+			checkNotFinalized();
 			SPAG_CHECK_EQUAL( nbEvents(), fsm.nbEvents() );
 			SPAG_CHECK_EQUAL( nbStates(), fsm.nbStates() );
-			_transitionMat = fsm._transitionMat;
-			_allowedMat    = fsm._allowedMat;
+			_table         = fsm._table;
 			_stateInfo     = fsm._stateInfo;
-#ifdef SPAG_ENUM_STRINGS
 			_strEvents     = fsm._strEvents;
 			_strStates     = fsm._strStates;
-#endif
 		}
 
-#ifdef SPAG_ENUM_STRINGS
-
 	private:
 /// parses the strings and returns false if one of the strings is present more than once
 #if 1
@@ -1307,304 +2167,330 @@ See https://en.cppreference.com/w/cpp/types/numeric_limits/is_integer
 		}
 #endif
 	public:
-/// Assign a string to an enum event value (available only if option SPAG_ENUM_STRINGS is enabled)
+/// Assign a string to an enum event value (does nothing if enum strings are disabled, see FsmTraits::enumStrings)
 /// \todo Replace the assert with something more user-friendly (same with the other functions)
 		void assignString2Event( EV ev, std::string str )
 		{
-			SPAG_CHECK_LESS( SPAG_P_CAST2IDX(ev), nbEvents() );
-			_strEvents[ SPAG_P_CAST2IDX(ev) ] = str;
-			assert( checkUnicity( _strEvents ) );
+			if constexpr( useEnumStrings )
+			{
+				checkNotFinalized();
+				SPAG_CHECK_LESS( SPAG_P_CAST2IDX(ev), nbEvents() );
+				_strEvents[ SPAG_P_CAST2IDX(ev) ] = str;
+				assert( checkUnicity( _strEvents ) );
+			}
 		}
-/// Assign a string to an enum state value (available only if option SPAG_ENUM_STRINGS is enabled)
+/// Assign a string to an enum state value (does nothing if enum strings are disabled, see FsmTraits::enumStrings)
 		void assignString2State( ST st, std::string str )
 		{
-			SPAG_CHECK_LESS( SPAG_P_CAST2IDX(st), nbStates() );
-			_strStates[ SPAG_P_CAST2IDX(st) ] = str;
-			assert( checkUnicity( _strStates ) );
+			if constexpr( useEnumStrings )
+			{
+				checkNotFinalized();
+				SPAG_CHECK_LESS( SPAG_P_CAST2IDX(st), nbStates() );
+				_strStates[ SPAG_P_CAST2IDX(st) ] = str;
+				assert( checkUnicity( _strStates ) );
+			}
 		}
-/// Assign strings to enum event values (available only if option SPAG_ENUM_STRINGS is enabled)
+/// Assign strings to enum event values (does nothing if enum strings are disabled)
 		void assignStrings2Events( const std::vector<std::pair<EV,std::string>>& v_str )
 		{
 			SPAG_CHECK_LESS( v_str.size(), nbEvents()+1 );
 			for( const auto& p: v_str )
 				assignString2Event( p.first, p.second );
-			assert( checkUnicity( _strEvents ) );
 		}
-/// Assign strings to enum state values (available only if option SPAG_ENUM_STRINGS is enabled)
+/// Assign strings to enum state values (does nothing if enum strings are disabled)
 		void assignStrings2States( const std::vector<std::pair<ST,std::string>>& v_str )
 		{
 			SPAG_CHECK_LESS( v_str.size(), nbStates()+1 );
 			for( const auto& p: v_str )
 				assignString2State( p.first, p.second );
-			assert( checkUnicity( _strStates ) );
 		}
-/// Assign strings to enum event values (available only if option SPAG_ENUM_STRINGS is enabled) - overload 1
-		void assignStrings2Events( std::map<EV,std::string>& m_str )
+/// Assign strings to enum event values (does nothing if enum strings are disabled) - overload 1
+		void assignStrings2Events( const std::map<EV,std::string>& m_str )
 		{
 			for( const auto& p: m_str )
 				assignString2Event( p.first, p.second );
-			assert( checkUnicity( _strEvents ) );
 		}
-/// Assign strings to enum state values (available only if option SPAG_ENUM_STRINGS is enabled) - overload 1
-		void assignStrings2States( std::map<ST,std::string>& m_str )
+/// Assign strings to enum state values (does nothing if enum strings are disabled) - overload 1
+		void assignStrings2States( const std::map<ST,std::string>& m_str )
 		{
 			for( const auto& p: m_str )
 				assignString2State( p.first, p.second );
-			assert( checkUnicity( _strStates ) );
 		}
 /// Assigns to callback functions an argument value that is the state name (requires that callback argument is a string)
+/// Does nothing if enum strings are disabled.
 		void assignCBValuesStrings()
 		{
-			static_assert( std::is_same<CBA,std::string>::value, "Error, unable to assign strings to callback values, callback type is not std::string\n" );
-			for( size_t i=0; i<nbStates(); i++ )
-				assignCallbackValue( static_cast<ST>(i), _strStates[i] );
+			if constexpr( useEnumStrings )
+			{
+				checkNotFinalized();
+				static_assert( std::is_same<CBA,std::string>::value, "Error, unable to assign strings to callback values, callback type is not std::string\n" );
+				for( size_t i=0; i<nbStates(); i++ )
+					assignCallbackValue( static_cast<ST>(i), _strStates[i] );
+			}
 		}
-/// Returns the string label associated with event \c ev
+/// Returns the string label associated with event \c ev (or its index, if enum strings are disabled)
 		std::string getString( EV ev ) const
 		{
-			return _strEvents[ev];
+			if constexpr( useEnumStrings )
+				return _strEvents[ SPAG_P_CAST2IDX(ev) ];
+			else
+				return std::to_string( SPAG_P_CAST2IDX(ev) );
 		}
-/// Returns the string label associated with state \c st
+/// Returns the string label associated with state \c st (or its index, if enum strings are disabled)
 		std::string getString( ST st ) const
 		{
-			return _strStates[st];
+			if constexpr( useEnumStrings )
+				return _strStates[ SPAG_P_CAST2IDX(st) ];
+			else
+				return std::to_string( SPAG_P_CAST2IDX(st) );
 		}
-#else
-		void assignString2Event( EV, std::string ) {}
-		void assignString2State( ST, std::string ) {}
-		void assignStrings2Events( const std::vector<std::pair<EV,std::string>>& ) {}
-		void assignStrings2States( const std::vector<std::pair<ST,std::string>>& ) {}
-		void assignStrings2Events( const std::map<EV,std::string>& ) {}
-		void assignStrings2States( const std::map<ST,std::string>& ) {}
-		void assignCBValuesStrings() const {}
-		std::string getString( EV ev ) const { return std::to_string( SPAG_P_CAST2IDX(ev) ); }
-		std::string getString( ST st ) const { return std::to_string( SPAG_P_CAST2IDX(st) ); }
-#endif
 
 ///@}
 
-/** \name Run time functions */
-///@{
-/// start FSM : run callback associated to initial state (if any), an run timer (if any)
-		void start()
+/// Checks and freezes the configuration
+/**
+Optional: if not called, start() checks the configuration and the FSM stays configurable.
+Once called, all the configuration member functions (\c assign*(), \c allow*(), \c clear*(), ...) throw,
+and start() does not check the configuration again.
+
+- runs the configuration checks (see doChecking()),
+- with inner events (see FsmTraits::innerEvents), checks that no pass-state leads to a cycle of pass-states
+  (the FSM would switch forever), and that inner events are not allowed as external events on some state,
+- with FsmTraits::collapseAAT, computes for each state where its chain of pass states without callback leads (see buildPassChains()),
+- packs the transition table: only SparseTable does something (it releases its unused memory).
+
+The inner event masks and the timeout durations are computed when assigned, so there is nothing else to precompute.
+Once finalized, processEvent() does not need to check if the event is an inner event,
+this is done only when the event is ignored. Calling it again does nothing.
+*/
+		void finalize()
 		{
-			SPAG_P_ASSERT( !_isRunning, "attempt to start an already running FSM" );
-			SPAG_LOG << "start FSM\n";
+			SPAG_P_ASSERT( !_rs._isRunning, "attempt to finalize a running FSM" );
+			if( _isFinalized )
+				return;
+			SPAG_LOG << "finalize FSM\n";
 			doChecking();
-
-			_isRunning = true;
-			runAction();
-
-#ifndef SPAG_EXTERNAL_EVENT_LOOP
-			if( !std::is_same<TIM,priv::NoTimer<ST,EV,CBA>>::value )
+			if constexpr( useInnerEvents )
 			{
-				SPAG_P_ASSERT( _eventHandler, "Event handler has not been allocated" );
-				_eventHandler->init( this );   // blocking function !
+				checkPassStateCycles();
+				checkInnerEventsNotAllowed();
+				if constexpr( useCollapseAAT )
+					buildPassChains();
 			}
-#endif
+			_table.pack();
+			_isFinalized = true;
+		}
+
+/// Returns true if the configuration has been frozen with finalize()
+		bool isFinalized() const
+		{
+			return _isFinalized;
+		}
+
+/** \name Run time functions */
+///@{
+/// start FSM : run callback associated to initial state (if any), an run timer (if any)
+		void start()
+		{
+			SPAG_P_ASSERT( !_rs._isRunning, "attempt to start an already running FSM" );
+			SPAG_LOG << "start FSM\n";
+			if( !_isFinalized )
+				doChecking();
+			start( _rs, this );
 		}
 
 /// stop FSM : needed only if timer is used, this will cancel (and kill) the pending timer
 		void stop() const
 		{
-			SPAG_P_ASSERT( _isRunning, "attempt to stop an already stopped FSM" );
-
-			if( _eventHandler )
-			{
-				SPAG_LOG << "call timerCancel()\n";
-				_eventHandler->timerCancel();
-				SPAG_LOG << "call event loop kill()\n";
-				_eventHandler->kill();
-			}
-			_isRunning = false;
+			stop( _rs );
 		}
 
 /// User-code timer end function/callback should call this when the timer expires
 		void processTimeOut() const
 		{
-			SPAG_P_START;
-			SPAG_LOG << "processing timeout event, delay was " << _stateInfo[ _current ]._timerEvent._duration << "\n";
-			assert( _stateInfo[ SPAG_P_CAST2IDX(_current) ]._timerEvent._enabled ); // or else, the timer shouldn't have been started, and thus we shouldn't be here...
-			_previous = _current;
-			_current = _stateInfo[ SPAG_P_CAST2IDX( _current ) ]._timerEvent._nextState;
-#ifdef SPAG_ENABLE_LOGGING
-			_rtdata.logTransition( _current, nbEvents() );
-#endif
-			runAction();
-			SPAG_P_END;
+			processTimeOut( _rs, this );
 		}
 
 /// User-code should call this function when an external event occurs
 		void processEvent( EV ev ) const
 		{
-			SPAG_P_START;
+			processEvent( _rs, this, ev );
+		}
 
-			SPAG_CHECK_LESS( SPAG_P_CAST2IDX(ev), nbEvents() );
-			SPAG_P_ASSERT( _isRunning, "attempting to process an event but FSM is not started" );
+/// Processes all the external events in the range [first,last), in sequence
+/**
+Same as calling processEvent() for each of them (same callbacks, timer calls and logging), but the
+validity checks are done once for the whole range, before processing the first event.
 
-			auto ev_idx = SPAG_P_CAST2IDX( ev );
-			if( isInnerEvent(ev) )
-				SPAG_P_THROW_ERROR_RT(
-					std::string( "request to process event idx=" )
-					+ std::to_string( ev_idx )
-				#ifdef SPAG_ENUM_STRINGS
-					+ std::string( " (" ) + _strEvents[ev_idx] + std::string( ")" )
-				#endif
-					+ std::string( " but event has been declared as inner event." )
-				);
+If \c trace is not null, the state reached after each event is written in it, so it must be able to hold
+<code>last-first</code> values.
 
-#ifdef SPAG_ENUM_STRINGS
-			SPAG_LOG << "processing event " << ev_idx << ": \"" << _strEvents[ev_idx] << "\"\n";
-#else
-			SPAG_LOG << "processing event " << ev_idx << '\n';
-#endif
-			if( _allowedMat[ ev_idx ][ SPAG_P_CAST2IDX(_current) ] == 1 )
-			{
-				if( _stateInfo[ SPAG_P_CAST2IDX( _current ) ]._timerEvent._enabled )  // 1 - cancel the waiting timer, if any
-				{
-					SPAG_P_ASSERT( _eventHandler, "Event handler has not been allocated" );
-					_eventHandler->timerCancel();
-				}
-				_previous = _current;
-				_current = _transitionMat[ ev_idx ][ SPAG_P_CAST2IDX(_current) ];     // 2 - switch to next state
-#ifdef SPAG_ENABLE_LOGGING
-				_rtdata.logTransition( _current, ev_idx );
-#endif
-				runAction();                                                          // 3 - call the callback function
-			}
-			else
-			{
-				SPAG_LOG << "event is ignored on current state\n";
-				if( _ignEventCallback )
-					_ignEventCallback( _current, ev );
+Returns the number of events processed: if a callback stops the FSM, the remaining events are not processed.
+*/
+		size_t processEvents( const EV* first, const EV* last, ST* trace=nullptr ) const
+		{
+			return processEvents( _rs, this, first, last, trace );
+		}
 
-#ifdef SPAG_ENABLE_LOGGING
-				_rtdata.logIgnoredEvent( ev_idx );
-#endif
-			}
-			SPAG_P_END;
+/// Processes all the external events of the contiguous container \c events (\c std::vector, \c std::array, ...).
+/// See the other overload.
+		template<typename CONT>
+		size_t processEvents( const CONT& events, ST* trace=nullptr ) const
+		{
+			return processEvents( std::data(events), std::data(events) + std::size(events), trace );
 		}
 
-#ifdef SPAG_USE_SIGNALS
-/// Activate inner event: set the inner event to true, so that a signal will be raised
+/// Posts the external event \c ev: to be used in the callback functions, instead of processEvent()
+/**
+When called while an event is being processed (that is, from a callback), the event is queued, and will be processed
+once the current transition has completed, in the order they have been posted (run-to-completion).
+Thus there is no recursion, whatever the number of events posted by the successive callbacks.
+When called from elsewhere, this is the same as processEvent().
+
+The queue has a fixed capacity, given by FsmTraits::postQueueSize (no memory allocation). If it is full, throws a \c std::runtime_error.
+If a callback stops the FSM, the remaining posted events are dropped.
+*/
+		void postEvent( EV ev ) const
+		{
+			postEvent( _rs, this, ev );
+		}
+
+/// Pushes the external event \c ev in the input queue: to be used by the threads that do not run the event loop, instead of processEvent()
+/**
+This is the only run-time function that can be called from any thread: the event is checked, then stored in a lock-free queue,
+and will be processed by the thread running the event loop, with processPushedEvents().
+If the timer class provides a member function <code>wakeUp( const FSM* )</code> (AsioWrapper does), it is called
+so that the event loop does it as soon as possible. Else, the loop must call processPushedEvents() periodically.
+
+The queue has a fixed capacity, given by FsmTraits::inputQueueSize. If it is full, the event is dropped and the function
+returns false, or it waits until some room has been made, depending on FsmTraits::inputQueuePolicy.
+\warning With QueueFullPolicy::Block, calling this from the thread running the event loop (say, from a callback)
+can block forever: use postEvent() instead.
+*/
+		bool pushEvent( EV ev ) const
+		{
+			return pushEvent( _rs, this, ev );
+		}
+
+/// Processes, in order, all the events pushed with pushEvent(). Returns the number of processed events.
+/**
+Must be called by the thread running the event loop: it is called by the timer class if it provides a
+\c wakeUp() function, else the event loop must call it periodically.
+If the FSM is stopped, the remaining events stay in the queue.
+*/
+		size_t processPushedEvents() const
+		{
+			return processPushedEvents( _rs, this );
+		}
+
+/// Returns the number of events that have been dropped by pushEvent() because the input queue was full
+		size_t nbDroppedEvents() const
+		{
+			static_assert( useInputQueue, "Error, FsmTraits::inputQueueSize is 0" );
+			return _rs._input.nbDropped();
+		}
+
+/// Activate inner event: set the inner event to true, so that it will be processed (deferred, by the event loop)
 /// when we are on a state that has the event enabled as inner transition
 /// (and once callback has been completed).
 /**
-\warning Only available when \ref SPAG_USE_SIGNALS is defined, see manual.
+The flag is set atomically, with release ordering: what the calling thread has written before the call
+is visible to the callbacks of the transition it triggers.
+
+If the current state has this inner transition, it is processed right away, without waiting for the next event:
+- if the timer class has a \c postInnerEvent() member function (AsioWrapper does), a handler is posted in the event loop,
+that processes the inner event if the current state has an active one. The current state is checked there because only the thread
+running the event loop can read it safely. As <code>io_context::post()</code> is thread-safe, this function
+can then be called from any thread (for example, threads reading sensors).
+- else, the processing is requested with \c raiseSignal(), or done by the FSM itself (see drainInnerEvents()).
+This function must then be called by the thread running the FSM. If called from a callback, the processing is requested
+by runAction() once the callback has completed.
+
+\warning Only available when inner events are enabled (see FsmTraits::innerEvents), see manual.
 \todo implement "early quit" (as soon as found)
-\todo check if one of the states on which we activate the event is the current one. If so,
-then we need to raise the signal right away! (instead of waiting)
 */
 		void activateInnerEvent( EV ev )
 		{
-			SPAG_P_START;
-
-			if( !isInnerEvent( ev ) )
-				throw std::runtime_error(
-					"request to activate inner event "
-					+ std::to_string( SPAG_P_CAST2IDX(ev) )
-#ifdef SPAG_ENUM_STRINGS
-					+ " (" + _strEvents[ SPAG_P_CAST2IDX(ev) ] + ")"
-#endif
-					+ ", but not found in list of Internal Events"
-				);
-
-			_innerEventFlag[ ev ] = true;
-			SPAG_LOG << "activating event " << SPAG_P_CAST2IDX(ev)
-#ifdef SPAG_ENUM_STRINGS
-				<< " (" << _strEvents[ SPAG_P_CAST2IDX(ev) ] << ')'
-#endif
-				<< " current state is " << (int)currentState()
-#ifdef SPAG_ENUM_STRINGS
-				<< " (" << _strStates[ currentState() ] << ')'
-#endif
-				<< '\n';
-
-			SPAG_P_END;
+			static_assert( useInnerEvents, "Error, this function is not available when FsmTraits::innerEvents is false (symbol SPAG_USE_SIGNALS not defined)" );
+			if constexpr( useInnerEvents )   // else, only the assertion above is reported
+			{
+				SPAG_P_START;
+
+				if( !isInnerEvent( ev ) )
+					throw std::runtime_error(
+						"request to activate inner event "
+						+ std::to_string( SPAG_P_CAST2IDX(ev) )
+						+ strEvent( SPAG_P_CAST2IDX(ev) )
+						+ ", but not found in list of Internal Events"
+					);
+
+				_innerEventActive.set( SPAG_P_CAST2IDX(ev) );
+				SPAG_LOG << "activating event " << SPAG_P_CAST2IDX(ev)
+					<< strEvent( SPAG_P_CAST2IDX(ev) )
+					<< '\n';
+
+				if constexpr( priv::HasPostInnerEvent<TIM,SpagFSM>::value )
+				{
+					if( _rs._eventHandler )
+						_rs._eventHandler->postInnerEvent( this );
+				}
+				else if( _rs._isRunning && !_rs._isProcessing && _stateInfo[ SPAG_P_CAST2IDX(_rs._current) ]._innerMask[ SPAG_P_CAST2IDX(ev) ] )
+				{
+					SPAG_LOG << "current state " << SPAG_P_CAST2IDX(_rs._current) << " has this inner transition\n";
+					runToCompletion( _rs, this, [&](){ deferInnerEvent( _rs, this ); } );  // lambda
+				}
+				SPAG_P_END;
+			}
 		}
 
 /// Deactivate an inner event. Will issue a warning if the event is presently not active
 		void clearInternalEvent( EV ev )
 		{
-			if( !isInnerEvent( ev ) )
-				throw std::runtime_error(
-					"request to clear inner event "
-					+ std::to_string( SPAG_P_CAST2IDX(ev) )
-#ifdef SPAG_ENUM_STRINGS
-					+ " (" + _strEvents[ SPAG_P_CAST2IDX(ev) ] + ")"
-#endif
-					+ ", but not found in list of Internal Events"
-				);
-
-			if( _innerEventFlag[ ev ] == false )
-				SPAG_P_LOG_ERROR << "warning, request to clear inner event idx=" << SPAG_P_CAST2IDX(ev)
-#ifdef SPAG_ENUM_STRINGS
-					<< " (" + _strEvents[ SPAG_P_CAST2IDX(ev) ] + ")"
-#endif
-					<< ", but event was not active.\n";
-
-			_innerEventFlag[ ev ] = false;
-			SPAG_LOG << "deactivating event " << SPAG_P_CAST2IDX(ev)
-#ifdef SPAG_ENUM_STRINGS
-				<< " (" << _strEvents[ SPAG_P_CAST2IDX(ev) ] << ')'
-#endif
-				<< " current state is " << (int)currentState()
-#ifdef SPAG_ENUM_STRINGS
-				<< " (" << _strStates[ currentState() ] << ')'
-#endif
-				<< ".\n";
+			static_assert( useInnerEvents, "Error, this function is not available when FsmTraits::innerEvents is false (symbol SPAG_USE_SIGNALS not defined)" );
+			if constexpr( useInnerEvents )   // else, only the assertion above is reported
+			{
+				if( !isInnerEvent( ev ) )
+					throw std::runtime_error(
+						"request to clear inner event "
+						+ std::to_string( SPAG_P_CAST2IDX(ev) )
+						+ strEvent( SPAG_P_CAST2IDX(ev) )
+						+ ", but not found in list of Internal Events"
+					);
+
+				if( !_innerEventActive.reset( SPAG_P_CAST2IDX(ev) ) )
+					SPAG_P_LOG_ERROR << "warning, request to clear inner event idx=" << SPAG_P_CAST2IDX(ev)
+						<< strEvent( SPAG_P_CAST2IDX(ev) )
+						<< ", but event was not active.\n";
+
+				SPAG_LOG << "deactivating event " << SPAG_P_CAST2IDX(ev)
+					<< strEvent( SPAG_P_CAST2IDX(ev) )
+					<< " current state is " << (int)currentState()
+					<< strState( SPAG_P_CAST2IDX(currentState()) )
+					<< ".\n";
+			}
 		}
 
-/// This is to be called by event loop wrapper, by the signal handler.
+/// This is to be called by event loop wrapper, by the handler of the deferred inner events.
 /// <strong>DO NOT CALL in user code</strong>.
 /**
 \todo 20260717: Then, why not private?
-This function will be called by the signal handler of the event handler class ONLY (see AsioWrapper::signalHandler() )
-\warning Only available when \ref SPAG_USE_SIGNALS is defined, see manual.
+This function will be called by the event handler class ONLY (see AsioWrapper::postInnerEvent() ),
+or by its signal handler if it uses \c raiseSignal(). If the timer class has none of these,
+the FSM calls it itself, see drainInnerEvents().
+Never called if inner events are disabled (see FsmTraits::innerEvents).
 */
-		void processInnerEvent( const priv::StateInfo<ST,EV,CBA>& stinf ) const
+		void processInnerEvent( const StateInfo_t& stinf ) const
 		{
-			SPAG_P_START;
-
-			SPAG_P_ASSERT( _isRunning, "attempting to process an inner event but FSM is not started" );
-#ifdef SPAG_ENABLE_LOGGING
-			size_t ev_idx = nbEvents() + 1;
-#endif
-			if( stinf._isPassState )
+			if constexpr( !useInnerEvents )
 			{
-				auto next = _transitionMat[ nbEvents()+1 ][_current];
-				SPAG_LOG << "is pass state, switch from state " << (int)currentState() << " to state " << (int)next << '\n';
-				_previous = _current;
-				_current  = next;
+				(void)stinf;
+				assert( 0 );
 			}
 			else
 			{
-				for( const auto& innerTrans: stinf._innerTransList )
-				{
-					if( !isInnerEvent( innerTrans._innerEvent ) )       // step 1: check that the event is correctly registered in map
-						SPAG_P_THROW_ERROR_RT( "Unable to find inner event" );     /// \todo expand user message
-
-
-					if( _innerEventFlag[ innerTrans._innerEvent ] )   // step 2 : check if given event assigned has been activated
-					{
-						_previous = _current;
-						_current = innerTrans._destState;
-#ifdef SPAG_ENABLE_LOGGING
-						ev_idx   = innerTrans._innerEvent;
-#endif
-						_innerEventFlag[ innerTrans._innerEvent ] = false;       // deactivate event
-					}
-				}
+				processInnerEvent( _rs, this, stinf );
 			}
-//			SPAG_LOG << "stinf:\n" << stinf << '\n';
-
-#ifdef SPAG_ENABLE_LOGGING
-			_rtdata.logTransition( _current, ev_idx );
-#endif
-			runAction();                                                          // 3 - call the callback function
-			SPAG_P_END;
 		}
-#endif // SPAG_USE_SIGNALS
 ///@}
 
 /** \name Misc. helper functions */
@@ -1624,17 +2510,18 @@ This function will be called by the signal handler of the event handler class ON
 /// Return current state
 		ST currentState() const
 		{
-			return _current;
+			return _rs._current;
 		}
 /// Return previous state (or initial state upon start() )
 		ST previousState() const
 		{
-			return _previous;
+			return _rs._previous;
 		}
 
-#ifdef SPAG_ENUM_STRINGS
+/// Returns the index of the state having string \c str (requires enum strings, see FsmTraits::enumStrings)
 		size_t getStateIndex( std::string str ) const
 		{
+			static_assert( useEnumStrings, "Error, this function is not available when FsmTraits::enumStrings is false (symbol SPAG_ENUM_STRINGS not defined)" );
 			auto it = std::find(
 				std::begin(_strStates),
 				std::end(_strStates),
@@ -1645,8 +2532,10 @@ This function will be called by the signal handler of the event handler class ON
 			return it - std::begin(_strStates);
 		}
 
+/// Returns the index of the event having string \c str (requires enum strings, see FsmTraits::enumStrings)
 		size_t getEventIndex( std::string str ) const
 		{
+			static_assert( useEnumStrings, "Error, this function is not available when FsmTraits::enumStrings is false (symbol SPAG_ENUM_STRINGS not defined)" );
 			auto it = std::find(
 				std::begin(_strEvents),
 				std::end(_strEvents),
@@ -1656,8 +2545,12 @@ This function will be called by the signal handler of the event handler class ON
 				SPAG_P_THROW_ERROR_RT("invalid event string" );
 			return it - std::begin(_strEvents);
 		}
-#endif
-		priv::StateInfo<ST,EV,CBA>& getStateInfo( size_t idx )
+		StateInfo_t& getStateInfo( size_t idx )
+		{
+			assert( idx < nbStates() );
+			return _stateInfo[idx];
+		}
+		const StateInfo_t& getStateInfo( size_t idx ) const
 		{
 			assert( idx < nbStates() );
 			return _stateInfo[idx];
@@ -1673,29 +2566,42 @@ This function will be called by the signal handler of the event handler class ON
 			);
 		}
 
+/// Return duration of time out for state \c st as a \c std::chrono duration (computed when the timeout is assigned)
+		std::chrono::nanoseconds timeOutChrono( ST st ) const
+		{
+			assert( SPAG_P_CAST2IDX(st) < nbStates() );
+			return _stateInfo[ SPAG_P_CAST2IDX(st) ]._timerEvent._chrono;
+		}
+
+/// Returns true if the timeout of state \c st is measured from the previous deadline, see setDriftFreeTimeOut()
+		bool isDriftFreeTimeOut( ST st ) const
+		{
+			assert( SPAG_P_CAST2IDX(st) < nbStates() );
+			return _stateInfo[ SPAG_P_CAST2IDX(st) ]._timerEvent._driftFree;
+		}
+
 		void printConfig( std::ostream& str, const char* msg=nullptr ) const;
 
-#ifdef SPAG_ENABLE_LOGGING
-/// Assigns a new name for the output log file (default is spaghetti.csv)
+/// Assigns a new name for the output log file (default is spaghetti.csv). Does nothing if logging is disabled (see FsmTraits::logging)
 		void setLogFileName( std::string fn ) const
 		{
 			assert( !fn.empty() );
-			_rtdata._logfileName = fn;
+			if constexpr( useLogging )
+				_rtdata._logfileName = fn;
 		}
 
+/// Returns the run-time counters (requires logging, see FsmTraits::logging)
 		Counters getCounters() const
 		{
+			static_assert( useLogging, "Error, this function is not available when FsmTraits::logging is false (symbol SPAG_ENABLE_LOGGING not defined)" );
 			return _rtdata.buildCounters();
 		}
+/// Clears the run-time counters. Does nothing if logging is disabled
 		void clearCounters()
 		{
-			_rtdata.clear();
+			if constexpr( useLogging )
+				_rtdata.clear();
 		}
-#else
-		void setLogFilename( std::string fn ) const {}
-//		Counters getCounters() const {}
-//		void clearCounters() {}
-#endif // SPAG_ENABLE_LOGGING
 
 /// Sets the timer defaults.
 		template<typename T,typename U>
@@ -1756,6 +2662,12 @@ Usage (example): <code>std::cout << fsm_t::buildOptions();</code>
 			out += yes;
 #else
 			out += no;
+#endif
+			out += SPAG_P_STRINGIZE2( SPAG_USE_EPOLL_WRAPPER );
+#ifdef SPAG_USE_EPOLL_WRAPPER
+			out += yes;
+#else
+			out += no;
 #endif
 			out += SPAG_P_STRINGIZE2( SPAG_USE_SIGNALS );
 #ifdef SPAG_USE_SIGNALS
@@ -1803,7 +2715,17 @@ Usage (example): <code>std::cout << fsm_t::buildOptions();</code>
 #ifdef SPAG_USE_ASIO_WRAPPER
 		out += "Boost asio used, Boost version=";
 		out += std::to_string(BOOST_VERSION);
+		out += '\n';
 #endif
+			out += "FSM traits:\n";
+			out += "logging";
+			out += ( useLogging ? yes : no );
+			out += "enumStrings";
+			out += ( useEnumStrings ? yes : no );
+			out += "innerEvents";
+			out += ( useInnerEvents ? yes : no );
+			out += "collapseAAT";
+			out += ( useCollapseAAT ? yes : no );
 
 
 
@@ -1825,138 +2747,651 @@ Usage (example): <code>std::cout << fsm_t::buildOptions();</code>
 or
 <code>assignInnerTransition( EV, ST );</code>
 
-\note To be replaced with https://en.cppreference.com/w/cpp/container/map/contains
-when C++20 available.
+Always false when inner events are disabled (see FsmTraits::innerEvents), as inner events can not be declared.
 */
 	bool isInnerEvent( EV ev ) const
 	{
-		return static_cast<bool>(_innerEventFlag.count( ev ));
+		if constexpr( useInnerEvents )
+			return _innerEventDecl[ SPAG_P_CAST2IDX(ev) ];
+		else
+		{
+			(void)ev;
+			return false;
+		}
 	}
 
-/// Run associated action with a state switch (state has already switched)
-/**
--# first, starts timer, if needed (first, because running callback can take some time).
--# second, calls callback function, if any.
--# third, raises a signal if a deferred action has been requested on this state (only if signals have been enabled, see manual).
-*/
-		void runAction() const
+/// Returns true if state \c st_idx is a pass-state (always false when inner events are disabled)
+	bool isPassState( size_t st_idx ) const
+	{
+		if constexpr( useInnerEvents )
+			return _stateInfo[st_idx]._isPassState;
+		else
 		{
-			SPAG_P_START;
-			SPAG_LOG << "switched to state " << SPAG_P_CAST2IDX(_current)
-#ifdef SPAG_ENUM_STRINGS
-				<< " (" << _strStates[ SPAG_P_CAST2IDX(_current) ] << ")"
-#endif
-				<< ", starting handler\n";
-			auto curr_idx = SPAG_P_CAST2IDX(_current);
-			auto& stateInfo = _stateInfo[ curr_idx ];
+			(void)st_idx;
+			return false;
+		}
+	}
 
-			if( stateInfo._timerEvent._enabled )
-			{
-				SPAG_P_ASSERT( _eventHandler, "Event handler has not been allocated" );
-				SPAG_LOG << "timeout start, duration=" <<  stateInfo._timerEvent._duration << "\n";
-				_eventHandler->timerStart( this );
-			}
-			if( stateInfo._callback ) // if there is a callback stored, then call it
+/// Returns the string of state \c st_idx, as " (str)", or an empty string if enum strings are disabled (see FsmTraits::enumStrings)
+	std::string strState( size_t st_idx ) const
+	{
+		if constexpr( useEnumStrings )
+			return " (" + _strStates[st_idx] + ')';
+		else
+		{
+			(void)st_idx;
+			return std::string();
+		}
+	}
+
+/// Returns the string of event \c ev_idx, as " (str)", or an empty string if enum strings are disabled
+	std::string strEvent( size_t ev_idx ) const
+	{
+		if constexpr( useEnumStrings )
+			return " (" + _strEvents[ev_idx] + ')';
+		else
+		{
+			(void)ev_idx;
+			return std::string();
+		}
+	}
+
+/// Returns a pointer on the enum strings \c v, to be given to the logging data, or null if enum strings are disabled
+	template<typename T>
+	static const std::vector<std::string>* stringsPtr( const T& v )
+	{
+		if constexpr( useEnumStrings )
+			return &v;
+		else
+		{
+			(void)v;
+			return nullptr;
+		}
+	}
+
+/// Throws if the configuration has been frozen by finalize()
+	void checkNotFinalized() const
+	{
+		if( _isFinalized )
+			SPAG_P_THROW_ERROR_CFG( "attempt to change the configuration of a finalized FSM" );
+	}
+
+/// Throws if \c ev has been declared as inner event, as it can not be processed by processEvent()
+	void checkNotInnerEvent( EV ev ) const
+	{
+		auto ev_idx = SPAG_P_CAST2IDX( ev );
+		if( isInnerEvent(ev) )
+			SPAG_P_THROW_ERROR_RT(
+				std::string( "request to process event idx=" )
+				+ std::to_string( ev_idx )
+				+ strEvent( ev_idx )
+				+ std::string( " but event has been declared as inner event." )
+			);
+	}
+
+/// Throws if a pass-state leads to a cycle of pass-states. Called by finalize()
+	void checkPassStateCycles() const
+	{
+		for( size_t i=0; i<nbStates(); i++ )
+		{
+			size_t st = i;
+			for( size_t n=0; _stateInfo[st]._isPassState; n++ )
 			{
-				SPAG_LOG << "callback function start:\n";
-				stateInfo._callback( _stateInfo[ SPAG_P_CAST2IDX(_current) ]._callbackArg );
+				if( n == nbStates() )
+					SPAG_P_THROW_ERROR_CFG( "pass-state S" + std::to_string( i ) + " leads to a cycle of pass-states" );
+				st = SPAG_P_CAST2IDX( _table.next( nbEvents()+1, st ) );
 			}
-			else
-				SPAG_LOG << "state has no callback provided\n";
+		}
+	}
 
-#ifdef SPAG_USE_SIGNALS
-			if( _isRunning )  // we need this, because the callback could have stopped the FSM, thus we must not generate a signal !
+/// For each state, follows the chain of pass states without callback that starts on it, see FsmTraits::collapseAAT.
+/// Called by finalize(), once checkPassStateCycles() has checked that the chains end
+	void buildPassChains()
+	{
+		_passChain.resize( nbStates() );
+		for( size_t i=0; i<nbStates(); i++ )
+		{
+			auto& chain = _passChain[i];
+			chain._last = static_cast<ST>(i);
+			size_t st = i;
+			while( _stateInfo[st]._isPassState && !hasCallback( _stateInfo[st] ) )
 			{
-				bool do_raise_sig = false;
-				if( stateInfo._isPassState )
-				{
-					SPAG_LOG << "Is pass-state, raise signal.\n";
-					do_raise_sig = true;
-				}
-				else
-				{
-					for( auto& itr: stateInfo._innerTransList )
-						if( isInnerEvent( itr._innerEvent ) ) // if event is registered
-							if( _innerEventFlag.at( itr._innerEvent ) ) // and active
-							{
-								SPAG_LOG << "Inner Event idx=" << SPAG_P_CAST2IDX(itr._innerEvent)
-								#ifdef SPAG_ENUM_STRINGS
-									<< " (" << _strEvents[ SPAG_P_CAST2IDX(itr._innerEvent) ] << ")"
-								#endif
-									<< " is active, raise signal.\n";
-								do_raise_sig = true;
-								break;                    // no need to check the others
-							}
-				}
-				if( do_raise_sig )
-				{
-					SPAG_LOG << "raising signal\n";
-					SPAG_LOG_FLUSH;
-					_eventHandler->raiseSignal();
-					_eventHandler->timerCancel();
-				}
+				chain._last = static_cast<ST>(st);
+				st = SPAG_P_CAST2IDX( _table.next( nbEvents()+1, st ) );
 			}
-//			SPAG_LOG << "current state info:\n";
-//			std::cout << _stateInfo[ curr_idx ] << '\n';
-#endif
-			SPAG_P_END;
+			chain._target = static_cast<ST>(st);
 		}
+	}
 
-		void printLineHeader(  std::ostream&, size_t idx, bool firstline_flag, size_t maxlength ) const;
-		void printMatrix(      std::ostream& ) const;
-		void printStateConfig( std::ostream& ) const;
-		bool isReachable( size_t ) const;
-		std::string getConfigErrorMessage( priv::EN_ConfigError ce, size_t st ) const;
+/// Throws if an inner event is allowed as external event on some state. Called by finalize(), so that
+/// processEvent() needs to check for inner events only on ignored events
+	void checkInnerEventsNotAllowed() const
+	{
+		for( size_t j=0; j<nbEvents(); j++ )
+			if( _innerEventDecl[j] )
+				for( size_t i=0; i<nbStates(); i++ )
+					if( _table.allowed( j, i ) == 1 )
+						SPAG_P_THROW_ERROR_CFG(
+							"inner event E" + std::to_string( j ) + " is allowed as external event on state S" + std::to_string( i )
+						);
+	}
 
-/////////////////////////////
-// SpagFSM: private data section
-/////////////////////////////
+/** \name Run time functions, operating on run-time state \c rs
 
-	private:
-#ifdef SPAG_ENABLE_LOGGING
-		mutable priv::RunTimeData<ST,EV> _rtdata;
+\c owner is the object that holds \c rs and that is given to the timer: this FSM, or a FsmInstance sharing its configuration.
+*/
+///@{
+	template<typename OWNER>
+	void start( RunState_t& rs, OWNER* owner ) const
+	{
+		rs._isRunning    = true;
+		rs._innerPending = false;                      // if the FSM was stopped while one was pending
+		runToCompletion( rs, owner, [&](){ runAction( rs, owner ); } );  // lambda
+
+#ifndef SPAG_EXTERNAL_EVENT_LOOP
+		if( !std::is_same<TIM,priv::NoTimer<ST,EV,CBA>>::value )
+		{
+			SPAG_P_ASSERT( rs._eventHandler, "Event handler has not been allocated" );
+			rs._eventHandler->init( owner );   // blocking function !
+		}
 #endif
-		mutable ST        _current           = static_cast<ST>(0);   ///< current state
-		mutable ST        _previous          = static_cast<ST>(0);   ///< previous state
-		mutable bool      _isRunning         = false;
-		mutable DurUnit   _defaultTimerUnit  = DurUnit::sec;         ///< default timer units
-		mutable Duration  _defaultTimerValue = 1;                    ///< default timer value
-		mutable TIM*      _eventHandler      = nullptr;              ///< pointer on timer/ event-loop handling object
+	}
 
-#ifdef SPAG_USE_ARRAY
-	#ifdef SPAG_USE_SIGNALS
-		std::array<
-			std::array<ST, static_cast<size_t>(ST::NB_STATES)>,
-			static_cast<size_t>(EV::NB_EVENTS)+2                   // + 2 is used to hold the AAT
-		> _transitionMat;  ///< describe what states the fsm switches to, when an event is received. lines: events, columns: states, value: states to switch to. DOES NOT hold timer events
-	#else
-		std::array<
-			std::array<ST, static_cast<size_t>(ST::NB_STATES)>,
-			static_cast<size_t>(EV::NB_EVENTS)+1                  // +1 is used to hold the timeout events
-		> _transitionMat;  ///< describe what states the fsm switches to, when an event is received. lines: events, columns: states, value: states to switch to. DOES NOT hold timer events
-	#endif
+	void stop( RunState_t& rs ) const
+	{
+		SPAG_P_ASSERT( rs._isRunning, "attempt to stop an already stopped FSM" );
 
-/// Matrix holding for each event a byte telling is the event is ignored or not, for a given state (0:ignore event, 1:handle external event, -1: internal event)
-		std::array<
-			std::array<char, static_cast<size_t>(ST::NB_STATES)>,
-			static_cast<size_t>(EV::NB_EVENTS)
-		> _allowedMat;
-#else
-		std::vector<std::vector<ST>>   _transitionMat;
-		std::vector<std::vector<char>> _allowedMat;
-#endif // SPAG_USE_ARRAY
+		if( rs._eventHandler )
+		{
+			SPAG_LOG << "call timerCancel()\n";
+			rs._eventHandler->timerCancel();
+			SPAG_LOG << "call event loop kill()\n";
+			rs._eventHandler->kill();
+		}
+		rs._isRunning = false;
+	}
 
-#ifdef SPAG_USE_ARRAY
-		std::array<priv::StateInfo<ST,EV,CBA>,static_cast<size_t>(ST::NB_STATES)> _stateInfo;         ///< Holds for each state the details
-#else
-		std::vector<priv::StateInfo<ST,EV,CBA>> _stateInfo;         ///< Holds for each state the details
-#endif
-		mutable std::map<EV,bool> _innerEventFlag; ///< holds the activation flag for each inner event
+	template<typename OWNER>
+	void processTimeOut( RunState_t& rs, const OWNER* owner ) const
+	{
+		SPAG_P_START;
+		auto cur_idx = SPAG_P_CAST2IDX( rs._current );
+		SPAG_LOG << "processing timeout event, delay was " << _stateInfo[ cur_idx ]._timerEvent._duration << "\n";
+		assert( _stateInfo[ cur_idx ]._timerEvent._enabled ); // or else, the timer shouldn't have been started, and thus we shouldn't be here...
+		rs._previous = rs._current;
+		rs._current = _stateInfo[ cur_idx ]._timerEvent.nextState();
+		if constexpr( useLogging )
+			_rtdata.logTransition( rs._current, nbEvents() );
+		runToCompletion( rs, owner, [&](){ runAction( rs, owner ); } );  // lambda
+		SPAG_P_END;
+	}
 
-#ifdef SPAG_ENUM_STRINGS
-		std::vector<std::string> _strEvents;      ///< holds events strings
-		std::vector<std::string> _strStates;      ///< holds states strings
-#endif
+	template<typename OWNER>
+	void processEvent( RunState_t& rs, const OWNER* owner, EV ev ) const
+	{
+		SPAG_P_START;
+
+		SPAG_CHECK_LESS( SPAG_P_CAST2IDX(ev), nbEvents() );
+		SPAG_P_ASSERT( rs._isRunning, "attempting to process an event but FSM is not started" );
+
+		if constexpr( useInnerEvents )
+			if( !_isFinalized )       // else, checked only if event is ignored, see finalize()
+				checkNotInnerEvent( ev );
+		runToCompletion( rs, owner, [&](){ dispatchEvent( rs, owner, ev ); } );  // lambda
+		SPAG_P_END;
+	}
+
+/// Queues event \c ev if an event is being processed (called from a callback), else processes it right away
+	template<typename OWNER>
+	void postEvent( RunState_t& rs, const OWNER* owner, EV ev ) const
+	{
+		static_assert( usePostQueue, "Error, FsmTraits::postQueueSize is 0" );
+		SPAG_CHECK_LESS( SPAG_P_CAST2IDX(ev), nbEvents() );
+		if( !rs._isProcessing )
+			processEvent( rs, owner, ev );
+		else
+		{
+			SPAG_LOG << "posting event " << SPAG_P_CAST2IDX(ev) << '\n';
+			if( !rs._posted.push( ev ) )
+				SPAG_P_THROW_ERROR_RT(
+					"unable to post event " + std::to_string( SPAG_P_CAST2IDX(ev) )
+					+ ", queue is full (capacity=" + std::to_string( rs._posted.capacity() ) + ')'
+				);
+		}
+	}
+
+/// Checks \c ev, then stores it in the input queue, and wakes up the event loop if needed. Can be called from any thread
+	template<typename OWNER>
+	bool pushEvent( RunState_t& rs, const OWNER* owner, EV ev ) const
+	{
+		static_assert( useInputQueue, "Error, FsmTraits::inputQueueSize is 0" );
+		checkExternalEvents( &ev, &ev+1 );
+		while( !rs._input.push( ev ) )
+		{
+			if constexpr( TRAITS::inputQueuePolicy == QueueFullPolicy::Drop )
+			{
+				rs._input.countDropped();
+				return false;
+			}
+			std::this_thread::yield();
+		}
+		if constexpr( priv::HasWakeUp<TIM,OWNER>::value )
+			if( rs._input.needsWakeUp() && rs._eventHandler )
+				rs._eventHandler->wakeUp( owner );
+		return true;
+	}
+
+/// Processes the events of the input queue, called by the thread running the event loop
+	template<typename OWNER>
+	size_t processPushedEvents( RunState_t& rs, const OWNER* owner ) const
+	{
+		static_assert( useInputQueue, "Error, FsmTraits::inputQueueSize is 0" );
+		rs._input.clearWakeUp();              // before popping, so that an event pushed meanwhile triggers a new wake-up
+		size_t nb = 0;
+		EV ev;
+		while( rs._isRunning && rs._input.pop( ev ) )
+		{
+			processEvent( rs, owner, ev );
+			nb++;
+		}
+		return nb;
+	}
+
+/// Processes the inner event or AAT of current state, whose informations are \c stinf
+/**
+Does nothing if the FSM has been stopped, or if there is nothing left to process on this state: the request may come from
+activateInnerEvent(), called from another thread while the FSM was switching, or the activation may have been cleared meanwhile.
+*/
+	template<typename OWNER>
+	void processInnerEvent( RunState_t& rs, const OWNER* owner, const StateInfo_t& stinf ) const
+	{
+		if( !rs._isRunning )
+			return;
+		size_t ev_idx = nbEvents() + 1;
+		if( !stinf._isPassState )
+		{
+			auto active = stinf._innerMask & _innerEventActive.load();
+			for( size_t i=0; i<nbEvents(); i++ )
+				if( active[i] && _innerEventActive.reset( i ) )   // first activated inner event of this state that is still active (the others stay active)
+				{
+					ev_idx = i;
+					break;
+				}
+			if( ev_idx > nbEvents() )
+			{
+				SPAG_LOG << "no active inner event on state " << SPAG_P_CAST2IDX(rs._current) << ", nothing to do\n";
+				return;
+			}
+		}
+		SPAG_P_START;
+
+		if( stinf._isPassState )
+		{
+			auto next = _table.next( nbEvents()+1, SPAG_P_CAST2IDX(rs._current) );
+			SPAG_LOG << "is pass state, switch from state " << (int)rs._current << " to state " << (int)next << '\n';
+			rs._previous = rs._current;
+			rs._current  = next;
+		}
+		else
+		{
+			if constexpr( priv::HasPostInnerEvent<TIM,OWNER>::value )
+				if( stinf._timerEvent._enabled )    // the request may come from another thread, that could not cancel the timer
+					rs._eventHandler->timerCancel();
+			rs._previous = rs._current;
+			rs._current  = _table.next( ev_idx, SPAG_P_CAST2IDX(rs._current) );
+		}
+
+		if constexpr( useLogging )
+			_rtdata.logTransition( rs._current, ev_idx );
+		runToCompletion( rs, owner, [&](){ runAction( rs, owner ); } );  // lambda
+		SPAG_P_END;
+	}
+
+/// Processes the inner event or AAT that runAction() has deferred, if the timer class can not do it (see drainsInnerEvents),
+/// then the ones deferred by the states reached meanwhile, until there is none left.
+/**
+Called by the outermost call of runToCompletion(), once the transition has completed. As nested calls leave the job to it,
+this is done iteratively: a long chain of pass states does not make the stack grow.
+*/
+	template<typename OWNER>
+	void drainInnerEvents( RunState_t& rs, const OWNER* owner ) const
+	{
+		if constexpr( drainsInnerEvents<OWNER> )
+		{
+			while( rs._isRunning && rs._innerPending )
+			{
+				rs._innerPending = false;
+				processInnerEvent( rs, owner, _stateInfo[ SPAG_P_CAST2IDX(rs._current) ] );
+			}
+		}
+		else
+		{
+			(void)rs;
+			(void)owner;
+		}
+	}
+
+/// Runs \c step, that processes an event, then the inner events and AAT it has deferred (see drainInnerEvents()).
+/// If this is the outermost call, then processes afterwards, in order, the events
+/// posted by the callbacks meanwhile, each one once the previous transition has completed (run-to-completion).
+/// Thus posted events are processed iteratively, and the stack depth stays bounded.
+	template<typename OWNER,typename FUNC>
+	void runToCompletion( RunState_t& rs, const OWNER* owner, FUNC step ) const
+	{
+		if( rs._isProcessing )    // nested call (from a callback): the outermost one does the rest
+		{
+			step();
+			return;
+		}
+		priv::FlagScope processing( rs._isProcessing );
+		if constexpr( usePostQueue )
+		{
+			typename Posted_t::Scope scope( rs._posted );
+			step();
+			drainInnerEvents( rs, owner );
+			EV ev;
+			while( rs._isRunning && rs._posted.pop( ev ) )   // if a callback stopped the FSM, the remaining events are dropped
+			{
+				processEvent( rs, owner, ev );
+				drainInnerEvents( rs, owner );
+			}
+		}
+		else
+		{
+			step();
+			drainInnerEvents( rs, owner );
+		}
+	}
+
+	template<typename OWNER>
+	size_t processEvents( RunState_t& rs, const OWNER* owner, const EV* first, const EV* last, ST* trace ) const
+	{
+		SPAG_P_ASSERT( rs._isRunning, "attempting to process events but FSM is not started" );
+		checkExternalEvents( first, last );
+
+		const EV* it = first;
+		for( ; it != last && rs._isRunning; ++it )
+		{
+			runToCompletion( rs, owner, [&](){ dispatchEvent( rs, owner, *it ); } );  // lambda
+			if( trace )
+				*trace++ = rs._current;
+		}
+		return it - first;
+	}
+///@}
+
+/// Returns true if some inner events or pass states have been assigned
+	bool hasInnerEvents() const
+	{
+		if constexpr( useInnerEvents )
+		{
+			if( _innerEventDecl.any() )
+				return true;
+			for( const auto& stinf: _stateInfo )
+				if( stinf._isPassState )
+					return true;
+		}
+		return false;
+	}
+
+/// Checks that all the events in [first,last) are valid external events. Throws if not.
+	void checkExternalEvents( const EV* first, const EV* last ) const
+	{
+		bool hasInner = false;
+		if constexpr( useInnerEvents )
+			hasInner = _innerEventDecl.any();
+		for( const EV* it = first; it != last; ++it )
+		{
+			auto ev_idx = SPAG_P_CAST2IDX( *it );
+			SPAG_CHECK_LESS( ev_idx, nbEvents() );
+			if( hasInner && isInnerEvent( *it ) )
+				SPAG_P_THROW_ERROR_RT(
+					std::string( "request to process event idx=" )
+					+ std::to_string( ev_idx )
+					+ strEvent( ev_idx )
+					+ std::string( " at position " ) + std::to_string( it - first )
+					+ std::string( " but event has been declared as inner event." )
+				);
+		}
+	}
+
+/// Handles the external event \c ev, once it has been checked: switch to next state if it is allowed on current state,
+/// else ignore it. Shared by processEvent() and processEvents()
+	template<typename OWNER>
+	void dispatchEvent( RunState_t& rs, const OWNER* owner, EV ev ) const
+	{
+		auto ev_idx = SPAG_P_CAST2IDX( ev );
+		if constexpr( useEnumStrings )
+		{
+			SPAG_LOG << "processing event " << ev_idx << ": \"" << _strEvents[ev_idx] << "\"\n";
+		}
+		else
+		{
+			SPAG_LOG << "processing event " << ev_idx << '\n';
+		}
+		auto cur_idx = SPAG_P_CAST2IDX(rs._current);
+		if constexpr( TRAITS::Table::packed )
+		{
+			const auto& cell = _table.cell( ev_idx, cur_idx );   // single load holds all we need
+			if( cell._allowed == 1 )
+				doTransition( rs, owner, static_cast<ST>( cell._next ), cell._hasTimeOut, ev_idx );
+			else
+				ignoreEvent( rs, ev );
+		}
+		else
+		{
+			if( _table.allowed( ev_idx, cur_idx ) == 1 )
+				doTransition( rs, owner, _table.next( ev_idx, cur_idx ), _stateInfo[ cur_idx ]._timerEvent._enabled, ev_idx );
+			else
+				ignoreEvent( rs, ev );
+		}
+	}
+
+/// Switch to state \c next, once external event \c ev_idx has been accepted on current state
+		template<typename OWNER>
+		void doTransition( RunState_t& rs, const OWNER* owner, ST next, bool cancelTimer, size_t ev_idx ) const
+		{
+			if( cancelTimer )                                 // 1 - cancel the waiting timer, if any
+			{
+				SPAG_P_ASSERT( rs._eventHandler, "Event handler has not been allocated" );
+				rs._eventHandler->timerCancel();
+			}
+			rs._previous = rs._current;
+			rs._current  = next;                              // 2 - switch to next state
+			if constexpr( useLogging )
+				_rtdata.logTransition( rs._current, ev_idx );
+			else
+				(void)ev_idx;
+			runAction( rs, owner );                           // 3 - call the callback function
+		}
+
+/// Handles external event \c ev, that is not allowed on current state
+		void ignoreEvent( const RunState_t& rs, EV ev ) const
+		{
+			if constexpr( useInnerEvents )
+				if( _isFinalized )
+					checkNotInnerEvent( ev );
+			SPAG_LOG << "event is ignored on current state\n";
+			if( _ignEventCallback )
+				_ignEventCallback( rs._current, ev );
+
+			if constexpr( useLogging )
+				_rtdata.logIgnoredEvent( SPAG_P_CAST2IDX(ev) );
+		}
+
+/// Returns true if a callback will be called when entering the state described by \c stateInfo
+		bool hasCallback( const StateInfo_t& stateInfo ) const
+		{
+			if constexpr( hasCbHandler )
+			{
+				(void)stateInfo;
+				return _cbHandler != nullptr;
+			}
+			else
+				return static_cast<bool>( stateInfo._callback );
+		}
+
+/// Entering current state: starts timer, if needed (first, because running callback can take some time), then calls callback function, if any.
+/// If the chains of pass states are collapsed (see FsmTraits::collapseAAT), first jumps to the end of the one starting on current state.
+		template<typename OWNER>
+		void enterState( RunState_t& rs, const OWNER* owner ) const
+		{
+			if constexpr( useCollapseAAT )
+				if( _isFinalized )
+				{
+					const auto& chain = _passChain[ SPAG_P_CAST2IDX(rs._current) ];
+					if( chain._target != rs._current )
+					{
+						SPAG_LOG << "crossing pass states, from state " << SPAG_P_CAST2IDX(rs._current)
+							<< " to state " << SPAG_P_CAST2IDX(chain._target) << '\n';
+						rs._previous = chain._last;
+						rs._current  = chain._target;
+						if constexpr( useLogging )
+							_rtdata.logTransition( rs._current, nbEvents()+1 );
+					}
+				}
+			SPAG_LOG << "switched to state " << SPAG_P_CAST2IDX(rs._current)
+				<< strState( SPAG_P_CAST2IDX(rs._current) )
+				<< ", starting handler\n";
+			auto& stateInfo = _stateInfo[ SPAG_P_CAST2IDX(rs._current) ];
+
+			if( stateInfo._timerEvent._enabled )
+			{
+				SPAG_P_ASSERT( rs._eventHandler, "Event handler has not been allocated" );
+				SPAG_LOG << "timeout start, duration=" <<  stateInfo._timerEvent._duration << "\n";
+				rs._eventHandler->timerStart( owner );
+			}
+			if( hasCallback( stateInfo ) ) // if there is a callback stored, then call it
+			{
+				SPAG_LOG << "callback function start:\n";
+				if constexpr( hasCbHandler )
+					(*_cbHandler)( rs._current, stateInfo._callbackArg );
+				else
+					stateInfo._callback( stateInfo._callbackArg );
+			}
+			else
+				SPAG_LOG << "state has no callback provided\n";
+		}
+
+/// Run associated action with a state switch (state has already switched)
+/**
+-# first, enters the state, see enterState().
+-# second, if the chains of pass states are collapsed (see FsmTraits::collapseAAT), and if this is a pass state (thus with a callback),
+switches right away to next state and enters it, in a loop, until reaching a state that is not a pass state.
+-# third, if a deferred action has been requested on this state (only if inner events have been enabled, see manual),
+asks the event handler to process it once this has completed: with its \c postInnerEvent() member function if it has one, else with \c raiseSignal().
+If it has none of these, the request is recorded in \c rs, and processed by drainInnerEvents().
+*/
+		template<typename OWNER>
+		void runAction( RunState_t& rs, const OWNER* owner ) const
+		{
+			SPAG_P_START;
+			enterState( rs, owner );
+
+			if constexpr( useCollapseAAT )
+				if( _isFinalized )
+					while( rs._isRunning && _stateInfo[ SPAG_P_CAST2IDX(rs._current) ]._isPassState )
+					{
+						auto pass_idx = SPAG_P_CAST2IDX(rs._current);
+						if( _stateInfo[ pass_idx ]._timerEvent._enabled )
+							rs._eventHandler->timerCancel();
+						rs._previous = rs._current;
+						rs._current  = _table.next( nbEvents()+1, pass_idx );
+						SPAG_LOG << "is pass state, switch to state " << SPAG_P_CAST2IDX(rs._current) << '\n';
+						if constexpr( useLogging )
+							_rtdata.logTransition( rs._current, nbEvents()+1 );
+						enterState( rs, owner );
+					}
+
+			auto curr_idx = SPAG_P_CAST2IDX(rs._current);
+			auto& stateInfo = _stateInfo[ curr_idx ];
+
+			if constexpr( useInnerEvents )
+				if( rs._isRunning )  // we need this, because the callback could have stopped the FSM, thus we must not request a deferred action !
+				{
+					bool do_defer = false;
+					if( stateInfo._isPassState )
+					{
+						SPAG_LOG << "Is pass-state, deferred processing.\n";
+						do_defer = true;
+					}
+					else if( ( stateInfo._innerMask & _innerEventActive.load() ).any() )
+					{
+						SPAG_LOG << "Inner Event is active, deferred processing.\n";
+						do_defer = true;
+					}
+					if( do_defer )
+						deferInnerEvent( rs, owner );
+				}
+//			SPAG_LOG << "current state info:\n";
+//			std::cout << _stateInfo[ curr_idx ] << '\n';
+			SPAG_P_END;
+		}
+
+/// Asks the event handler to process the inner event or AAT of current state once the current transition has completed,
+/// and cancels the timer of this state (see runAction())
+		template<typename OWNER>
+		void deferInnerEvent( RunState_t& rs, const OWNER* owner ) const
+		{
+			if constexpr( priv::HasPostInnerEvent<TIM,OWNER>::value )
+			{
+				SPAG_LOG << "posting inner event\n";
+				rs._eventHandler->postInnerEvent( owner );
+			}
+			else if constexpr( priv::HasRaiseSignal<TIM>::value )
+			{
+				SPAG_LOG << "raising signal\n";
+				SPAG_LOG_FLUSH;
+				rs._eventHandler->raiseSignal();
+				(void)owner;
+			}
+			else
+			{
+				SPAG_LOG << "inner event pending\n";
+				rs._innerPending = true;
+				(void)owner;
+			}
+			if( rs._eventHandler )
+				rs._eventHandler->timerCancel();
+		}
+
+		void printLineHeader(  std::ostream&, size_t idx, bool firstline_flag, size_t maxlength ) const;
+		void printMatrix(      std::ostream& ) const;
+		void printStateConfig( std::ostream& ) const;
+		bool isReachable( size_t ) const;
+		std::string getConfigErrorMessage( priv::EN_ConfigError ce, size_t st ) const;
+
+/////////////////////////////
+// SpagFSM: private data section
+/////////////////////////////
+
+	private:
+		SPAG_NO_UNIQUE_ADDRESS mutable RunTimeData_t _rtdata;       ///< logged data, empty if logging is disabled (see FsmTraits::logging)
+		mutable RunState_t _rs;                                      ///< run-time state (current state, timer, ...)
+		mutable DurUnit   _defaultTimerUnit  = DurUnit::sec;         ///< default timer units
+		std::conditional_t<hasCbHandler, CbHandler_t*, priv::NoCallback>
+		                  _cbHandler         = {};                   ///< callback handler, only with HandlerCallback policy
+		mutable Duration  _defaultTimerValue = 1;                    ///< default timer value
+
+		priv::TableStorage<
+			ST,
+			EV,
+			typename TRAITS::Table,
+			TRAITS::layout,
+			std::conditional_t<TRAITS::narrowCells, priv::StateCell<ST>, ST>,
+			useInnerEvents
+		> _table; ///< transition table (and allowed events flags), layout depends on TRAITS
+
+		StateInfoStorage_t _stateInfo;         ///< Holds for each state the details (see stateInfoOnHeap)
+// inner events data, empty if inner events are disabled (see FsmTraits::innerEvents)
+		SPAG_NO_UNIQUE_ADDRESS         IfInner_t<EventMask_t,0>              _innerEventDecl;   ///< set for events declared as inner events
+		SPAG_NO_UNIQUE_ADDRESS mutable IfInner_t<ActiveMask_t,1>             _innerEventActive; ///< activation flag for each inner event, can be set from any thread
+		SPAG_NO_UNIQUE_ADDRESS std::conditional_t<useCollapseAAT, std::vector<priv::PassChain<ST>>, priv::NoData<5>>
+		                                                                    _passChain;        ///< for each state, where its chain of pass states leads (filled by finalize(), see FsmTraits::collapseAAT)
+		bool              _isFinalized       = false;             ///< set by finalize(), then configuration can not be changed
+
+		SPAG_NO_UNIQUE_ADDRESS IfStrings_t<std::vector<std::string>,3> _strEvents;   ///< holds events strings, empty if enum strings are disabled (see FsmTraits::enumStrings)
+		SPAG_NO_UNIQUE_ADDRESS IfStrings_t<std::vector<std::string>,4> _strStates;   ///< holds states strings
 
 #ifdef SPAG_EMBED_ASIO_WRAPPER
 		AsioWrapper<ST,EV,CBA> _asioWrapper; ///< optional wrapper around boost::asio::io_service (now `io_context`)
@@ -1982,17 +3417,18 @@ printChars( std::ostream& out, size_t n, char c )
 
 //-----------------------------------------------------------------------------------
 /// Configuration error printing function
-template<typename ST, typename EV,typename T,typename CBA>
+template<typename ST, typename EV,typename T,typename CBA,typename TRAITS>
 std::string
-SpagFSM<ST,EV,T,CBA>::getConfigErrorMessage( priv::EN_ConfigError ce, size_t st ) const
+SpagFSM<ST,EV,T,CBA,TRAITS>::getConfigErrorMessage( priv::EN_ConfigError ce, size_t st ) const
 {
 	std::string msg( priv::getSpagName() + "configuration error: state " );
 	msg += std::to_string( st );
-#ifdef SPAG_ENUM_STRINGS
-	msg += " '";
-	msg += _strStates[st];
-	msg += "'";
-#endif
+	if constexpr( useEnumStrings )
+	{
+		msg += " '";
+		msg += _strStates[st];
+		msg += "'";
+	}
 	msg += ' ';
 
 	switch( ce )
@@ -2012,14 +3448,13 @@ SpagFSM<ST,EV,T,CBA>::getConfigErrorMessage( priv::EN_ConfigError ce, size_t st
 }
 //-----------------------------------------------------------------------------------
 /// helper function template for printConfig()
-template<typename ST, typename EV,typename T,typename CBA>
+template<typename ST, typename EV,typename T,typename CBA,typename TRAITS>
 void
-SpagFSM<ST,EV,T,CBA>::printMatrix( std::ostream& out ) const
+SpagFSM<ST,EV,T,CBA,TRAITS>::printMatrix( std::ostream& out ) const
 {
 	size_t maxlength(0);
-#ifdef SPAG_ENUM_STRINGS
-	maxlength = priv::getMaxLength( _strEvents );
-#endif
+	if constexpr( useEnumStrings )
+		maxlength = priv::getMaxLength( _strEvents );
 
 	char spc_char{ ' ' };
 	out << std::setfill('0');
@@ -2038,26 +3473,28 @@ SpagFSM<ST,EV,T,CBA>::printMatrix( std::ostream& out ) const
 	out << '\n';
 
 	auto nbLines = nbEvents()+1; // +1 for timeout events
-#ifdef SPAG_USE_SIGNALS
-	nbLines++;                   // +1 for pass-states
-#endif
+	if constexpr( useInnerEvents )
+		nbLines++;               // +1 for pass-states
 
-#ifndef SPAG_ENUM_STRINGS
 	std::string capt( "EVENTS" );
-	nbLines = std::max( capt.size(), nbLines );
-#endif
+	if constexpr( !useEnumStrings )
+		nbLines = std::max( capt.size(), nbLines );
 
 	for( size_t i=0; i<nbLines; i++ )
 	{
-#ifdef SPAG_ENUM_STRINGS
-		if( maxlength )
-			priv::PrintEnumString( out, _strEvents[i], maxlength );
-#else
-		if( i<capt.size() )
-			out << capt[i];
-		else
-#endif
+		if constexpr( useEnumStrings )
+		{
+			if( maxlength )
+				priv::PrintEnumString( out, _strEvents[i], maxlength );
 			out << spc_char;
+		}
+		else
+		{
+			if( i<capt.size() )
+				out << capt[i];
+			else
+				out << spc_char;
+		}
 
 		if( i<nbEvents() )
 		{
@@ -2065,8 +3502,8 @@ SpagFSM<ST,EV,T,CBA>::printMatrix( std::ostream& out ) const
 
 			for( size_t j=0; j<nbStates(); j++ )
 			{
-				if( _allowedMat[i][j] )
-					out << 'S' << std::setw(2) << _transitionMat[i][j];
+				if( _table.allowed( i, j ) )
+					out << 'S' << std::setw(2) << _table.next( i, j );
 				else
 					out << " . ";
 				out << spc_char;
@@ -2079,66 +3516,65 @@ SpagFSM<ST,EV,T,CBA>::printMatrix( std::ostream& out ) const
 			for( size_t j=0; j<nbStates(); j++ )
 			{
 				if( _stateInfo[j]._timerEvent._enabled )
-					out << 'S' << std::setw(2) << _stateInfo[j]._timerEvent._nextState;
+					out << 'S' << std::setw(2) << _stateInfo[j]._timerEvent.nextState();
 				else
 					out << " . ";
 				out << spc_char;
 			}
 		}
-#ifdef SPAG_USE_SIGNALS
-		if( i == nbEvents()+1 ) // Pass-state
+		if( useInnerEvents && i == nbEvents()+1 ) // Pass-state
 		{
 			out << " AAT | ";
 			for( size_t j=0; j<nbStates(); j++ )
 			{
-				if( _stateInfo[j]._isPassState )
-					out << 'S' << std::setw(2) << _transitionMat[ nbEvents()+1 ][j];
+				if( isPassState( j ) )
+					out << 'S' << std::setw(2) << _table.next( nbEvents()+1, j );
 				else
 					out << " . ";
 				out << spc_char;
 			}
 		}
-#endif
 		out << '\n';
 	}
 }
 //-----------------------------------------------------------------------------------
-/// Helper function, returns true if state \c st is referenced in \c _transitionMat (and that the transition is allowed)
+/// Helper function, returns true if state \c st is referenced in the transition table (and that the transition is allowed)
 /// or it has a Timeout or pass-state transition
-template<typename ST, typename EV,typename T,typename CBA>
+template<typename ST, typename EV,typename T,typename CBA,typename TRAITS>
 bool
-SpagFSM<ST,EV,T,CBA>::isReachable( size_t st ) const
+SpagFSM<ST,EV,T,CBA,TRAITS>::isReachable( size_t st ) const
 {
 	for( size_t i=0; i<nbStates(); i++ )
 		if( i != st )
 		{
 			for( size_t k=0; k<nbEvents(); k++ )
-				if( SPAG_P_CAST2IDX( _transitionMat[k][i] ) == st )
-					if( _allowedMat[k][i] != 0 )
+				if( SPAG_P_CAST2IDX( _table.next( k, i ) ) == st )
+					if( _table.allowed( k, i ) != 0 )
 						return true;
 
 			if( _stateInfo[i]._timerEvent._enabled )
-				if( SPAG_P_CAST2IDX( _stateInfo[i]._timerEvent._nextState ) == st )
+				if( SPAG_P_CAST2IDX( _stateInfo[i]._timerEvent.nextState() ) == st )
 					return true;
 
-#ifdef SPAG_USE_SIGNALS
-			if( _stateInfo[i]._isPassState )
-				if( _transitionMat[ nbEvents()+1 ][i] == st )
-					return true;
+			if constexpr( useInnerEvents )
+			{
+				if( _stateInfo[i]._isPassState )
+					if( SPAG_P_CAST2IDX( _table.next( nbEvents()+1, i ) ) == st )
+						return true;
 
-			for( const auto& itr: _stateInfo[i]._innerTransList )
-				if( SPAG_P_CAST2IDX( itr._destState ) == st )
-					return true;
-#endif
+				for( size_t j=0; j<nbEvents(); j++ )
+					if( _stateInfo[i]._innerMask[j] && SPAG_P_CAST2IDX( _table.next( j, i ) ) == st )
+						return true;
+			}
 		}
 
 	return false;
 }
 //-----------------------------------------------------------------------------------
 /// Checks configuration for any illegal situation. Throws error if one is encountered.
-template<typename ST, typename EV,typename T,typename CBA>
+template<typename ST, typename EV,typename T,typename CBA,typename TRAITS>
 void
-SpagFSM<ST,EV,T,CBA>::doChecking() const
+SpagFSM<ST,EV,T,CBA,TRAITS>::doChecking() const
 {
  #if 0
  	for( size_t i=0; i<nbStates(); i++ )
@@ -2146,7 +3582,7 @@ SpagFSM<ST,EV,T,CBA>::doChecking() const
 		auto state = _stateInfo[i];
 		if( state._isPassState )
 		{
-			size_t nextState = SPAG_P_CAST2IDX( _transitionMat[0][i] );
+			size_t nextState = SPAG_P_CAST2IDX( _table.next( 0, i ) );
 			if( nextState == i )
 				SPAG_P_THROW_ERROR_CFG( getConfigErrorMessage( priv::CE_SamePassState, i ) );
 
@@ -2167,9 +3603,7 @@ SpagFSM<ST,EV,T,CBA>::doChecking() const
 	for( const auto& st: unreachableStates )
 	{
 		std::cout << priv::getSpagName() << "Warning, state S" << std::setw(2) << st
-#ifdef SPAG_ENUM_STRINGS
-			<< " (" << _strStates[st] << ')'
-#endif
+			<< strState( st )
 			<< " is unreachable\n";
 	}
 
@@ -2178,15 +3612,13 @@ SpagFSM<ST,EV,T,CBA>::doChecking() const
 		bool foundValid(false);
 		if( _stateInfo[i]._timerEvent._enabled )
 			foundValid = true;
-#ifdef SPAG_USE_SIGNALS
-		if( _stateInfo[i]._isPassState )
+		if( isPassState( i ) )
 			foundValid = true;
-#endif
 		if( !foundValid )       // else
 		{
 			for( size_t j=0; j<nbEvents(); j++ )
-				if( SPAG_P_CAST2IDX( _transitionMat[j][i] ) != i )   // if the transition leads to another state
-					if( _allowedMat[j][i] != 0 )                  // AND it is allowed
+				if( SPAG_P_CAST2IDX( _table.next( j, i ) ) != i )   // if the transition leads to another state
+					if( _table.allowed( j, i ) != 0 )                // AND it is allowed
 						foundValid = true;
 		}
 
@@ -2198,44 +3630,42 @@ SpagFSM<ST,EV,T,CBA>::doChecking() const
 			) == unreachableStates.end() )     // AND it is not in the unreachable states list
 		{
 			std::cout << priv::getSpagName() << "Warning, state S" << std::setw(2) << i
-#ifdef SPAG_ENUM_STRINGS
-				<< " (" << _strStates[i] << ')'
-#endif
+				<< strState( i )
 				<< " is a dead-end\n";
 		}
 	}
 }
 //-----------------------------------------------------------------------------------
 /// Helper function for printConfig()
-template<typename ST, typename EV,typename T,typename CBA>
+template<typename ST, typename EV,typename T,typename CBA,typename TRAITS>
 void
-SpagFSM<ST,EV,T,CBA>::printLineHeader( std::ostream& out, size_t idx, bool firstline_flag, size_t maxlength ) const
+SpagFSM<ST,EV,T,CBA,TRAITS>::printLineHeader( std::ostream& out, size_t idx, bool firstline_flag, size_t maxlength ) const
 {
 	if( firstline_flag )
 		out << 'S' << std::setw(2) << idx;
 	else
 		out << "   ";
-#ifdef SPAG_ENUM_STRINGS
-	out << ':';
-	if( firstline_flag )
+	if constexpr( useEnumStrings )
 	{
-//		firstline_flag = false;
-		priv::PrintEnumString( out, _strStates[idx], maxlength );
+		out << ':';
+		if( firstline_flag )
+		{
+//			firstline_flag = false;
+			priv::PrintEnumString( out, _strStates[idx], maxlength );
+		}
+		else
+			priv::printChars( out, maxlength, ' ' );
 	}
-	else
-		priv::printChars( out, maxlength, ' ' );
-#endif
 		out << "| ";
 }
 //-----------------------------------------------------------------------------------
-template<typename ST, typename EV,typename T,typename CBA>
+template<typename ST, typename EV,typename T,typename CBA,typename TRAITS>
 void
-SpagFSM<ST,EV,T,CBA>::printStateConfig( std::ostream& out ) const
+SpagFSM<ST,EV,T,CBA,TRAITS>::printStateConfig( std::ostream& out ) const
 {
 	size_t maxlength = 0;
-#ifdef SPAG_ENUM_STRINGS
-	maxlength = priv::getMaxLength( _strStates );
-#endif
+	if constexpr( useEnumStrings )
+		maxlength = priv::getMaxLength( _strStates );
 
 	for( size_t i=0; i<nbStates(); i++ )
 	{
@@ -2248,62 +3678,68 @@ SpagFSM<ST,EV,T,CBA>::printStateConfig( std::ostream& out ) const
 		{
 			print_content = true;
 			out << "TO: " <<  tev._duration << ' ' << priv::stringFromTimeUnit( tev._durUnit )
-				<< " => S" << std::setw(2) << SPAG_P_CAST2IDX( tev._nextState );
-#ifdef SPAG_ENUM_STRINGS
-			out << " (";
-			priv::PrintEnumString( out, _strStates[tev._nextState] );
-			out << ')';
-#endif // SPAG_ENUM_STRINGS
+				<< ( tev._driftFree ? " (drift-free)" : "" )
+				<< " => S" << std::setw(2) << SPAG_P_CAST2IDX( tev.nextState() );
+			if constexpr( useEnumStrings )
+			{
+				out << " (";
+				priv::PrintEnumString( out, _strStates[tev.nextState()] );
+				out << ')';
+			}
 			out << '\n';
 		}
 
-#ifdef SPAG_USE_SIGNALS
-		for( size_t j=0; j<stinf._innerTransList.size(); ++j )
+		if constexpr( useInnerEvents )
 		{
-			if( print_content )
-				printLineHeader( out, i, false, maxlength );
-			else
-				print_content = true;
-
-			const auto &itr = stinf._innerTransList[j];
-			auto dst_st = SPAG_P_CAST2IDX(itr._destState);
-			auto i_ev   = SPAG_P_CAST2IDX(itr._innerEvent);
-			out << "IT ("
-				<< ( _innerEventFlag.at(itr._innerEvent)?'A':'I')
-				<< "): E" << std::setw(2) << i_ev;
-#ifdef SPAG_ENUM_STRINGS
-			out << " (";
-			priv::PrintEnumString( out, _strEvents[i_ev] );
-			out << ')';
-#endif // SPAG_ENUM_STRINGS
+			for( size_t i_ev=0; i_ev<nbEvents(); ++i_ev )
+			{
+				if( !stinf._innerMask[i_ev] )
+					continue;
+				if( print_content )
+					printLineHeader( out, i, false, maxlength );
+				else
+					print_content = true;
 
-			out << " => S" << std::setw(2) << dst_st;
+				auto dst_st = SPAG_P_CAST2IDX( _table.next( i_ev, i ) );
+				out << "IT ("
+					<< ( _innerEventActive.test(i_ev)?'A':'I')
+					<< "): E" << std::setw(2) << i_ev;
+				if constexpr( useEnumStrings )
+				{
+					out << " (";
+					priv::PrintEnumString( out, _strEvents[i_ev] );
+					out << ')';
+				}
 
-#ifdef SPAG_ENUM_STRINGS
-			out << " (";
-			priv::PrintEnumString( out, _strStates[dst_st] );
-			out << ')';
-#endif // SPAG_ENUM_STRINGS
+				out << " => S" << std::setw(2) << dst_st;
 
-			out << '\n';
-		}
+				if constexpr( useEnumStrings )
+				{
+					out << " (";
+					priv::PrintEnumString( out, _strStates[dst_st] );
+					out << ')';
+				}
 
-		if( stinf._isPassState )
-		{
-			if( print_content )
-				printLineHeader( out, i, false, maxlength );
-			else
-				print_content = true;
+				out << '\n';
+			}
 
-			out << "AAT: => S" << std::setw(2) << SPAG_P_CAST2IDX( _transitionMat[ nbEvents()+1 ][i] );
-#ifdef SPAG_ENUM_STRINGS
-			out << " (";
-			priv::PrintEnumString( out, _strStates[_transitionMat[ nbEvents()+1 ][i]] );
-			out << ')';
-#endif // SPAG_ENUM_STRINGS
-			out << '\n';
+			if( stinf._isPassState )
+			{
+				if( print_content )
+					printLineHeader( out, i, false, maxlength );
+				else
+					print_content = true;
+
+				out << "AAT: => S" << std::setw(2) << SPAG_P_CAST2IDX( _table.next( nbEvents()+1, i ) );
+				if constexpr( useEnumStrings )
+				{
+					out << " (";
+					priv::PrintEnumString( out, _strStates[ SPAG_P_CAST2IDX( _table.next( nbEvents()+1, i ) ) ] );
+					out << ')';
+				}
+				out << '\n';
+			}
 		}
-#endif // SPAG_USE_SIGNALS
 
 		if( !print_content )
 			out << "-\n";
@@ -2311,9 +3747,9 @@ SpagFSM<ST,EV,T,CBA>::printStateConfig( std::ostream& out ) const
 }
 //-----------------------------------------------------------------------------------
 /// Printing function, prints transition table and states info
-template<typename ST, typename EV,typename T,typename CBA>
+template<typename ST, typename EV,typename T,typename CBA,typename TRAITS>
 void
-SpagFSM<ST,EV,T,CBA>::printConfig( std::ostream& out, const char* msg ) const
+SpagFSM<ST,EV,T,CBA,TRAITS>::printConfig( std::ostream& out, const char* msg ) const
 {
 	out << "\n* FSM Configuration: ";
 	if( msg )
@@ -2330,9 +3766,9 @@ SpagFSM<ST,EV,T,CBA>::printConfig( std::ostream& out, const char* msg ) const
 /**
 DO NOT give the extension in argument, is is added here.
 */
-template<typename ST, typename EV,typename T,typename CBA>
+template<typename ST, typename EV,typename T,typename CBA,typename TRAITS>
 void
-SpagFSM<ST,EV,T,CBA>::writeDotFile( std::string fname, DotFileOptions opt ) const
+SpagFSM<ST,EV,T,CBA,TRAITS>::writeDotFile( std::string fname, DotFileOptions opt ) const
 {
 	std::string full_fn = fname + ".dot";
 	std::ofstream f( full_fn );
@@ -2357,14 +3793,13 @@ SpagFSM<ST,EV,T,CBA>::writeDotFile( std::string fname, DotFileOptions opt ) cons
 			f << j << " [label=\"";
 			if( opt.showStateIndex )
 				f << 'S' << std::setw(2) << j;
-	#ifdef SPAG_ENUM_STRINGS
-			if( opt.showStateString )
-			{
-				if( opt.showStateIndex )
-					f << "\\n";
-				f << _strStates[j];
-			}
-	#endif
+			if constexpr( useEnumStrings )
+				if( opt.showStateString )
+				{
+					if( opt.showStateIndex )
+						f << "\\n";
+					f << _strStates[j];
+				}
 			f << '"';
 
 			if( j == 0 )                                // initial state
@@ -2381,24 +3816,21 @@ SpagFSM<ST,EV,T,CBA>::writeDotFile( std::string fname, DotFileOptions opt ) cons
 	f << "\n/* External events */\n";
 	for( size_t i=0; i<nbEvents(); i++ )
 		for( size_t j=0; j<nbStates(); j++ )
-			if( _allowedMat[i][j] == 1 )
+			if( _table.allowed( i, j ) == 1 )
 			{
-#ifdef SPAG_USE_SIGNALS
-				if( !_stateInfo[j]._isPassState )
-#endif
+				if( !isPassState( j ) )
 					if( isReachable( j ) || opt.showUnreachableStates )
 					{
-						f << j << " -> " << _transitionMat[i][j] << " [label=\"";
+						f << j << " -> " << _table.next( i, j ) << " [label=\"";
 						if( opt.showEventIndex )
 							f << 'E' << std::setw(2) << i;
-#ifdef SPAG_ENUM_STRINGS
-						if( opt.showEventString )
-						{
-							if( opt.showEventIndex )
-								f << ':';
-							f << _strEvents[i];
-						}
-#endif
+						if constexpr( useEnumStrings )
+							if( opt.showEventString )
+							{
+								if( opt.showEventIndex )
+									f << ':';
+								f << _strEvents[i];
+							}
 						f << "\"];\n";
 					}
 			}
@@ -2410,7 +3842,7 @@ SpagFSM<ST,EV,T,CBA>::writeDotFile( std::string fname, DotFileOptions opt ) cons
 		if( tev._enabled && opt.showTimeOuts )
 			if( isReachable( j ) || opt.showUnreachableStates )
 			{
-				f << j << " -> " << tev._nextState
+				f << j << " -> " << tev.nextState()
 					<< " [label=\"TO:"
 					<< tev._duration
 					<< priv::stringFromTimeUnit( tev._durUnit )
@@ -2419,40 +3851,40 @@ SpagFSM<ST,EV,T,CBA>::writeDotFile( std::string fname, DotFileOptions opt ) cons
 					f << ",color=blue";
 				f << "];\n";
 			}
-#ifdef SPAG_USE_SIGNALS
-		if( _stateInfo[j]._isPassState && opt.showAAT )
+		if( isPassState( j ) && opt.showAAT )
 			if( isReachable( j ) || opt.showUnreachableStates )
 			{
-				f << j << " -> " << _transitionMat[ nbEvents()+1 ][j] << " [label=\"AAT\"";
+				f << j << " -> " << _table.next( nbEvents()+1, j ) << " [label=\"AAT\"";
 				if( opt.useColorsEventType )
 					f << ",color=green";
 				f << "];\n";
 			}
-		if( opt.showInnerEvents )
-		{
-			for( const auto& itr: _stateInfo[j]._innerTransList )
+		if constexpr( useInnerEvents )
+			if( opt.showInnerEvents )
 			{
-				if( isReachable( j ) || opt.showUnreachableStates )
+				for( size_t i_ev=0; i_ev<nbEvents(); i_ev++ )
 				{
-					f << j << " -> " << SPAG_P_CAST2IDX( itr._destState ) << " [label=\"";
-					if( opt.showEventIndex )
-						f << "IE" << std::setw(2) << SPAG_P_CAST2IDX( itr._innerEvent );
-#ifdef SPAG_ENUM_STRINGS
-					if( opt.showEventString )
+					if( !_stateInfo[j]._innerMask[i_ev] )
+						continue;
+					if( isReachable( j ) || opt.showUnreachableStates )
 					{
+						f << j << " -> " << SPAG_P_CAST2IDX( _table.next( i_ev, j ) ) << " [label=\"";
 						if( opt.showEventIndex )
-							f << ':';
-						f << _strEvents.at(itr._innerEvent);
+							f << "IE" << std::setw(2) << i_ev;
+						if constexpr( useEnumStrings )
+							if( opt.showEventString )
+							{
+								if( opt.showEventIndex )
+									f << ':';
+								f << _strEvents.at(i_ev);
+							}
+						f << '"';
+						if( opt.useColorsEventType )
+							f << ",color=red";
+						f << "];\n";
 					}
-#endif // SPAG_ENUM_STRINGS
-					f << '"';
-					if( opt.useColorsEventType )
-						f << ",color=red";
-					f << "];\n";
 				}
 			}
-		}
-#endif // SPAG_USE_SIGNALS
 	}
 	f << "}\n";
 
@@ -2487,6 +3919,153 @@ if the svg file is loaded as an image inside the web page.
 #endif
 #endif
 }
+//-----------------------------------------------------------------------------------
+/// Shared and frozen configuration of FsmInstance objects
+/**
+Holds a reference-counted pointer on a configured SpagFSM, that can only be accessed as \c const afterwards.
+The configuration is checked and frozen once, by the constructor, that calls SpagFSM::finalize().
+\code
+auto p_fsm = std::make_shared<fsm_t>();
+p_fsm->assignTransition( ... );
+...
+spag::FsmConfig<fsm_t> config( p_fsm );
+std::vector<spag::FsmInstance<fsm_t>> v_fsm( 100000, spag::FsmInstance<fsm_t>( config ) );
+\endcode
+*/
+template<typename FSM>
+class FsmConfig
+{
+	public:
+		explicit FsmConfig( std::shared_ptr<FSM> fsm )
+		{
+			SPAG_P_ASSERT( fsm, "null configuration" );
+			if( fsm->hasInnerEvents() )
+				SPAG_P_THROW_ERROR_CFG( "inner events and pass states can not be used with a shared configuration" );
+			fsm->finalize();
+			_fsm = std::move( fsm );
+		}
+		const FSM& operator *  () const { return *_fsm; }
+		const FSM* operator -> () const { return _fsm.get(); }
+
+	private:
+		std::shared_ptr<const FSM> _fsm;
+};
+
+//-----------------------------------------------------------------------------------
+/// A FSM that shares its configuration (transition table, timeouts, callbacks, strings) with other instances
+/**
+Only holds the run-time state (current and previous states, running flag, pointer on event handler)
+and a shared pointer on the configuration, so it is a few dozen bytes, whatever the size of the FSM.
+It provides the run-time functions of SpagFSM (start(), processEvent(), ...), so it can be used with the same timer classes.
+
+Limitations:
+ - inner events and pass states are not available (checked by FsmConfig),
+ - callbacks are shared, so they do not know which instance they are called for,
+ - with logging (see FsmTraits::logging), the counters are those of the configuration, thus shared too.
+*/
+template<typename FSM>
+class FsmInstance;
+
+template<typename ST, typename EV,typename TIM,typename CBA,typename TRAITS>
+class FsmInstance<SpagFSM<ST,EV,TIM,CBA,TRAITS>>
+{
+	using fsm_t = SpagFSM<ST,EV,TIM,CBA,TRAITS>;
+
+	public:
+		explicit FsmInstance( FsmConfig<fsm_t> config )
+			: _config( std::move( config ) )
+		{}
+
+		void assignEventHandler( TIM* t )
+		{
+			static_assert( std::is_same<TIM,priv::NoTimer<ST,EV,CBA>>::value == false, "Error, FSM type has no timer" );
+			_rs._eventHandler = t;
+		}
+
+/// Returns the shared configuration
+		const fsm_t& config() const { return *_config; }
+
+/** \name Run time functions, see SpagFSM */
+///@{
+		void start()
+		{
+			SPAG_P_ASSERT( !_rs._isRunning, "attempt to start an already running FSM" );
+			SPAG_LOG << "start FSM instance\n";
+			_config->start( _rs, this );
+		}
+		void stop() const
+		{
+			_config->stop( _rs );
+		}
+		void processTimeOut() const
+		{
+			_config->processTimeOut( _rs, this );
+		}
+		void processEvent( EV ev ) const
+		{
+			_config->processEvent( _rs, this, ev );
+		}
+		size_t processEvents( const EV* first, const EV* last, ST* trace=nullptr ) const
+		{
+			return _config->processEvents( _rs, this, first, last, trace );
+		}
+		template<typename CONT>
+		size_t processEvents( const CONT& events, ST* trace=nullptr ) const
+		{
+			return processEvents( std::data(events), std::data(events) + std::size(events), trace );
+		}
+		void postEvent( EV ev ) const
+		{
+			_config->postEvent( _rs, this, ev );
+		}
+		bool pushEvent( EV ev ) const
+		{
+			return _config->pushEvent( _rs, this, ev );
+		}
+		size_t processPushedEvents() const
+		{
+			return _config->processPushedEvents( _rs, this );
+		}
+/// Only here because the code of SpagFSM that defers the inner events is instantiated for instances too,
+/// with the timer classes that have \c postInnerEvent(): never called, as instances have no inner events (checked by FsmConfig)
+		template<typename SI>
+		void processInnerEvent( const SI& ) const
+		{
+			assert( 0 );
+		}
+/// Only here for the same reason as processInnerEvent()
+		const auto& getStateInfo( size_t idx ) const
+		{
+			return _config->_stateInfo[idx];
+		}
+///@}
+
+/** \name Getters, see SpagFSM */
+///@{
+		ST   currentState()  const { return _rs._current; }
+		ST   previousState() const { return _rs._previous; }
+		bool isRunning()     const { return _rs._isRunning; }
+		constexpr size_t nbStates() const { return SPAG_P_CAST2IDX(ST::NB_STATES); }
+		constexpr size_t nbEvents() const { return SPAG_P_CAST2IDX(EV::NB_EVENTS); }
+		std::pair<Duration,DurUnit> timeOutDuration( ST st ) const
+		{
+			return _config->timeOutDuration( st );
+		}
+		std::chrono::nanoseconds timeOutChrono( ST st ) const
+		{
+			return _config->timeOutChrono( st );
+		}
+		bool isDriftFreeTimeOut( ST st ) const
+		{
+			return _config->isDriftFreeTimeOut( st );
+		}
+///@}
+
+	private:
+		FsmConfig<fsm_t>                    _config;
+		mutable typename fsm_t::RunState_t _rs;
+};
+
 //-----------------------------------------------------------------------------------
 namespace priv {
 
@@ -2494,184 +4073,1351 @@ namespace priv {
 template<typename ST, typename EV,typename CBA>
 struct NoTimer
 {
-	void timerStart( const SpagFSM<ST,EV,NoTimer,CBA>* ) {}
-	void init(  const SpagFSM<ST,EV,NoTimer,CBA>* ) {}
+	template<typename FSM>
+	void timerStart( const FSM* ) {}
+	template<typename FSM>
+	void init( const FSM* ) {}
 	void timerCancel() {}
-	void raiseSignal() {}
+	void kill() {}
 };
 
 } // namespace priv
 
 //-----------------------------------------------------------------------------------
+namespace priv {
 
-#if defined (SPAG_USE_ASIO_WRAPPER)
+/// Private class, holds informations about a state of a DynamicSpagFSM. Same as StateInfo, without the inner events.
+template<typename CBA,typename CELL>
+struct DynStateInfo
+{
+	Duration                 _duration    = 0;            ///< timeout duration
+	std::chrono::nanoseconds _chrono      = {};           ///< same, as a \c std::chrono value
+	CELL                     _nextState   = 0;            ///< timeout: state to switch to
+	bool                     _enabled     = false;        ///< this state uses or not a timeout (default is no)
+	DurUnit                  _durUnit     = DurUnit::sec; ///< timeout duration unit
+	std::function<void(CBA)> _callback;                   ///< callback function
+	CBA                      _callbackArg = CBA();        ///< value of argument of callback function
+
+	friend std::ostream& operator << ( std::ostream& s, const DynStateInfo& si )
+	{
+		s << "DynStateInfo:"
+			<< "\n -has callback=" << (si._callback==0?"NO":"YES")
+			<< "\n -has timeout=" << si._enabled
+			<< '\n';
+		return s;
+	}
+};
+
+} // namespace priv
 
 //-----------------------------------------------------------------------------------
-/// Wraps the boost::asio stuff to have an asynchronous timer easily available
+/// A FSM whose number of states and events is given at run-time, for configurations that are loaded at startup
 /**
-Rationale: holds a timer, created by constructor. It can then be used without having to create one explicitly.
-That last point isn't that obvious, as it also must have a lifespan not limited to some callback function.
+States and events are given as indexes (\c size_t), and must be lower than the values given to the constructor.
 
-For timer duration, see
-http://en.cppreference.com/w/cpp/chrono/duration
+All the tables (transitions, allowed events, states information) are stored in a single contiguous heap allocation.
+States are stored with type \c CELL, so the number of states must not exceed its maximum value.
 
-\bug we have a problem with signal when both symbols SPAG_USE_SIGNALS and SPAG_EXTERNAL_EVENT_LOOP are defined:
-the signal handler is NOT called!!!
-See src/sample_3c.cpp that demonstrates the problem.
+Provides the same run-time interface as SpagFSM (\c start(), \c processEvent(), \c processTimeOut(), ...),
+so the same timer classes can be used, for example <code>DynamicSpagFSM<AsioWrapper<size_t,size_t,int>></code>.
+Compared to SpagFSM, the following features are not available:
+ - inner events and AAT (see \ref SPAG_USE_SIGNALS),
+ - logging (see \ref SPAG_ENABLE_LOGGING) and enum strings,
+ - configuration printing and dot file generation.
+
+types:
+ - TIM: a type handling the events, same as for SpagFSM
+ - CBA: the callback function type (single) argument
+ - CELL: the unsigned type used to store states in the tables
 */
-template<typename ST, typename EV, typename CBA>
-struct AsioWrapper
+template<typename TIM,typename CBA=int,typename CELL=uint16_t>
+class DynamicSpagFSM
 {
-	private:
+	using Callback_t = std::function<void(CBA)>;
+	using StateInfo  = priv::DynStateInfo<CBA,CELL>;
 
-// if external io_service, then we only hold a reference on it
+	public:
+/// Constructor, allocates all the tables for \c nbStates states and \c nbEvents events
+		DynamicSpagFSM( size_t nbStates, size_t nbEvents )
+			: _nbStates( nbStates )
+			, _nbEvents( nbEvents )
+		{
+			static_assert( std::is_unsigned<CELL>::value, "Error, CELL must be an unsigned integer type" );
+			if( nbStates < 2 )
+				SPAG_P_THROW_ERROR_CFG( "you need to provide at least two states" );
+			if( nbEvents < 1 )
+				SPAG_P_THROW_ERROR_CFG( "you need to provide at least one event" );
+			if( nbStates > std::numeric_limits<CELL>::max() )
+				SPAG_P_THROW_ERROR_CFG( "storage type is too small to hold " + std::to_string(nbStates) + " states" );
+
+			size_t nbCells = _nbEvents * _nbStates;
+			size_t offNext = alignUp( _nbStates * sizeof(StateInfo), alignof(CELL) );
+			size_t offAllowed = offNext + nbCells * sizeof(CELL);
+			_memory.reset( new unsigned char[ offAllowed + nbCells ] );   // single allocation
+
+			_stateInfo = reinterpret_cast<StateInfo*>( _memory.get() );
+			std::uninitialized_value_construct_n( _stateInfo, _nbStates );
+			_transitionMat = reinterpret_cast<CELL*>( _memory.get() + offNext );
+			_allowedMat    = reinterpret_cast<char*>( _memory.get() + offAllowed );
+			std::fill_n( _transitionMat, nbCells, static_cast<CELL>(0) );  // transition table filled with state 0
+			std::fill_n( _allowedMat, nbCells, 0 );                         // all events will be ignored at init
 
-#ifdef SPAG_EXTERNAL_EVENT_LOOP
-	#if BOOST_VERSION < 106600
-		boost::asio::io_service& _asio_service;
-		boost::asio::io_service::work _work;
-	#else
-		boost::asio::io_context& _asio_service;
-	#endif
-#else
-	#if BOOST_VERSION < 106600
-		boost::asio::io_service _asio_service;
-		boost::asio::io_service::work _work;
-	#else
-		boost::asio::io_context _asio_service;
-		boost::asio::executor_work_guard<boost::asio::io_context::executor_type> _ewg;
-	#endif
+#ifdef SPAG_EMBED_ASIO_WRAPPER
+			_eventHandler = &_asioWrapper;
 #endif
+		}
 
-	using SteadyClock = boost::asio::basic_waitable_timer<std::chrono::steady_clock>;
-
-	std::unique_ptr<SteadyClock> _asioTimer; ///< pointer on timer, will be allocated in constructor
-
-#ifdef SPAG_USE_SIGNALS
-	boost::asio::signal_set _signals;
-#endif
+		~DynamicSpagFSM()
+		{
+			std::destroy_n( _stateInfo, _nbStates );
+		}
 
-	public:
-/// Constructor
-#ifdef SPAG_EXTERNAL_EVENT_LOOP
-	#if BOOST_VERSION < 106600
-		AsioWrapper( boost::asio::io_service& io ) : _asio_service(io), _work( _io_service )
-	#else
-		AsioWrapper( boost::asio::io_context& io ) : _asio_service(io)
-	#endif
-#else
-	#if BOOST_VERSION < 106600
-		AsioWrapper() :  _work( _asio_service )
-	#else
-		AsioWrapper() : _ewg( boost::asio::make_work_guard( _asio_service ) )
-	#endif
-#endif
+		DynamicSpagFSM( const DynamicSpagFSM& ) = delete;            // non copyable
+		DynamicSpagFSM& operator = ( const DynamicSpagFSM& ) = delete;
 
-#ifdef SPAG_USE_SIGNALS
-	, _signals( _asio_service, SPAG_SIGNAL )
-#endif
-	{
-		_asioTimer = std::unique_ptr<SteadyClock>( new SteadyClock(_asio_service) );
-	}
+/** \name Configuration of FSM */
+///@{
 
-	AsioWrapper( const AsioWrapper& ) = delete; // non copyable
+/// Assigns an external transition event \c ev to switch from state \c st1 to state \c st2
+		void assignTransition( size_t st1, size_t ev, size_t st2 )
+		{
+			SPAG_CHECK_LESS( st1, _nbStates );
+			SPAG_CHECK_LESS( st2, _nbStates );
+			SPAG_CHECK_LESS( ev,  _nbEvents );
+			_transitionMat[ index( ev, st1 ) ] = static_cast<CELL>( st2 );
+			_allowedMat[    index( ev, st1 ) ] = 1;
+		}
 
-#if BOOST_VERSION < 106600
-	boost::asio::io_service& get_io_service()
-#else
-	boost::asio::io_context& get_io_service()
-#endif
-	{
-		return _asio_service;
-	}
+/// Whatever state we are on, if the event \c ev occurs, we switch to state \c st (except for state \c st)
+		void assignTransition( size_t ev, size_t st )
+		{
+			SPAG_CHECK_LESS( st, _nbStates );
+			SPAG_CHECK_LESS( ev, _nbEvents );
+			for( size_t i=0; i<_nbStates; i++ )
+			{
+				_transitionMat[ index( ev, i ) ] = static_cast<CELL>( st );
+				if( i != st )
+					_allowedMat[ index( ev, i ) ] = 1;
+			}
+		}
 
-/// Mandatory function for SpagFSM. Called only once, when FSM is started. Blocking
-	void init( spag::SpagFSM<ST,EV,AsioWrapper,CBA>* fsm )
-	{
-		SPAG_LOG << '\n';
-#ifdef SPAG_USE_SIGNALS
-		_signals.async_wait(            // initialize the signal handler, for deferred events
-			boost::bind(
-				&AsioWrapper<ST,EV,CBA>::signalHandler,
-				this,
-				boost::asio::placeholders::error,
-				boost::asio::placeholders::signal_number,
-				fsm
-			)
-		);
-#endif
-		_asio_service.run();          // blocking call !!!
-	}
+/// Allow event \c ev when on state \c st
+		void allowEvent( size_t st, size_t ev, bool what=true )
+		{
+			SPAG_CHECK_LESS( st, _nbStates );
+			SPAG_CHECK_LESS( ev, _nbEvents );
+			_allowedMat[ index( ev, st ) ] = (what?1:0);
+		}
 
-/// terminates all pending events, timers events or signals
-	void kill()
-	{
-		SPAG_LOG << '\n';
-#ifdef SPAG_USE_SIGNALS
-		_signals.cancel();
-		_signals.clear();
-#endif
-		_asio_service.stop();
-	}
+/// Assigns a timeout event on state \c st_curr, will switch to state \c st_next. With units
+		void assignTimeOut( size_t st_curr, Duration dur, DurUnit unit, size_t st_next )
+		{
+			static_assert( std::is_same<TIM,priv::NoTimer<size_t,size_t,CBA>>::value == false, "Error, FSM type has no timer" );
+			SPAG_CHECK_LESS( st_curr, _nbStates );
+			SPAG_CHECK_LESS( st_next, _nbStates );
+			auto& stinf = _stateInfo[ st_curr ];
+			stinf._duration  = dur;
+			stinf._chrono    = priv::toChrono( dur, unit );
+			stinf._durUnit   = unit;
+			stinf._nextState = static_cast<CELL>( st_next );
+			stinf._enabled   = true;
+		}
 
-/// Timer callback function, called when timer expires.
-	void timerCallback( const boost::system::error_code& err_code, const spag::SpagFSM<ST,EV,AsioWrapper,CBA>* fsm  )
-	{
-		SPAG_P_START;
+/// Assigns a timeout event on state \c st_curr, will switch to state \c st_next. With units as strings
+		void assignTimeOut( size_t st_curr, Duration dur, std::string unit, size_t st_next )
+		{
+			auto tu = priv::timeUnitFromString( unit );
+			if( !tu.first )
+				SPAG_P_THROW_ERROR_CFG( "invalid string value: " + unit );
+			assignTimeOut( st_curr, dur, tu.second, st_next );
+		}
 
-		switch( err_code.value() ) // check if called because of timeout, or because of canceling timeout operation
+/// Assigns a timeout event on state \c st_curr, will switch to state \c st_next. Duration will be \c dur, with the default unit
+		void assignTimeOut( size_t st_curr, Duration dur, size_t st_next )
 		{
-			case boost::system::errc::operation_canceled:    // do nothing
+			assignTimeOut( st_curr, dur, _defaultTimerUnit, st_next );
+		}
+
+/// Assigns a timeout event on state \c st_curr, will switch to state \c st_next, with default duration and unit
+		void assignTimeOut( size_t st_curr, size_t st_next )
+		{
+			assignTimeOut( st_curr, _defaultTimerValue, _defaultTimerUnit, st_next );
+		}
+
+/// Removes the timeout on state \c st
+		void clearTimeOut( size_t st )
+		{
+			SPAG_CHECK_LESS( st, _nbStates );
+			_stateInfo[ st ]._enabled = false;
+		}
+
+/// Removes all the timeouts
+		void clearTimeOuts()
+		{
+			for( size_t i=0; i<_nbStates; i++ )
+				_stateInfo[ i ]._enabled = false;
+		}
+
+/// Assigns a callback function to a state, will be called each time we arrive on this state
+		void assignCallback( size_t st, Callback_t func, CBA cb_arg=CBA() )
+		{
+			SPAG_CHECK_LESS( st, _nbStates );
+			_stateInfo[ st ]._callback    = std::move( func );
+			_stateInfo[ st ]._callbackArg = std::move( cb_arg );
+		}
+
+/// Assigns a callback function to all the states, will be called each time the state is activated
+		void assignCallback( Callback_t func )
+		{
+			for( size_t i=0; i<_nbStates; i++ )
+				_stateInfo[ i ]._callback = func;
+		}
+
+/// Assigns a callback function to all the states, with argument value being the state index (requires an integer type)
+		void assignCallbackAutoval( Callback_t func )
+		{
+			static_assert( std::numeric_limits<CBA>::is_integer, "To use this, Callback function argument MUST be an integer type" );
+			for( size_t i=0; i<_nbStates; i++ )
+			{
+				if( i > static_cast<size_t>( std::numeric_limits<CBA>::max() ) )
+					SPAG_P_THROW_ERROR_CFG( "type of callback argument too small to hold all the states" );
+				_stateInfo[ i ]._callback    = func;
+				_stateInfo[ i ]._callbackArg = static_cast<CBA>(i);
+			}
+		}
+
+/// Assigns a callback function called when an ignored event occurs
+		void assignIgnoredEventsCallback( std::function<void(size_t,size_t)> func )
+		{
+			_ignEventCallback = func;
+		}
+
+#ifndef SPAG_EMBED_ASIO_WRAPPER
+		void assignEventHandler( TIM* t )
+		{
+			static_assert( std::is_same<TIM,priv::NoTimer<size_t,size_t,CBA>>::value == false, "Error, FSM type has no timer" );
+			_eventHandler = t;
+		}
+#endif
+
+/// Sets the timer default value. See assignTimeOut()
+		void setTimerDefaultValue( Duration val )
+		{
+			_defaultTimerValue = val;
+		}
+/// Sets the timer default unit. See assignTimeOut()
+		void setTimerDefaultUnit( DurUnit unit )
+		{
+			_defaultTimerUnit = unit;
+		}
+///@}
+
+/** \name Run time functions */
+///@{
+/// start FSM : run callback associated to initial state (if any), an run timer (if any)
+		void start()
+		{
+			SPAG_P_ASSERT( !_isRunning, "attempt to start an already running FSM" );
+			SPAG_LOG << "start FSM\n";
+			_isRunning = true;
+			runAction();
+
+#ifndef SPAG_EXTERNAL_EVENT_LOOP
+			if( !std::is_same<TIM,priv::NoTimer<size_t,size_t,CBA>>::value )
+			{
+				SPAG_P_ASSERT( _eventHandler, "Event handler has not been allocated" );
+				_eventHandler->init( this );   // blocking function !
+			}
+#endif
+		}
+
+/// stop FSM : needed only if timer is used, this will cancel (and kill) the pending timer
+		void stop() const
+		{
+			SPAG_P_ASSERT( _isRunning, "attempt to stop an already stopped FSM" );
+			if( _eventHandler )
+			{
+				_eventHandler->timerCancel();
+				_eventHandler->kill();
+			}
+			_isRunning = false;
+		}
+
+/// User-code timer end function/callback should call this when the timer expires
+		void processTimeOut() const
+		{
+			assert( _stateInfo[ _current ]._enabled ); // or else, the timer shouldn't have been started, and thus we shouldn't be here...
+			_previous = _current;
+			_current  = _stateInfo[ _current ]._nextState;
+			runAction();
+		}
+
+/// User-code should call this function when an external event occurs
+		void processEvent( size_t ev ) const
+		{
+			SPAG_CHECK_LESS( ev, _nbEvents );
+			SPAG_P_ASSERT( _isRunning, "attempting to process an event but FSM is not started" );
+			SPAG_LOG << "processing event " << ev << '\n';
+
+			auto idx = index( ev, _current );
+			if( _allowedMat[ idx ] == 1 )
+			{
+				if( _stateInfo[ _current ]._enabled )        // 1 - cancel the waiting timer, if any
+				{
+					SPAG_P_ASSERT( _eventHandler, "Event handler has not been allocated" );
+					_eventHandler->timerCancel();
+				}
+				_previous = _current;
+				_current  = _transitionMat[ idx ];           // 2 - switch to next state
+				runAction();                                 // 3 - call the callback function
+			}
+			else
+			{
+				SPAG_LOG << "event is ignored on current state\n";
+				if( _ignEventCallback )
+					_ignEventCallback( _current, ev );
+			}
+		}
+
+///@}
+
+/** \name Misc. helper functions */
+///@{
+/// Return nb of states
+		size_t nbStates() const
+		{
+			return _nbStates;
+		}
+/// Return nb of events
+		size_t nbEvents() const
+		{
+			return _nbEvents;
+		}
+/// Return current state
+		size_t currentState() const
+		{
+			return _current;
+		}
+/// Return previous state (or initial state upon start() )
+		size_t previousState() const
+		{
+			return _previous;
+		}
+/// Return duration of time out for state \c st, or 0 if none
+		std::pair<Duration,DurUnit> timeOutDuration( size_t st ) const
+		{
+			assert( st < _nbStates );
+			return std::make_pair( _stateInfo[st]._duration, _stateInfo[st]._durUnit );
+		}
+/// Return duration of time out for state \c st as a \c std::chrono duration (computed when the timeout is assigned)
+		std::chrono::nanoseconds timeOutChrono( size_t st ) const
+		{
+			assert( st < _nbStates );
+			return _stateInfo[st]._chrono;
+		}
+///@}
+
+	private:
+		size_t index( size_t ev, size_t st ) const
+		{
+			return ev * _nbStates + st;
+		}
+
+		static constexpr size_t alignUp( size_t n, size_t align )
+		{
+			return ( n + align - 1 ) / align * align;
+		}
+
+/// Run associated action with a state switch (state has already switched). Same as SpagFSM::runAction()
+		void runAction() const
+		{
+			SPAG_LOG << "switched to state " << _current << '\n';
+			const auto& stateInfo = _stateInfo[ _current ];
+			if( stateInfo._enabled )
+			{
+				SPAG_P_ASSERT( _eventHandler, "Event handler has not been allocated" );
+				_eventHandler->timerStart( this );
+			}
+			if( stateInfo._callback ) // if there is a callback stored, then call it
+				stateInfo._callback( stateInfo._callbackArg );
+		}
+
+	private:
+		size_t _nbStates;
+		size_t _nbEvents;
+
+		mutable size_t    _current           = 0;
+		mutable size_t    _previous          = 0;
+		mutable bool      _isRunning         = false;
+		DurUnit           _defaultTimerUnit  = DurUnit::sec;  ///< default timer units
+		Duration          _defaultTimerValue = 1;             ///< default timer value
+		mutable TIM*      _eventHandler      = nullptr;       ///< pointer on timer/ event-loop handling object
+
+		std::unique_ptr<unsigned char[]> _memory;   ///< single allocation, holding the three arrays below
+		StateInfo* _stateInfo     = nullptr;        ///< Holds for each state the details (nbStates)
+		CELL*      _transitionMat = nullptr;        ///< next states, stored as <code>[event][state]</code>
+		char*      _allowedMat    = nullptr;        ///< allowed events (0:ignore, 1:handle), same layout
+
+#ifdef SPAG_EMBED_ASIO_WRAPPER
+		AsioWrapper<size_t,size_t,CBA> _asioWrapper; ///< optional wrapper around boost::asio::io_service (now `io_context`)
+#endif
+
+		std::function<void(size_t,size_t)> _ignEventCallback;     ///< ignored events callback function
+};
+
+//-----------------------------------------------------------------------------------
+/** \name Compile-time transition table, see StaticSpagFSM */
+///@{
+/// Transition from state \c ST1 to state \c ST2 on event \c EV, same as SpagFSM::assignTransition( ST st1, EV ev, ST st2 )
+template<auto ST1, auto EV, auto ST2>
+struct row {};
+
+/// Transition to state \c ST from all the other states on event \c EV, same as SpagFSM::assignTransition( EV ev, ST st )
+template<auto EV, auto ST>
+struct row_any {};
+
+/// Timeout of \c DUR (with unit \c UNIT) on state \c ST1, leading to state \c ST2, same as SpagFSM::assignTimeOut()
+template<auto ST1, Duration DUR, DurUnit UNIT, auto ST2>
+struct timeout {};
+
+/// The list of transitions and timeouts (spag::row, spag::row_any, spag::timeout) of a StaticSpagFSM
+template<typename... ROWS>
+struct table {};
+///@}
+
+//-----------------------------------------------------------------------------------
+namespace priv {
+
+/// Private class, holds informations about a state of a StaticSpagFSM, built at compile time
+template<typename ST>
+struct StaticStateInfo
+{
+	Duration                 _duration  = 0;            ///< timeout duration
+	std::chrono::nanoseconds _chrono    = {};           ///< same, as a \c std::chrono value
+	StateCell<ST>            _nextState = 0;            ///< timeout: state to switch to
+	bool                     _enabled   = false;        ///< this state uses or not a timeout (default is no)
+	DurUnit                  _durUnit   = DurUnit::sec; ///< timeout duration unit
+
+	friend std::ostream& operator << ( std::ostream& s, const StaticStateInfo& si )
+	{
+		s << "StaticStateInfo:"
+			<< "\n -has timeout=" << si._enabled
+			<< '\n';
+		return s;
+	}
+};
+
+//-----------------------------------------------------------------------------------
+/// Tables of a StaticSpagFSM, built at compile time from the rows of a spag::table, see buildStaticTable()
+template<typename ST, typename EV>
+struct StaticTableData
+{
+	static constexpr size_t nbSt = SPAG_P_CAST2IDX(ST::NB_STATES);
+	static constexpr size_t nbEv = SPAG_P_CAST2IDX(EV::NB_EVENTS);
+
+	std::array<StateCell<ST>,nbEv*nbSt>   _next      = {};  ///< next states, stored as <code>[event][state]</code>
+	std::array<char,nbEv*nbSt>            _allowed   = {};  ///< allowed events (0:ignore, 1:handle), same layout
+	std::array<StaticStateInfo<ST>,nbSt>  _stateInfo = {};  ///< timeouts
+
+	template<auto ST1, auto E, auto ST2>
+	constexpr void add( row<ST1,E,ST2> )
+	{
+		static_assert( std::is_same<decltype(ST1),ST>::value && std::is_same<decltype(ST2),ST>::value, "Error, row: states are not of the FSM states type" );
+		static_assert( std::is_same<decltype(E),EV>::value, "Error, row: event is not of the FSM events type" );
+		static_assert( SPAG_P_CAST2IDX(ST1) < nbSt && SPAG_P_CAST2IDX(ST2) < nbSt, "Error, row: invalid state" );
+		static_assert( SPAG_P_CAST2IDX(E) < nbEv, "Error, row: invalid event" );
+		auto idx = SPAG_P_CAST2IDX(E) * nbSt + SPAG_P_CAST2IDX(ST1);
+		_next[idx]    = static_cast<StateCell<ST>>( ST2 );
+		_allowed[idx] = 1;
+	}
+
+	template<auto E, auto S>
+	constexpr void add( row_any<E,S> )
+	{
+		static_assert( std::is_same<decltype(S),ST>::value, "Error, row_any: state is not of the FSM states type" );
+		static_assert( std::is_same<decltype(E),EV>::value, "Error, row_any: event is not of the FSM events type" );
+		static_assert( SPAG_P_CAST2IDX(S) < nbSt, "Error, row_any: invalid state" );
+		static_assert( SPAG_P_CAST2IDX(E) < nbEv, "Error, row_any: invalid event" );
+		for( size_t i=0; i<nbSt; i++ )
+		{
+			auto idx = SPAG_P_CAST2IDX(E) * nbSt + i;
+			_next[idx] = static_cast<StateCell<ST>>( S );
+			if( i != SPAG_P_CAST2IDX(S) )
+				_allowed[idx] = 1;
+		}
+	}
+
+	template<auto ST1, Duration DUR, DurUnit UNIT, auto ST2>
+	constexpr void add( timeout<ST1,DUR,UNIT,ST2> )
+	{
+		static_assert( std::is_same<decltype(ST1),ST>::value && std::is_same<decltype(ST2),ST>::value, "Error, timeout: states are not of the FSM states type" );
+		static_assert( SPAG_P_CAST2IDX(ST1) < nbSt && SPAG_P_CAST2IDX(ST2) < nbSt, "Error, timeout: invalid state" );
+		auto& stinf = _stateInfo[ SPAG_P_CAST2IDX(ST1) ];
+		stinf._duration  = DUR;
+		stinf._chrono    = toChrono( DUR, UNIT );
+		stinf._nextState = static_cast<StateCell<ST>>( ST2 );
+		stinf._enabled   = true;
+		stinf._durUnit   = UNIT;
+	}
+
+/// Same rule as SpagFSM::isReachable()
+	constexpr bool isReachable( size_t st ) const
+	{
+		for( size_t i=0; i<nbSt; i++ )
+			if( i != st )
+			{
+				for( size_t k=0; k<nbEv; k++ )
+					if( _next[ k*nbSt + i ] == st && _allowed[ k*nbSt + i ] != 0 )
+						return true;
+				if( _stateInfo[i]._enabled && _stateInfo[i]._nextState == st )
+					return true;
+			}
+		return false;
+	}
+
+/// Same rule as SpagFSM::doChecking(): a dead-end state has no timeout and no allowed transition leading to another state
+	constexpr bool isDeadEnd( size_t st ) const
+	{
+		if( _stateInfo[st]._enabled )
+			return false;
+		for( size_t k=0; k<nbEv; k++ )
+			if( _next[ k*nbSt + st ] != st && _allowed[ k*nbSt + st ] != 0 )
+				return false;
+		return true;
+	}
+
+/// Returns the index of the first unreachable state, or the number of states if none
+	constexpr size_t firstUnreachable() const
+	{
+		for( size_t i=1; i<nbSt; i++ )   // we start from index 1, because 0 is the initial state, and thus is always reachable!
+			if( !isReachable( i ) )
+				return i;
+		return nbSt;
+	}
+
+/// Returns the index of the first dead-end state, or the number of states if none
+	constexpr size_t firstDeadEnd() const
+	{
+		for( size_t i=0; i<nbSt; i++ )
+			if( isDeadEnd( i ) )
+				return i;
+		return nbSt;
+	}
+};
+
+/// Builds at compile time the tables of a StaticSpagFSM, from the rows of \c spag::table
+template<typename ST, typename EV, typename... ROWS>
+constexpr StaticTableData<ST,EV>
+buildStaticTable( table<ROWS...> )
+{
+	StaticTableData<ST,EV> data;
+	( data.add( ROWS() ), ... );
+	return data;
+}
+
+/// Fails to build if \c ST_IDX is not \c NB_ST, so that the compiler prints out the index of the faulty state
+template<size_t ST_IDX, size_t NB_ST>
+struct StaticCheckReachable
+{
+	static_assert( ST_IDX == NB_ST, "Error, StaticSpagFSM: state of index ST_IDX is unreachable" );
+	static constexpr bool value = true;
+};
+
+/// Fails to build if \c ST_IDX is not \c NB_ST, so that the compiler prints out the index of the faulty state
+template<size_t ST_IDX, size_t NB_ST>
+struct StaticCheckDeadEnd
+{
+	static_assert( ST_IDX == NB_ST, "Error, StaticSpagFSM: state of index ST_IDX is a dead-end" );
+	static constexpr bool value = true;
+};
+
+} // namespace priv
+
+//-----------------------------------------------------------------------------------
+/// A FSM whose transition table is given at compile time, as a \c spag::table type
+/**
+\code
+using fsm_t = spag::StaticSpagFSM<States,Events,
+	spag::table<
+		spag::row<st_Locked,   ev_Coin, st_Unlocked>,
+		spag::row<st_Unlocked, ev_Push, st_Locked>,
+		spag::timeout<st_Unlocked, 5, spag::DurUnit::sec, st_Locked>
+	>,
+	MyTimer
+>;
+\endcode
+
+The tables are built by the compiler and stored as \c static \c constexpr data, so there is nothing to build at run-time,
+and the configuration is checked at build time, with the same rules as SpagFSM::doChecking(), except that they are errors:
+the build fails if a state is unreachable or is a dead-end (the index of the state is given in the compiler message).
+
+Provides the same run-time interface as SpagFSM (\c start(), \c processEvent(), \c processTimeOut(), ...),
+so the same timer classes can be used. Only the callbacks can be assigned at run-time.
+Compared to SpagFSM, the following features are not available:
+ - inner events and AAT (see \ref SPAG_USE_SIGNALS),
+ - logging (see \ref SPAG_ENABLE_LOGGING) and enum strings,
+ - configuration printing and dot file generation.
+
+types:
+ - ST, EV: the states and events enums, same as for SpagFSM
+ - TABLE: the \c spag::table holding the transitions and timeouts
+ - TIM: a type handling the events, same as for SpagFSM
+ - CBA: the callback function type (single) argument
+*/
+template<typename ST, typename EV, typename TABLE, typename TIM=priv::NoTimer<ST,EV,int>, typename CBA=int>
+class StaticSpagFSM
+{
+	using Callback_t = std::function<void(CBA)>;
+	using Data_t     = priv::StaticTableData<ST,EV>;
+	using StateInfo  = priv::StaticStateInfo<ST>;
+
+	static constexpr size_t nbSt = Data_t::nbSt;
+	static constexpr size_t nbEv = Data_t::nbEv;
+	static_assert( nbSt > 1, "Error, you need to provide at least two states" );
+	static_assert( nbEv > 0, "Error, you need to provide at least one event" );
+
+	static constexpr Data_t _data = priv::buildStaticTable<ST,EV>( TABLE() );   ///< all the tables, in read-only memory
+
+	static_assert( priv::StaticCheckReachable<_data.firstUnreachable(),nbSt>::value );
+	static_assert( priv::StaticCheckDeadEnd<_data.firstDeadEnd(),nbSt>::value );
+
+	public:
+#ifdef SPAG_EMBED_ASIO_WRAPPER
+		StaticSpagFSM()
+		{
+			_rs._eventHandler = &_asioWrapper;
+		}
+#endif
+
+/** \name Configuration of FSM */
+///@{
+/// Assigns a callback function to a state, will be called each time we arrive on this state
+		void assignCallback( ST st, Callback_t func, CBA cb_arg=CBA() )
+		{
+			SPAG_CHECK_LESS( SPAG_P_CAST2IDX(st), nbSt );
+			_callback[ SPAG_P_CAST2IDX(st) ]    = std::move( func );
+			_callbackArg[ SPAG_P_CAST2IDX(st) ] = std::move( cb_arg );
+		}
+
+/// Assigns a callback function to all the states, will be called each time the state is activated
+		void assignCallback( Callback_t func )
+		{
+			for( auto& cb: _callback )
+				cb = func;
+		}
+
+/// Assigns a callback function to all the states, with argument value being the state index (requires an integer type)
+		void assignCallbackAutoval( Callback_t func )
+		{
+			static_assert( std::numeric_limits<CBA>::is_integer, "To use this, Callback function argument MUST be an integer type" );
+			static_assert( nbSt-1 <= static_cast<size_t>( std::numeric_limits<CBA>::max() ), "type of callback argument too small to hold all the states" );
+			for( size_t i=0; i<nbSt; i++ )
+			{
+				_callback[i]    = func;
+				_callbackArg[i] = static_cast<CBA>(i);
+			}
+		}
+
+/// Assigns a callback function called when an ignored event occurs
+		void assignIgnoredEventsCallback( std::function<void(ST,EV)> func )
+		{
+			_ignEventCallback = func;
+		}
+
+#ifndef SPAG_EMBED_ASIO_WRAPPER
+		void assignEventHandler( TIM* t )
+		{
+			static_assert( std::is_same<TIM,priv::NoTimer<ST,EV,CBA>>::value == false, "Error, FSM type has no timer" );
+			_rs._eventHandler = t;
+		}
+#endif
+///@}
+
+/** \name Run time functions */
+///@{
+/// start FSM : run callback associated to initial state (if any), an run timer (if any)
+		void start()
+		{
+			SPAG_P_ASSERT( !_rs._isRunning, "attempt to start an already running FSM" );
+			SPAG_LOG << "start FSM\n";
+			_rs._isRunning = true;
+			runAction();
+
+#ifndef SPAG_EXTERNAL_EVENT_LOOP
+			if( !std::is_same<TIM,priv::NoTimer<ST,EV,CBA>>::value )
+			{
+				SPAG_P_ASSERT( _rs._eventHandler, "Event handler has not been allocated" );
+				_rs._eventHandler->init( this );   // blocking function !
+			}
+#endif
+		}
+
+/// stop FSM : needed only if timer is used, this will cancel (and kill) the pending timer
+		void stop() const
+		{
+			SPAG_P_ASSERT( _rs._isRunning, "attempt to stop an already stopped FSM" );
+			if( _rs._eventHandler )
+			{
+				_rs._eventHandler->timerCancel();
+				_rs._eventHandler->kill();
+			}
+			_rs._isRunning = false;
+		}
+
+/// User-code timer end function/callback should call this when the timer expires
+		void processTimeOut() const
+		{
+			const auto& stinf = _data._stateInfo[ SPAG_P_CAST2IDX(_rs._current) ];
+			assert( stinf._enabled ); // or else, the timer shouldn't have been started, and thus we shouldn't be here...
+			_rs._previous = _rs._current;
+			_rs._current  = static_cast<ST>( stinf._nextState );
+			runAction();
+		}
+
+/// User-code should call this function when an external event occurs
+		void processEvent( EV ev ) const
+		{
+			SPAG_CHECK_LESS( SPAG_P_CAST2IDX(ev), nbEv );
+			SPAG_P_ASSERT( _rs._isRunning, "attempting to process an event but FSM is not started" );
+			dispatchEvent( ev );
+		}
+
+/// Processes all the external events in the range [first,last), in sequence, see SpagFSM::processEvents()
+		size_t processEvents( const EV* first, const EV* last, ST* trace=nullptr ) const
+		{
+			SPAG_P_ASSERT( _rs._isRunning, "attempting to process events but FSM is not started" );
+			for( const EV* it = first; it != last; ++it )
+				SPAG_CHECK_LESS( SPAG_P_CAST2IDX(*it), nbEv );
+
+			const EV* it = first;
+			for( ; it != last && _rs._isRunning; ++it )
+			{
+				dispatchEvent( *it );
+				if( trace )
+					*trace++ = _rs._current;
+			}
+			return it - first;
+		}
+
+/// Processes all the external events of the contiguous container \c events, see SpagFSM::processEvents()
+		template<typename CONT>
+		size_t processEvents( const CONT& events, ST* trace=nullptr ) const
+		{
+			return processEvents( std::data(events), std::data(events) + std::size(events), trace );
+		}
+
+///@}
+
+/** \name Misc. helper functions */
+///@{
+/// Return nb of states
+		constexpr size_t nbStates() const
+		{
+			return nbSt;
+		}
+/// Return nb of events
+		constexpr size_t nbEvents() const
+		{
+			return nbEv;
+		}
+/// Return current state
+		ST currentState() const
+		{
+			return _rs._current;
+		}
+/// Return previous state (or initial state upon start() )
+		ST previousState() const
+		{
+			return _rs._previous;
+		}
+		bool isRunning() const
+		{
+			return _rs._isRunning;
+		}
+/// Return duration of time out for state \c st, or 0 if none
+		std::pair<Duration,DurUnit> timeOutDuration( ST st ) const
+		{
+			assert( SPAG_P_CAST2IDX(st) < nbSt );
+			const auto& stinf = _data._stateInfo[ SPAG_P_CAST2IDX(st) ];
+			return std::make_pair( stinf._duration, stinf._durUnit );
+		}
+/// Return duration of time out for state \c st as a \c std::chrono duration (computed at build time)
+		std::chrono::nanoseconds timeOutChrono( ST st ) const
+		{
+			assert( SPAG_P_CAST2IDX(st) < nbSt );
+			return _data._stateInfo[ SPAG_P_CAST2IDX(st) ]._chrono;
+		}
+///@}
+
+	private:
+/// Handles the external event \c ev, once it has been checked. Same as SpagFSM::dispatchEvent()
+		void dispatchEvent( EV ev ) const
+		{
+			SPAG_LOG << "processing event " << SPAG_P_CAST2IDX(ev) << '\n';
+			auto cur_idx = SPAG_P_CAST2IDX(_rs._current);
+			auto idx = SPAG_P_CAST2IDX(ev) * nbSt + cur_idx;
+			if( _data._allowed[ idx ] == 1 )
+			{
+				if( _data._stateInfo[ cur_idx ]._enabled )   // 1 - cancel the waiting timer, if any
+				{
+					SPAG_P_ASSERT( _rs._eventHandler, "Event handler has not been allocated" );
+					_rs._eventHandler->timerCancel();
+				}
+				_rs._previous = _rs._current;
+				_rs._current  = static_cast<ST>( _data._next[ idx ] );   // 2 - switch to next state
+				runAction();                                              // 3 - call the callback function
+			}
+			else
+			{
+				SPAG_LOG << "event is ignored on current state\n";
+				if( _ignEventCallback )
+					_ignEventCallback( _rs._current, ev );
+			}
+		}
+
+/// Run associated action with a state switch (state has already switched). Same as SpagFSM::runAction()
+		void runAction() const
+		{
+			auto cur_idx = SPAG_P_CAST2IDX(_rs._current);
+			SPAG_LOG << "switched to state " << cur_idx << '\n';
+			if( _data._stateInfo[ cur_idx ]._enabled )
+			{
+				SPAG_P_ASSERT( _rs._eventHandler, "Event handler has not been allocated" );
+				_rs._eventHandler->timerStart( this );
+			}
+			if( _callback[ cur_idx ] ) // if there is a callback stored, then call it
+				_callback[ cur_idx ]( _callbackArg[ cur_idx ] );
+		}
+
+	private:
+		mutable priv::RunState<ST,TIM> _rs;                ///< run-time state (current state, timer, ...)
+		std::array<Callback_t,nbSt>    _callback;          ///< callback function of each state
+		std::array<CBA,nbSt>           _callbackArg = {};  ///< value of argument of callback function of each state
+
+#ifdef SPAG_EMBED_ASIO_WRAPPER
+		AsioWrapper<ST,EV,CBA> _asioWrapper; ///< optional wrapper around boost::asio::io_service (now `io_context`)
+#endif
+
+		std::function<void(ST,EV)> _ignEventCallback;     ///< ignored events callback function
+};
+
+//-----------------------------------------------------------------------------------
+/// Hierarchical timing wheel, holding the timeouts of many FSM (see WheelTimer)
+/**
+Time is divided in ticks of fixed duration (the resolution, 1 ms by default). The wheel has 4 levels of 256 slots:
+a timeout due in less than 256 ticks is stored in a slot of level 0 (one tick per slot), else in a slot of level 1
+(256 ticks per slot), and so on. Each time level 0 has done a full turn, the next slot of level 1 is emptied,
+its timeouts being spread over level 0 (and so on for the upper levels).
+The range is 2^32 ticks (about 49 days with 1 ms ticks); a longer timeout is stored in the farthest slot,
+and stored again when that slot is reached.
+
+Each timeout is a node of an intrusive doubly-linked list, held by the WheelTimer object:
+starting and canceling a timer are O(1), and nothing is allocated.
+
+The wheel does not measure time: tick() or advance() must be called periodically by the event loop (see AsioWheelDriver),
+or by any other tick source (for example a \c timerfd, whose read gives the number of ticks elapsed).
+The timeouts are counted from the last tick, plus one tick, so that they never expire early,
+except those started by a handler called by the wheel, that are counted from the tick being processed,
+so that a cycle of timeouts does not drift by one tick per period.
+
+Not thread-safe: all the calls must be done by the thread running the event loop.
+
+The wheel must outlive the objects using it (WheelTimer, AsioWheelDriver): their destructors access it.
+This is checked by the destructor, in debug builds.
+*/
+class TimingWheel
+{
+	public:
+		using Clock = std::chrono::steady_clock;
+
+/// A timeout stored in the wheel. When it expires, \c _fire is called with \c _ctx
+		struct Node
+		{
+			Node*       _prev   = nullptr;
+			Node*       _next   = nullptr;       ///< null if not armed
+			uint64_t    _expiry = 0;             ///< tick at which it expires
+			void      (*_fire)( const void* ) = nullptr;
+			const void* _ctx    = nullptr;
+
+			bool isArmed() const { return _next != nullptr; }
+		};
+
+		explicit TimingWheel( std::chrono::nanoseconds resolution = std::chrono::milliseconds(1) )
+			: _resolution( resolution ), _origin( Clock::now() )
+		{
+			if( _resolution.count() <= 0 )
+				SPAG_P_THROW_ERROR_CFG( "resolution must be positive" );
+			for( auto& slot: _slots )
+				slot._prev = slot._next = &slot;
+		}
+		~TimingWheel()
+		{
+			assert( _nbUsers == 0 );     // a WheelTimer or AsioWheelDriver would access the wheel after its destruction
+		}
+		TimingWheel( const TimingWheel& ) = delete;
+		TimingWheel& operator = ( const TimingWheel& ) = delete;
+
+/// Called by the constructors and destructors of the objects using the wheel, see the lifetime rule above
+		void attach() { _nbUsers++; }
+		void detach() { _nbUsers--; }
+
+/// Sets the function called (with \c ctx) when a timeout is started while the wheel is empty, outside of its handlers,
+/// so that the tick source, that may have stopped while the wheel was empty, can catch up with the elapsed time and resume (see AsioWheelDriver)
+		void setWakeUp( void (*wakeUp)( void* ), void* ctx )
+		{
+			_wakeUp    = wakeUp;
+			_wakeUpCtx = ctx;
+		}
+
+		std::chrono::nanoseconds resolution() const { return _resolution; }
+/// Number of ticks processed since construction
+		uint64_t currentTick() const { return _current; }
+/// Number of timeouts currently armed
+		size_t size() const { return _nbArmed; }
+
+/// Arms \c node, so that it expires after \c duration. If it was already armed, it is moved
+		void start( Node& node, std::chrono::nanoseconds duration )
+		{
+			if( _nbArmed == 0 && !_isFiring && _wakeUp )
+				_wakeUp( _wakeUpCtx );   // before computing the expiry, that is relative to the current tick
+			if( node.isArmed() )
+				unlink( node );
+			auto nb = duration.count() > 0 ? ( duration.count() + _resolution.count() - 1 ) / _resolution.count() : 0;
+			node._expiry = _current + static_cast<uint64_t>( nb ) + ( _isFiring ? 0 : 1 );
+			if( node._expiry <= _current )
+				node._expiry = _current + 1;
+			insert( node );
+			_nbArmed++;
+		}
+/// Disarms \c node, does nothing if it was not armed
+		void cancel( Node& node )
+		{
+			if( node.isArmed() )
+			{
+				unlink( node );
+				_nbArmed--;
+			}
+		}
+
+/// Processes \c nb ticks: calls the handlers of the timeouts that expire, returns their number
+		size_t tick( uint64_t nb = 1 )
+		{
+			size_t nbFired = 0;
+			for( ; nb != 0; nb-- )
+			{
+				if( _nbArmed == 0 )          // nothing to do in the remaining ticks
+				{
+					_current += nb;
+					break;
+				}
+				_current++;
+				for( size_t level=1; level<NbLevels; level++ )   // a lower level has completed a turn: spread the next slot of this one
+				{
+					if( ( _current & ( ( uint64_t(1) << ( SlotBits*level ) ) - 1 ) ) != 0 )
+						break;
+					Node list;
+					splice( slot( level, _current ), list );
+					while( list._next != &list )
+					{
+						Node& node = *list._next;
+						unlink( node );
+						insert( node );
+					}
+				}
+				Node list;
+				splice( slot( 0, _current ), list );
+				priv::FlagScope firing( _isFiring );
+				while( list._next != &list )  // a handler may cancel or start any timer, including the ones still in this list
+				{
+					Node& node = *list._next;
+					unlink( node );
+					_nbArmed--;
+					node._fire( node._ctx );
+					nbFired++;
+				}
+			}
+			return nbFired;
+		}
+/// Processes the ticks elapsed up to \c now, returns the number of timeouts expired
+		size_t advance( Clock::time_point now = Clock::now() )
+		{
+			if( now <= _origin )
+				return 0;
+			auto target = static_cast<uint64_t>( ( now - _origin ) / _resolution );
+			return target > _current ? tick( target - _current ) : 0;
+		}
+/// Time of the next tick, for the event loop
+		Clock::time_point nextTick() const
+		{
+			return _origin + _resolution * static_cast<Clock::rep>( _current + 1 );
+		}
+
+	private:
+		static constexpr size_t SlotBits = 8;
+		static constexpr size_t NbSlots  = size_t(1) << SlotBits;
+		static constexpr size_t NbLevels = 4;
+
+		Node& slot( size_t level, uint64_t tick )
+		{
+			return _slots[ level*NbSlots + ( ( tick >> ( SlotBits*level ) ) & ( NbSlots-1 ) ) ];
+		}
+/// Stores \c node in the slot matching its expiry, relative to the current tick
+		void insert( Node& node )
+		{
+			uint64_t expiry = node._expiry;
+			if( expiry <= _current )                                  // due: in the slot processed by the current tick
+				expiry = _current;
+			uint64_t delta = expiry - _current;
+			size_t level = 0;
+			while( level < NbLevels-1 && delta >= ( uint64_t(1) << ( SlotBits*(level+1) ) ) )
+				level++;
+			if( delta >= ( uint64_t(1) << ( SlotBits*NbLevels ) ) )  // out of range: farthest slot, stored again when reached
+				expiry = _current + ( uint64_t(1) << ( SlotBits*NbLevels ) ) - 1;
+			Node& head = slot( level, expiry );
+			node._prev = head._prev;
+			node._next = &head;
+			head._prev->_next = &node;
+			head._prev = &node;
+		}
+		static void unlink( Node& node )
+		{
+			node._prev->_next = node._next;
+			node._next->_prev = node._prev;
+			node._prev = node._next = nullptr;
+		}
+/// Moves all the nodes of list \c from to the empty list \c to
+		static void splice( Node& from, Node& to )
+		{
+			if( from._next == &from )
+			{
+				to._prev = to._next = &to;
+				return;
+			}
+			to._next = from._next;
+			to._prev = from._prev;
+			to._next->_prev = &to;
+			to._prev->_next = &to;
+			from._prev = from._next = &from;
+		}
+
+		std::chrono::nanoseconds           _resolution;
+		Clock::time_point                  _origin;
+		uint64_t                           _current  = 0;     ///< last tick processed
+		size_t                             _nbArmed  = 0;
+		bool                               _isFiring = false; ///< set while the handlers of a tick are called
+		std::array<Node,NbLevels*NbSlots>  _slots;            ///< heads of the circular lists, level after level
+		size_t                             _nbUsers  = 0;     ///< number of objects using the wheel, see attach()
+		void                             (*_wakeUp)( void* ) = nullptr;
+		void*                              _wakeUpCtx = nullptr;
+};
+
+//-----------------------------------------------------------------------------------
+/// Timer class for SpagFSM (or FsmInstance), whose timeouts are stored in a TimingWheel shared by many FSM
+/**
+One object per FSM, holding its node in the wheel, thus it is neither copyable nor movable.
+Starting and canceling the timer are O(1), without allocation nor system call, so many FSM with timeouts
+(one per connection, say) cost no more than one periodic timer, that drives the wheel (see AsioWheelDriver).
+
+As the wheel is run by an external event loop, \c init() does nothing: SpagFSM::start() returns immediately.
+For the same reason, \c kill() does nothing either: stopping a FSM only cancels its timer.
+Inner events and pass states are processed by the FSM itself (see SpagFSM::drainInnerEvents()).
+
+The wheel must outlive this object (checked in debug builds, see TimingWheel).
+*/
+template<typename ST, typename EV, typename CBA>
+class WheelTimer
+{
+	public:
+		explicit WheelTimer( TimingWheel& wheel ) : _wheel( wheel )
+		{
+			_wheel.attach();
+		}
+		~WheelTimer()
+		{
+			_wheel.cancel( _node );
+			_wheel.detach();
+		}
+		WheelTimer( const WheelTimer& ) = delete;
+		WheelTimer& operator = ( const WheelTimer& ) = delete;
+
+/// Mandatory function for SpagFSM
+		template<typename FSM>
+		void timerStart( const FSM* fsm )
+		{
+			auto duration = fsm->timeOutChrono( fsm->currentState() );   // computed when the timeout was assigned
+			SPAG_LOG << "Starting timer with duration=" << duration.count() << " ns\n";
+			_node._ctx  = fsm;
+			_node._fire = []( const void* p ){ static_cast<const FSM*>( p )->processTimeOut(); };   // lambda
+			_wheel.start( _node, duration );
+		}
+/// Mandatory function for SpagFSM
+		void timerCancel()
+		{
+			_wheel.cancel( _node );
+		}
+/// Mandatory function for SpagFSM
+		template<typename FSM>
+		void init( const FSM* ) {}
+/// Mandatory function for SpagFSM
+		void kill() {}
+
+	private:
+		TimingWheel&      _wheel;
+		TimingWheel::Node _node;
+};
+
+//-----------------------------------------------------------------------------------
+
+#if defined (SPAG_USE_ASIO_WRAPPER) || defined (SPAG_USE_EPOLL_WRAPPER)
+
+namespace priv {
+
+//-----------------------------------------------------------------------------------
+/// Private class, holds the deadline of the running timeout. Shared by the event loop classes AsioWrapper and EpollWrapper:
+/// computes the deadlines (drift-free or not, see SpagFSM::setDriftFreeTimeOut()), processes the expiry,
+/// and provides the handlers they post in their event loop
+class TimeOutDeadline
+{
+	public:
+/// Computes and returns the deadline of the timeout of the current state of \c fsm, that is started
+		template<typename FSM>
+		std::chrono::steady_clock::time_point start( const FSM* fsm )
+		{
+			auto duration = fsm->timeOutChrono( fsm->currentState() );   // computed when the timeout was assigned
+			SPAG_LOG << "Starting timer with duration=" << duration.count() << " ns\n";
+			_deadline = startTime( fsm ) + duration;
+			return _deadline;
+		}
+/// Returns the expiry of the running timeout
+		std::chrono::steady_clock::time_point get() const
+		{
+			return _deadline;
+		}
+
+/// Processes the timeout that has expired, recording its deadline for the next timeout, see startTime()
+		template<typename FSM>
+		void expire( const FSM* fsm )
+		{
+			_expired      = _deadline;
+			_expiredState = SPAG_P_CAST2IDX( fsm->currentState() );
+			FlagScope expiring( _isExpiring );       // reset even if a callback throws
+			fsm->processTimeOut();
+		}
+
+/// Returns the handler posted by the \c wakeUp() member function of the timer classes, that processes the pushed events
+		template<typename FSM>
+		static auto pushedEventsHandler( const FSM* fsm )
+		{
+			return [fsm](){ fsm->processPushedEvents(); };   // lambda
+		}
+/// Returns the handler posted by the \c postInnerEvent() member function of the timer classes, that processes the inner event or AAT
+/// of the current state. Can be called from any thread.
+/**
+The handlers are tagged with a generation number: as each one processes the current state when it runs, only the last one posted is needed.
+The previous ones are stale (the FSM may have left the state they were posted for), and are ignored.
+*/
+		template<typename FSM>
+		auto innerEventHandler( const FSM* fsm )
+		{
+			auto gen = _innerGen.fetch_add( 1, std::memory_order_relaxed ) + 1;
+			return [this,fsm,gen]()                          // lambda
+			{
+				if( gen != _innerGen.load( std::memory_order_relaxed ) )   // a later handler has been posted
+					return;
+				SPAG_LOG << "processing posted inner event, current state=" << SPAG_P_CAST2IDX( fsm->currentState() ) << '\n';
+				fsm->processInnerEvent( fsm->getStateInfo( SPAG_P_CAST2IDX( fsm->currentState() ) ) );
+			};
+		}
+
+	private:
+/// Returns the time the timeout that is started is measured from: the deadline of the timeout being processed,
+/// if the FSM switched directly from its state, and the current state is drift-free (see SpagFSM::setDriftFreeTimeOut()), else now.
+		template<typename FSM>
+		std::chrono::steady_clock::time_point startTime( const FSM* fsm )
+		{
+			bool isExpiring = _isExpiring;
+			_isExpiring = false;                   // only the first timeout started after the expiry can be drift-free
+			if constexpr( HasDriftFree<FSM>::value )
+				if( isExpiring
+					&& SPAG_P_CAST2IDX( fsm->previousState() ) == _expiredState
+					&& fsm->isDriftFreeTimeOut( fsm->currentState() )
+				)
+					return _expired;
+			return std::chrono::steady_clock::now();
+		}
+
+		std::chrono::steady_clock::time_point _deadline;             ///< expiry of the running timeout
+
+// used only with drift-free timeouts, see SpagFSM::setDriftFreeTimeOut()
+		std::chrono::steady_clock::time_point _expired;              ///< deadline of the timeout being processed
+		size_t                                _expiredState = 0;     ///< state that timeout was on
+		bool                                  _isExpiring   = false; ///< set while the FSM processes the timeout, until the next timeout is started
+
+		std::atomic<uint64_t>                 _innerGen{0};          ///< generation of the last inner event handler, see innerEventHandler()
+};
+
+} // namespace priv
+
+#endif // SPAG_USE_ASIO_WRAPPER || SPAG_USE_EPOLL_WRAPPER
+
+#if defined (SPAG_USE_ASIO_WRAPPER)
+
+//-----------------------------------------------------------------------------------
+/// Wraps the boost::asio stuff to have an asynchronous timer easily available
+/**
+Rationale: holds a timer, created by constructor. It can then be used without having to create one explicitly.
+That last point isn't that obvious, as it also must have a lifespan not limited to some callback function.
+
+For timer duration, see
+http://en.cppreference.com/w/cpp/chrono/duration
+
+Inner events and pass states are processed by a handler posted in the event loop (see postInnerEvent()), so they do not
+use OS signals: several FSM can use them in the same process, and this also works with an external event loop.
+*/
+template<typename ST, typename EV, typename CBA>
+struct AsioWrapper
+{
+	private:
+
+// if external io_service, then we only hold a reference on it
+
+#ifdef SPAG_EXTERNAL_EVENT_LOOP
+	#if BOOST_VERSION < 106600
+		boost::asio::io_service& _asio_service;
+		boost::asio::io_service::work _work;
+	#else
+		boost::asio::io_context& _asio_service;
+	#endif
+#else
+	#if BOOST_VERSION < 106600
+		boost::asio::io_service _asio_service;
+		boost::asio::io_service::work _work;
+	#else
+		boost::asio::io_context _asio_service;
+		boost::asio::executor_work_guard<boost::asio::io_context::executor_type> _ewg;
+	#endif
+#endif
+
+	using SteadyClock = boost::asio::basic_waitable_timer<std::chrono::steady_clock>;
+
+	std::unique_ptr<SteadyClock> _asioTimer; ///< pointer on timer, will be allocated in constructor
+
+	priv::TimeOutDeadline                 _deadline;             ///< expiry of the running timeout
+
+// used only with lazy cancelation, see setLazyCancel()
+	bool                                  _lazyCancel  = false;
+	bool                                  _armed       = false;  ///< a timeout is running (it may not be the one the pending wait was started for)
+	bool                                  _waitPending = false;  ///< an asynchronous wait is pending on \c _asioTimer
+	std::chrono::steady_clock::time_point _waitExpiry;           ///< expiry of the pending wait
+	uint64_t                              _waitGen     = 0;      ///< generation of the last wait started, the handlers of the previous ones are ignored
+
+	public:
+/// Constructor
+#ifdef SPAG_EXTERNAL_EVENT_LOOP
+	#if BOOST_VERSION < 106600
+		AsioWrapper( boost::asio::io_service& io ) : _asio_service(io), _work( _io_service )
+	#else
+		AsioWrapper( boost::asio::io_context& io ) : _asio_service(io)
+	#endif
+#else
+	#if BOOST_VERSION < 106600
+		AsioWrapper() :  _work( _asio_service )
+	#else
+		AsioWrapper() : _ewg( boost::asio::make_work_guard( _asio_service ) )
+	#endif
+#endif
+	{
+		_asioTimer = std::unique_ptr<SteadyClock>( new SteadyClock(_asio_service) );
+	}
+
+	AsioWrapper( const AsioWrapper& ) = delete; // non copyable
+
+/// Enables lazy cancelation of the timer (disabled by default). Must be called before the FSM is started.
+/**
+Then timerCancel() does not cancel the asio timer, it only marks the timeout as canceled, and timerStart() only records
+the new deadline if the pending wait expires before it: that wait is reused, and its handler waits again until the deadline.
+So a transition between two states with timeouts costs no asio operation, and no handler is run with \c operation_canceled.
+The handler of a wait whose timeout has been canceled (or replaced by a later one) is called once at its initial expiry, and ignored.
+
+Useful with high event rates, when most transitions cancel the timeout before it expires.
+*/
+	void setLazyCancel( bool b )
+	{
+		_lazyCancel = b;
+	}
+
+#if BOOST_VERSION < 106600
+	boost::asio::io_service& get_io_service()
+#else
+	boost::asio::io_context& get_io_service()
+#endif
+	{
+		return _asio_service;
+	}
+
+/// Mandatory function for SpagFSM. Called only once, when FSM is started. Blocking
+/**
+Type \c FSM is the SpagFSM type, it is templated so that any traits of SpagFSM can be used
+*/
+	template<typename FSM>
+	void init( FSM* )
+	{
+		SPAG_LOG << '\n';
+		_asio_service.run();          // blocking call !!!
+	}
+
+/// terminates all pending events, timers events or posted handlers
+	void kill()
+	{
+		SPAG_LOG << '\n';
+		_asio_service.stop();
+	}
+
+/// Timer callback function, called when timer expires.
+	template<typename FSM>
+	void timerCallback( const boost::system::error_code& err_code, const FSM* fsm  )
+	{
+		SPAG_P_START;
+
+		switch( err_code.value() ) // check if called because of timeout, or because of canceling timeout operation
+		{
+			case boost::system::errc::operation_canceled:    // do nothing
 				SPAG_LOG << "err_code=operation_canceled\n";
 			break;
 			case 0:
-				fsm->processTimeOut();                    // normal operation: timer has expired
+				_deadline.expire( fsm );                     // normal operation: timer has expired
 			break;
 			default:                                         // all other values
 				SPAG_P_THROW_ERROR_RT( "boost::asio timer unexpected error: " + err_code.message() );
 		}
 		SPAG_P_END;
 	}
-/// Mandatory function for SpagFSM. Cancel the pending async timer
+/// Mandatory function for SpagFSM. Cancel the pending async timer (or only marks it as canceled, see setLazyCancel())
 	void timerCancel()
 	{
 		SPAG_LOG << '\n';
-		_asioTimer->cancel_one();
+		if( _lazyCancel )
+			_armed = false;
+		else
+			_asioTimer->cancel_one();
 	}
 
 /// Start timer. Instanciation of mandatory function for SpagFSM
-	void timerStart( const spag::SpagFSM<ST,EV,AsioWrapper,CBA>* fsm )
+	template<typename FSM>
+	void timerStart( const FSM* fsm )
 	{
-		auto duration = fsm->timeOutDuration( fsm->currentState() );
-		SPAG_LOG << "Starting timer with duration=" << duration.first << '\n';
-		switch( duration.second )
+		auto deadline = _deadline.start( fsm );
+		if( _lazyCancel )
 		{
-#if BOOST_VERSION < 106600
-			case DurUnit::ms:
-				_asioTimer->expires_from_now( std::chrono::milliseconds(duration.first) );
-			break;
-			case DurUnit::sec:
-				_asioTimer->expires_from_now( std::chrono::seconds(duration.first) );
-			break;
-			case DurUnit::min:
-				_asioTimer->expires_from_now( std::chrono::minutes(duration.first) );
-			break;
-#else
-			case DurUnit::ms:
-				_asioTimer->expires_after( std::chrono::milliseconds(duration.first) );
-			break;
-			case DurUnit::sec:
-				_asioTimer->expires_after( std::chrono::seconds(duration.first) );
-			break;
-			case DurUnit::min:
-				_asioTimer->expires_after( std::chrono::minutes(duration.first) );
-			break;
-#endif
-			default: assert(0); // this should not happen...
+			_armed = true;
+			if( !_waitPending || _waitExpiry > deadline )    // else, the pending wait is reused
+				lazyWait( fsm, deadline );
+			return;
 		}
+		_asioTimer->expires_at( deadline );
 		_asioTimer->async_wait(
 			boost::bind(
-				&AsioWrapper<ST,EV,CBA>::timerCallback,
+				&AsioWrapper<ST,EV,CBA>::timerCallback<FSM>,
 				this,
 				boost::asio::placeholders::error,
 				fsm
@@ -2679,52 +5425,426 @@ struct AsioWrapper
 		);
 	}
 
-#ifdef SPAG_USE_SIGNALS
-/// This is a handler, automatically called by boost::io_service when an OS signal USR1 is detected (see init() ).
-/// \warning Only available when \ref SPAG_USE_SIGNALS is defined, see manual.
-	void signalHandler( const boost::system::error_code& err_code, int signal_number, spag::SpagFSM<ST,EV,AsioWrapper,CBA>* fsm )
+/// Starts an asynchronous wait until \c expiry, with lazy cancelation (see setLazyCancel()). Cancels the pending one, if any
+	template<typename FSM>
+	void lazyWait( const FSM* fsm, std::chrono::steady_clock::time_point expiry )
 	{
-		SPAG_P_START;
-
-		SPAG_LOG << "handling signal " << signal_number << " errorcode=" << err_code.message() << ", current state=" << fsm->currentState() << std::endl;
-		auto st_idx = SPAG_P_CAST2IDX( fsm->currentState() );
-		auto& stateInfo = fsm->getStateInfo( st_idx );
-//		std::cout << "signal handler, processing " << stateInfo._innerTrans;
-
-		SPAG_LOG << "BEFORE processInnerEvent(): " << stateInfo << '\n';
-		fsm->processInnerEvent( stateInfo );
-		SPAG_LOG << "AFTER processInnerEvent(): " << stateInfo << '\n';
-
-// update on 2020-04-05: new boost releases (from ???)
-// now doesn't have the == operator
-		if( !err_code )
-//		if( err_code == 0 )
-			_signals.async_wait(                                   // re-initialize signal handler, only if the handler is not called whith a "cancel" message
-				boost::bind(
-					&AsioWrapper<ST,EV,CBA>::signalHandler,
-					this,
-					boost::asio::placeholders::error,
-					boost::asio::placeholders::signal_number,
-					fsm
-				)
-			);
-		else
+		_waitPending = true;
+		_waitExpiry  = expiry;
+		auto gen = ++_waitGen;
+		_asioTimer->expires_at( expiry );
+		_asioTimer->async_wait( [this,fsm,gen]( const boost::system::error_code& err_code )    // lambda
 		{
-			SPAG_P_THROW_ERROR_RT( "Unexpected error boost::system::error_code: " + err_code.message() );
-		}
-		SPAG_P_END;
+			if( gen != _waitGen )             // replaced by a wait with an earlier expiry (may have expired meanwhile)
+				return;
+			_waitPending = false;
+			if( err_code || !_armed )         // canceled by kill(), or stale: the timeout has been canceled
+				return;
+			if( std::chrono::steady_clock::now() < _deadline.get() )
+				lazyWait( fsm, _deadline.get() );   // the timeout has been replaced by a later one
+			else
+			{
+				_armed = false;
+				_deadline.expire( fsm );
+			}
+		} );
 	}
-	void raiseSignal()
+
+/// Optional function for SpagFSM, called by SpagFSM::pushEvent() from any thread:
+/// queues a handler in the event loop, that will process the pushed events (<code>io_context::post()</code> is thread-safe)
+	template<typename FSM>
+	void wakeUp( const FSM* fsm )
 	{
-		SPAG_P_START;
-		std::raise( SPAG_SIGNAL );
-		SPAG_P_END;
+		post( priv::TimeOutDeadline::pushedEventsHandler( fsm ) );
+	}
+
+/// Optional function for SpagFSM, called when the FSM reaches a pass state, or a state with an active inner event,
+/// and by SpagFSM::activateInnerEvent(), from any thread:
+/// queues a handler in the event loop, that will process it once the current handler has completed.
+/**
+Unlike an OS signal, this is local to this event loop, and does not need a kernel round trip.
+If several handlers are pending, only the last one posted processes the current state, the previous ones are stale and ignored.
+Timer classes without this function get a call to their \c raiseSignal() member function instead,
+or, if they have none, the FSM processes it itself (see SpagFSM::drainInnerEvents()).
+*/
+	template<typename FSM>
+	void postInnerEvent( const FSM* fsm )
+	{
+		post( _deadline.innerEventHandler( fsm ) );
+	}
+
+	private:
+/// Queues \c handler in the event loop (thread-safe)
+	template<typename H>
+	void post( H handler )
+	{
+#if BOOST_VERSION < 106600
+		_asio_service.post( handler );
+#else
+		boost::asio::post( _asio_service, handler );
+#endif
 	}
+};
+
+//-----------------------------------------------------------------------------------
+/// Drives a TimingWheel from a boost::asio event loop, with a single periodic timer
+/**
+Each time the timer expires, processes the ticks elapsed (see TimingWheel::advance()), then waits for the next one.
+Thus the FSM using a WheelTimer can share the event loop with other asio objects (sockets, AsioWrapper, ...).
+
+The timer is only armed while the wheel holds timeouts: it stops after a tick that leaves the wheel empty,
+and is armed again when a timeout is started (see TimingWheel::setWakeUp()), so that an idle wheel does not wake up the event loop.
+The wheel must outlive this object (checked in debug builds, see TimingWheel).
+*/
+class AsioWheelDriver
+{
+	using SteadyClock = boost::asio::basic_waitable_timer<std::chrono::steady_clock>;
+
+	public:
+#if BOOST_VERSION < 106600
+		AsioWheelDriver( boost::asio::io_service& io, TimingWheel& wheel )
+#else
+		AsioWheelDriver( boost::asio::io_context& io, TimingWheel& wheel )
 #endif
+			: _timer( io ), _wheel( wheel )
+		{
+			_wheel.attach();
+		}
+		~AsioWheelDriver()
+		{
+			stop();
+			_wheel.detach();
+		}
+		AsioWheelDriver( const AsioWheelDriver& ) = delete;
+		AsioWheelDriver& operator = ( const AsioWheelDriver& ) = delete;
+
+/// Starts ticking (as soon as the wheel holds a timeout). Not blocking: the event loop must be run by the caller
+		void start()
+		{
+			_wheel.setWakeUp( []( void* p ){ static_cast<AsioWheelDriver*>( p )->wakeUp(); }, this );   // lambda
+			if( _wheel.size() != 0 )
+				wait();
+		}
+/// Stops ticking: the pending timeouts stay in the wheel
+		void stop()
+		{
+			_wheel.setWakeUp( nullptr, nullptr );
+			_timer.cancel();
+			_waiting = false;
+		}
+
+	private:
+/// Called by the wheel when a timeout is started while it is empty
+		void wakeUp()
+		{
+			_wheel.advance();                // catches up with the ticks elapsed while idle (nothing expires, the wheel is empty)
+			if( !_waiting )
+				wait();
+		}
+		void wait()
+		{
+			_waiting = true;
+			_timer.expires_at( _wheel.nextTick() );
+			_timer.async_wait( [this]( const boost::system::error_code& err_code )    // lambda
+			{
+				if( err_code || !_waiting )      // canceled, or expired before stop() was called
+					return;
+				_wheel.advance();
+				if( _wheel.size() != 0 )
+					wait();
+				else
+					_waiting = false;       // idle, until the next timeout is started
+			} );
+		}
+
+		SteadyClock  _timer;
+		TimingWheel& _wheel;
+		bool         _waiting = false;   ///< an asynchronous wait is pending on \c _timer
 };
 
 #endif // SPAG_USE_ASIO_WRAPPER
 
+#if defined (SPAG_USE_EPOLL_WRAPPER)
+
+//-----------------------------------------------------------------------------------
+/// A timer and event loop class for Linux, built on \c epoll, without Boost: same role as \c AsioWrapper
+/**
+The event loop waits on an \c epoll instance, that holds:
+ - a \c timerfd (\c CLOCK_MONOTONIC, armed with absolute deadlines), for the timeouts of the FSM,
+ - an \c eventfd, written when a handler is posted (see post()), possibly from another thread,
+ - the file descriptors added by the user with addFd() (sockets, pipes, devices, other timerfds, ...), whose handlers are called when they are ready.
+
+The timer is canceled lazily, as AsioWrapper does with AsioWrapper::setLazyCancel(): timerCancel() only marks the timeout as canceled,
+and timerStart() only arms the timerfd if the new deadline is earlier than the one it is armed with.
+When the timerfd expires, the expiry is ignored if the timeout has been canceled, or the timerfd is armed again if the timeout has been replaced by a later one.
+So a transition between two states with timeouts usually costs no system call.
+
+Inner events and pass states are processed by a posted handler (see postInnerEvent()), as with \c AsioWrapper,
+and the events pushed by other threads (see SpagFSM::pushEvent()) are processed by a handler posted by wakeUp().
+Drift-free timeouts (see SpagFSM::setDriftFreeTimeOut()) are supported.
+
+Without \c SPAG_EXTERNAL_EVENT_LOOP, SpagFSM::start() runs the event loop (blocking call, until SpagFSM::stop()).
+With it, the user code runs it with run(), and can share it with other event sources, added with addFd().
+*/
+template<typename ST, typename EV, typename CBA>
+class EpollWrapper
+{
+	public:
+/// Handler of a file descriptor added with addFd(), its argument is the \c epoll events that are ready (\c EPOLLIN, ...)
+		using FdHandler = std::function<void(uint32_t)>;
+
+		EpollWrapper()
+		{
+			_epollFd = epoll_create1( EPOLL_CLOEXEC );
+			if( _epollFd < 0 )
+				SPAG_P_THROW_ERROR_RT( "epoll_create1() failed: " + std::string( std::strerror( errno ) ) );
+			_timerFd = timerfd_create( CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC );
+			_eventFd = eventfd( 0, EFD_NONBLOCK | EFD_CLOEXEC );
+			if( _timerFd < 0 || _eventFd < 0 )
+			{
+				closeAll();
+				SPAG_P_THROW_ERROR_RT( "unable to create timerfd or eventfd: " + std::string( std::strerror( errno ) ) );
+			}
+			try
+			{
+				ctl( EPOLL_CTL_ADD, _timerFd, EPOLLIN );
+				ctl( EPOLL_CTL_ADD, _eventFd, EPOLLIN );
+			}
+			catch( ... )                                 // the destructor is not called
+			{
+				closeAll();
+				throw;
+			}
+		}
+		~EpollWrapper()
+		{
+			closeAll();
+		}
+		EpollWrapper( const EpollWrapper& ) = delete; // non copyable
+		EpollWrapper& operator = ( const EpollWrapper& ) = delete;
+
+/// Adds the file descriptor \c fd to the event loop: \c handler will be called when it is ready for \c events (\c EPOLLIN by default)
+/**
+The handler is called by the thread running the event loop, and must read (or write) the file descriptor,
+as it is registered in level-triggered mode. It can call the member functions of the FSM (SpagFSM::processEvent(), ...),
+and add or remove file descriptors (including its own).
+The file descriptor is not owned: the user code closes it, after having removed it with removeFd().
+*/
+		void addFd( int fd, FdHandler handler, uint32_t events = EPOLLIN )
+		{
+			if( _fdHandler.count( fd ) || fd == _timerFd || fd == _eventFd )
+				SPAG_P_THROW_ERROR_CFG( "file descriptor " + std::to_string( fd ) + " already added" );
+			ctl( EPOLL_CTL_ADD, fd, events );
+			_fdHandler[fd] = std::make_shared<FdHandler>( std::move( handler ) );
+		}
+/// Removes the file descriptor \c fd from the event loop (does nothing if it had not been added)
+		void removeFd( int fd )
+		{
+			auto it = _fdHandler.find( fd );
+			if( it == _fdHandler.end() )
+				return;
+			_fdHandler.erase( it );
+			epoll_ctl( _epollFd, EPOLL_CTL_DEL, fd, nullptr );
+		}
+
+/// Queues \c handler, that will be called by the thread running the event loop, once the current handler has completed.
+/// Can be called from any thread
+		void post( std::function<void()> handler )
+		{
+			bool wasEmpty;
+			{
+				std::lock_guard<std::mutex> lock( _mutex );
+				wasEmpty = _posted.empty();
+				_posted.push_back( std::move( handler ) );
+			}
+			if( wasEmpty )                               // else, the eventfd has already been written
+				notify();
+		}
+
+/// Runs the event loop, until kill() (called by SpagFSM::stop()) or stop(). Blocking
+		void run()
+		{
+			SPAG_LOG << '\n';
+			std::array<epoll_event,16> events;
+			while( !_stopped.load( std::memory_order_acquire ) )
+			{
+				int nb = epoll_wait( _epollFd, events.data(), static_cast<int>( events.size() ), -1 );
+				if( nb < 0 )
+				{
+					if( errno == EINTR )
+						continue;
+					SPAG_P_THROW_ERROR_RT( "epoll_wait() failed: " + std::string( std::strerror( errno ) ) );
+				}
+				for( int i=0; i<nb && !_stopped.load( std::memory_order_acquire ); i++ )
+				{
+					int fd = events[i].data.fd;
+					if( fd == _timerFd )
+						onTimer();
+					else if( fd == _eventFd )
+						onPosted();
+					else
+					{
+						auto it = _fdHandler.find( fd );
+						if( it != _fdHandler.end() )            // may have been removed by a previous handler
+						{
+							auto p_handler = it->second;         // keeps it alive, if the handler removes its own fd
+							(*p_handler)( events[i].events );
+						}
+					}
+				}
+			}
+		}
+/// Makes run() return, can be called from any thread. Then the event loop can not be run again, unless restart() is called
+		void stop()
+		{
+			_stopped.store( true, std::memory_order_release );
+			notify();
+		}
+/// Allows run() to be called again, after stop()
+		void restart()
+		{
+			_stopped.store( false, std::memory_order_release );
+		}
+
+/// Mandatory function for SpagFSM. Called only once, when FSM is started. Blocking
+		template<typename FSM>
+		void init( FSM* )
+		{
+			run();
+		}
+/// Mandatory function for SpagFSM, called by SpagFSM::stop(): stops the event loop
+		void kill()
+		{
+			SPAG_LOG << '\n';
+			stop();
+		}
+
+/// Mandatory function for SpagFSM. Only marks the timeout as canceled: if the timerfd expires, it is ignored
+		void timerCancel()
+		{
+			SPAG_LOG << '\n';
+			_armed = false;
+		}
+
+/// Mandatory function for SpagFSM. Arms the timerfd with the absolute deadline of the timeout (\c steady_clock is \c CLOCK_MONOTONIC)
+		template<typename FSM>
+		void timerStart( const FSM* fsm )
+		{
+			auto deadline = _deadline.start( fsm );
+			_armed    = true;
+			_fsm      = fsm;
+			_fire     = []( EpollWrapper* self, const void* p ){ self->_deadline.expire( static_cast<const FSM*>( p ) ); };   // lambda
+			if( !_fdArmed || _fdExpiry > deadline )      // else, the timerfd expires first, and will be armed again
+				arm( deadline );
+		}
+
+/// Optional function for SpagFSM, called by SpagFSM::pushEvent() from any thread:
+/// posts a handler that will process the pushed events
+		template<typename FSM>
+		void wakeUp( const FSM* fsm )
+		{
+			post( priv::TimeOutDeadline::pushedEventsHandler( fsm ) );
+		}
+
+/// Optional function for SpagFSM, called when the FSM reaches a pass state, or a state with an active inner event,
+/// and by SpagFSM::activateInnerEvent(), from any thread: posts a handler that will process it (no OS signal is raised)
+		template<typename FSM>
+		void postInnerEvent( const FSM* fsm )
+		{
+			post( _deadline.innerEventHandler( fsm ) );
+		}
+
+	private:
+/// Arms the timerfd with the absolute time \c expiry
+		void arm( std::chrono::steady_clock::time_point expiry )
+		{
+			auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>( expiry.time_since_epoch() ).count();
+			itimerspec spec{};
+			spec.it_value.tv_sec  = ns / 1000000000;
+			spec.it_value.tv_nsec = ns % 1000000000;
+			if( spec.it_value.tv_sec == 0 && spec.it_value.tv_nsec == 0 )   // a zero value would disarm the timer
+				spec.it_value.tv_nsec = 1;
+			if( timerfd_settime( _timerFd, TFD_TIMER_ABSTIME, &spec, nullptr ) < 0 )
+				SPAG_P_THROW_ERROR_RT( "timerfd_settime() failed: " + std::string( std::strerror( errno ) ) );
+			_fdArmed  = true;
+			_fdExpiry = expiry;
+		}
+		void ctl( int op, int fd, uint32_t events )
+		{
+			epoll_event ev{};
+			ev.events  = events;
+			ev.data.fd = fd;
+			if( epoll_ctl( _epollFd, op, fd, &ev ) < 0 )
+				SPAG_P_THROW_ERROR_RT( "epoll_ctl() failed on fd " + std::to_string( fd ) + ": " + std::string( std::strerror( errno ) ) );
+		}
+		void notify()
+		{
+			uint64_t one = 1;
+			auto nb = ::write( _eventFd, &one, sizeof(one) );    // only fails if the counter overflows, then it is already readable
+			(void)nb;
+		}
+		void closeAll()
+		{
+			for( int fd: { _timerFd, _eventFd, _epollFd } )
+				if( fd >= 0 )
+					::close( fd );
+		}
+
+/// The timerfd has expired: processes the timeout if it has not been canceled, or arms the timerfd again if it has been replaced by a later one
+		void onTimer()
+		{
+			uint64_t nb;
+			if( ::read( _timerFd, &nb, sizeof(nb) ) < 0 )     // spurious wake up
+				return;
+			_fdArmed = false;
+			if( !_armed )                                     // stale: the timeout has been canceled
+				return;
+			if( std::chrono::steady_clock::now() < _deadline.get() )
+				arm( _deadline.get() );
+			else
+			{
+				_armed = false;
+				_fire( this, _fsm );
+			}
+		}
+/// The eventfd has been written: calls the handlers posted until now. Those they post will be called on the next iteration
+		void onPosted()
+		{
+			uint64_t nb;
+			auto ret = ::read( _eventFd, &nb, sizeof(nb) );   // first, so that a handler posted meanwhile writes it again
+			(void)ret;
+			std::vector<std::function<void()>> v_handler;
+			{
+				std::lock_guard<std::mutex> lock( _mutex );
+				v_handler.swap( _posted );
+			}
+			for( auto& handler: v_handler )
+			{
+				if( _stopped.load( std::memory_order_acquire ) )
+					break;
+				handler();
+			}
+		}
+
+		int _epollFd = -1;
+		int _timerFd = -1;
+		int _eventFd = -1;
+
+		priv::TimeOutDeadline                 _deadline;             ///< expiry of the running timeout
+		std::chrono::steady_clock::time_point _fdExpiry;             ///< expiry the timerfd is armed with (may be earlier than \c _deadline)
+		bool                                  _armed        = false; ///< a timeout is running
+		bool                                  _fdArmed      = false; ///< the timerfd is armed
+		const void*                           _fsm          = nullptr;
+		void (*_fire)( EpollWrapper*, const void* )         = nullptr; ///< calls priv::TimeOutDeadline::expire() with the type of FSM that started the timer
+
+		std::map<int,std::shared_ptr<FdHandler>> _fdHandler;     ///< handlers of the file descriptors added with addFd()
+		std::vector<std::function<void()>>       _posted;        ///< posted handlers, protected by \c _mutex
+		std::mutex                               _mutex;
+		std::atomic<bool>                        _stopped{false};
+};
+
+#endif // SPAG_USE_EPOLL_WRAPPER
+
 //-----------------------------------------------------------------------------------
 
 } // namespace spag
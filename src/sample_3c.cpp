@@ -2,9 +2,8 @@
 \file sample_3c.cpp
 \brief Similar to sample_3b.cpp, but with external event handler
 
-\bug for some reason, we have a problem here:
-when SPAG_EXTERNAL_EVENT_LOOP is defined, the signal is raised but the handler is NOT called.
-Need to investigate this...
+The inner event used to be processed with an OS signal, that was never handled when SPAG_EXTERNAL_EVENT_LOOP was defined.
+It is now posted in the event loop, so this works either way.
 
 This file is part of Spaghetti, a C++ library for implementing Finite State Machines
 
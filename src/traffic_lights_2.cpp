@@ -12,13 +12,19 @@ Homepage: https://github.com/skramm/spaghetti
 
 #include "traffic_lights_common.hpp"
 
-#define SPAG_EMBED_ASIO_WRAPPER
+#define SPAG_USE_ASIO_WRAPPER
 #define SPAG_ENABLE_LOGGING
 #define SPAG_ENUM_STRINGS
 #include "spaghetti.hpp"
 
+/// The keyboard thread sends its events through the input queue, see UI_thread()
+struct Traits : spag::FsmTraits
+{
+	static constexpr size_t inputQueueSize = 16;
+};
+
 // states and events are declared in file traffic_lights_common.hpp
-SPAG_DECLARE_FSM_TYPE_ASIO( fsm_t, States, Events, std::string );
+using fsm_t = spag::SpagFSM<States,Events,spag::AsioWrapper<States,Events,std::string>,std::string,Traits>;
 
 /// global pointer on mutex, will get initialized in getSingletonMutex()
 std::mutex* g_mutex;
@@ -32,7 +38,9 @@ int main( int, char* argv[] )
 	g_mutex = getSingletonMutex();
 	try
 	{
+		spag::AsioWrapper<States,Events,std::string> asio;  // the event loop, also used by the keyboard thread to stop the FSM
 		fsm_t fsm;
+		fsm.assignEventHandler( &asio );
 		configureFSM<fsm_t>( fsm );
 		fsm.assignString2State( st_Red, "Red" );
 
@@ -43,7 +51,7 @@ int main( int, char* argv[] )
 		opt.showEventString = false;
 		fsm.writeDotFile( "traffic_lights_2", opt );
 
-		std::thread thread_ui( UI_thread<fsm_t>, &fsm );
+		std::thread thread_ui( UI_thread<fsm_t>, &fsm, std::ref( asio.get_io_service() ) );
 
 		fsm.start();  // blocking !
 		thread_ui.join();
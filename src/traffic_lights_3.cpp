@@ -19,8 +19,16 @@ Homepage: https://github.com/skramm/spaghetti
 #define SPAG_ENUM_STRINGS
 #include "spaghetti.hpp"
 
+/// The keyboard thread sends its events through the input queue, see UI_thread().
+/// The UDP server runs in the same event loop as the FSM, so it can call processEvent()
+struct Traits : spag::FsmTraits
+{
+	static constexpr size_t inputQueueSize = 16;
+};
+
 // States and events are declared in file traffic_lights_common.hpp
-SPAG_DECLARE_FSM_TYPE_ASIO( fsm_t, States, Events, std::string );
+using AsioEL = spag::AsioWrapper<States,Events,std::string>;
+using fsm_t  = spag::SpagFSM<States,Events,AsioEL,std::string,Traits>;
 
 /// global pointer on mutex, will get initialized in getSingletonMutex()
 std::mutex* g_mutex;
@@ -64,7 +72,7 @@ int main( int, char* argv[] )
 	g_mutex = getSingletonMutex();
 	try
 	{
-		spag::AsioEL asio;  // create Timer/event loop object
+		AsioEL asio;  // create Timer/event loop object
 
 		MyServer server( asio.get_io_service(), 12345 ); // create udp server with asio
 
@@ -79,7 +87,7 @@ int main( int, char* argv[] )
 		server.start_receive();
 
 		std::cout << "- thread start\n";
-		std::thread thread_ui( UI_thread<fsm_t>, &server.fsm );
+		std::thread thread_ui( UI_thread<fsm_t>, &server.fsm, std::ref( asio.get_io_service() ) );
 
 		std::cout << "- start fsm\n";
 		server.fsm.start();  // blocking !
@@ -12,6 +12,7 @@ Homepage: https://github.com/skramm/spaghetti
 #include <iostream>
 #include <vector>
 #include <boost/version.hpp>
+#include <boost/asio.hpp>
 
 extern std::mutex* g_mutex;
 
@@ -63,6 +64,8 @@ configureFSM( FSM& fsm )
 
 	fsm.assignTimeOut( st_BlinkOn,  500, "ms", st_BlinkOff );
 	fsm.assignTimeOut( st_BlinkOff, 500, "ms", st_BlinkOn );
+	fsm.setDriftFreeTimeOut( st_BlinkOn );    // the blinking period does not drift
+	fsm.setDriftFreeTimeOut( st_BlinkOff );
 
 	fsm.assignTransition( ev_Reset,     st_Init ); // if reception of message ev_Reset, then switch to state st_Init, whatever the current state is
 	fsm.assignTransition( st_Red,    ev_WarningOn, st_BlinkOn );
@@ -88,9 +91,12 @@ configureFSM( FSM& fsm )
 	fsm.assignStrings2Events( v_str );
 }
 //-----------------------------------------------------------------------------------
+/// Keyboard thread. As it is not the thread running the event loop, the events are sent with \c pushEvent(),
+/// so the FSM type needs an input queue (see \c FsmTraits::inputQueueSize).
+/// For the same reason, the FSM is stopped by a handler posted into the event loop \c io.
 template<typename FSM>
 void
-UI_thread( const FSM* fsm )
+UI_thread( const FSM* fsm, boost::asio::io_context& io )
 {
 	{
 		std::lock_guard<std::mutex> lock(*g_mutex);
@@ -109,19 +115,19 @@ UI_thread( const FSM* fsm )
 			{
 				case 'a':
 					std::cout << ": switch to warning mode\n";
-					fsm->processEvent( ev_WarningOn );
+					fsm->pushEvent( ev_WarningOn );
 				break;
 				case 'b':
 					std::cout << ": switch to normal mode\n";
-					fsm->processEvent( ev_WarningOff );
+					fsm->pushEvent( ev_WarningOff );
 				break;
 				case 'c':
 					std::cout << ": reset\n";
-					fsm->processEvent( ev_Reset );
+					fsm->pushEvent( ev_Reset );
 				break;
 				case 'q':
 					std::cout << ": QUIT\n";
-					fsm->stop();
+					boost::asio::post( io, [fsm](){ fsm->stop(); } ); // lambda
 					quit = true;
 				break;
 
@@ -1,6 +1,6 @@
 /**
-This cannot build as Always Active Transitions require enabling signals with 
-build option SPAG_USE_SIGNAL
+This cannot build as Always Active Transitions require the FSM trait \c FsmTraits::innerEvents
+(true by default only if \c SPAG_USE_SIGNALS is defined)
 */
 
 #define SPAG_EMBED_ASIO_WRAPPER
@@ -0,0 +1,21 @@
+/**
+This cannot build as a FunctionRef (used by callback policy FunctionRefCallback) can not be built from a temporary,
+it would be dangling as soon as the function returns.
+*/
+
+#include "../spaghetti.hpp"
+
+enum States { st0, st1, NB_STATES };
+enum Events { ev1, ev2, NB_EVENTS };
+
+struct Traits : spag::FsmTraits
+{
+	using Callback = spag::FunctionRefCallback;
+};
+
+int main()
+{
+	spag::SpagFSM<States,Events,spag::priv::NoTimer<States,Events,int>,int,Traits> fsm;
+	int a = 0;
+	fsm.assignCallback( st1, [&a](int){ a++; } );
+}
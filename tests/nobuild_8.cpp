@@ -0,0 +1,20 @@
+/**
+This cannot build as state st2 of the StaticSpagFSM is unreachable: no transition leads to it.
+*/
+
+#include "../spaghetti.hpp"
+
+enum States { st0, st1, st2, NB_STATES };
+enum Events { ev0, ev1, NB_EVENTS };
+
+int main()
+{
+	spag::StaticSpagFSM<States,Events,
+		spag::table<
+			spag::row<st0, ev0, st1>,
+			spag::row<st1, ev1, st0>,
+			spag::row<st2, ev1, st0>
+		>
+	> fsm;
+	fsm.start();
+}
@@ -0,0 +1,95 @@
+/**
+\file testA_10.cpp
+\brief checks that StaticSpagFSM (compile-time table) behaves the same as SpagFSM
+*/
+
+#include "spaghetti.hpp"
+#include "test_common.hpp"
+
+enum States { st0, st1, st2, st3, NB_STATES };
+enum Events { ev0, ev1, ev2, NB_EVENTS };
+
+/// Dummy timer, only prints out the calls, with the durations in their unit and in ms
+template<typename ST, typename EV, typename CBA>
+using PrintTimer = test::PrintTimer<ST,EV,CBA,test::PrintDuration::ValueMs>;
+
+using ptimer_t = PrintTimer<States,Events,int>;
+
+using static_t = spag::StaticSpagFSM<States,Events,
+	spag::table<
+		spag::row<st0, ev0, st1>,
+		spag::row<st1, ev1, st2>,
+		spag::row<st2, ev0, st3>,
+		spag::row_any<ev2, st0>,
+		spag::timeout<st1, 100, spag::DurUnit::ms, st0>,
+		spag::timeout<st2, 2, spag::DurUnit::sec, st0>
+	>,
+	ptimer_t
+>;
+
+void cb( int s )
+{
+	std::cout << " callback: state=" << s << '\n';
+}
+
+void ignored( States s, Events e )
+{
+	std::cout << " ignored event " << e << " on state " << s << '\n';
+}
+
+//-----------------------------------------------------------------------------------
+template<typename FSM>
+void
+run( FSM& fsm )
+{
+	fsm.assignCallbackAutoval( cb );
+	fsm.assignIgnoredEventsCallback( ignored );
+	fsm.start();
+	for( auto ev: { ev0, ev0, ev1, ev1, ev0, ev1, ev2, ev0, ev2, ev0, ev1 } )
+	{
+		std::cout << "event " << ev << '\n';
+		fsm.processEvent( ev );
+	}
+	std::cout << "timeout\n";
+	fsm.processTimeOut();
+	std::cout << "current state=" << fsm.currentState() << ", previous state=" << fsm.previousState() << '\n';
+}
+
+//-----------------------------------------------------------------------------------
+int main()
+{
+	{
+		std::cout << "\n*** SpagFSM\n";
+		ptimer_t timer;
+		spag::SpagFSM<States,Events,ptimer_t> fsm;
+		fsm.assignEventHandler( &timer );
+		fsm.assignTransition( st0, ev0, st1 );
+		fsm.assignTransition( st1, ev1, st2 );
+		fsm.assignTransition( st2, ev0, st3 );
+		fsm.assignTransition( ev2, st0 );
+		fsm.assignTimeOut( st1, 100, "ms", st0 );
+		fsm.assignTimeOut( st2, 2, "sec", st0 );
+		run( fsm );
+	}
+	{
+		std::cout << "\n*** StaticSpagFSM\n";
+		ptimer_t timer;
+		static_t fsm;
+		fsm.assignEventHandler( &timer );
+		run( fsm );
+	}
+	{
+		std::cout << "\n*** StaticSpagFSM, batch\n";
+		ptimer_t timer;
+		static_t fsm;
+		fsm.assignEventHandler( &timer );
+		fsm.start();
+		std::vector<Events> v_ev{ ev0, ev1, ev2, ev0, ev1, ev0 };
+		std::vector<States> v_trace( v_ev.size() );
+		auto n = fsm.processEvents( v_ev, v_trace.data() );
+		std::cout << "processed " << n << " events, trace:";
+		for( auto st: v_trace )
+			std::cout << ' ' << st;
+		std::cout << '\n';
+	}
+}
@@ -0,0 +1,83 @@
+/**
+\file testA_11.cpp
+\brief checks that two FSM types with different FsmTraits options can be used in the same program:
+one with enum strings and inner events (the defaults, from the build symbols), and a minimal one
+*/
+
+#define SPAG_ENUM_STRINGS
+#define SPAG_USE_SIGNALS
+#include "spaghetti.hpp"
+#include "test_common.hpp"
+
+enum States { st0, st1, st2, st3, NB_STATES };
+enum Events { ev0, ev1, iev, NB_EVENTS };
+
+using test::PrintTimer;
+
+struct MinimalTraits : spag::FsmTraits
+{
+	static constexpr bool logging     = false;
+	static constexpr bool enumStrings = false;
+	static constexpr bool innerEvents = false;
+};
+
+using ptimer_t = PrintTimer<States,Events,int>;
+using fsm_t    = spag::SpagFSM<States,Events,ptimer_t>;
+using minfsm_t = spag::SpagFSM<States,Events,ptimer_t,int,MinimalTraits>;
+
+void cb( int s )
+{
+	std::cout << " callback: state=" << s << '\n';
+}
+
+//-----------------------------------------------------------------------------------
+/// Configuration shared by both types
+template<typename FSM>
+void
+configure( FSM& fsm )
+{
+	fsm.assignCallbackAutoval( cb );
+	fsm.assignTransition( st0, ev0, st1 );
+	fsm.assignTransition( st1, ev1, st2 );
+	fsm.assignTransition( st2, ev0, st3 );
+	fsm.assignTransition( st3, ev1, st0 );
+	fsm.assignTimeOut( st2, 100, "ms", st0 );
+	fsm.assignString2State( st1, "Ready" );     // does nothing without enum strings
+	fsm.assignString2Event( ev1, "Go" );
+}
+
+//-----------------------------------------------------------------------------------
+template<typename FSM>
+void
+run( FSM& fsm )
+{
+	std::cout << "state st1: " << fsm.getString( st1 ) << ", event ev1: " << fsm.getString( ev1 ) << '\n';
+	fsm.printConfig( std::cout );
+	fsm.start();
+	for( auto ev: { ev0, ev1, ev1, ev0, ev1 } )
+		fsm.processEvent( ev );
+	std::cout << "state=" << fsm.currentState() << '\n';
+}
+
+//-----------------------------------------------------------------------------------
+int main()
+{
+	{
+		std::cout << "\n*** default traits\n";
+		ptimer_t timer;
+		fsm_t fsm;
+		fsm.assignEventHandler( &timer );
+		configure( fsm );
+		fsm.assignInnerTransition( st1, iev, st3 );
+		run( fsm );
+	}
+	{
+		std::cout << "\n*** minimal traits\n";
+		ptimer_t timer;
+		minfsm_t fsm;
+		fsm.assignEventHandler( &timer );
+		configure( fsm );
+		run( fsm );
+		std::cout << "smaller object: " << ( sizeof(minfsm_t) < sizeof(fsm_t) ) << '\n';
+	}
+}
@@ -0,0 +1,135 @@
+/**
+\file testA_12.cpp
+\brief checks postEvent(): events posted from the callbacks are processed once the current transition has completed, in order,
+without recursion
+*/
+
+#include "spaghetti.hpp"
+#include "test_common.hpp"
+
+enum States { st0, st1, st2, st3, NB_STATES };
+enum Events { ev0, ev1, ev2, NB_EVENTS };
+
+using test::DummyTimer;
+
+using dtimer_t = DummyTimer<States,Events,int>;
+using fsm_t    = spag::SpagFSM<States,Events,dtimer_t>;
+
+dtimer_t g_timer;
+
+int g_depth    = 0;   ///< number of callbacks currently running
+int g_maxDepth = 0;
+
+/// Counts the nested callbacks, during its lifetime
+struct DepthCounter
+{
+	DepthCounter()  { g_maxDepth = std::max( g_maxDepth, ++g_depth ); }
+	~DepthCounter() { g_depth--; }
+};
+
+//-----------------------------------------------------------------------------------
+void
+configure( fsm_t& fsm )
+{
+	fsm.assignEventHandler( &g_timer );
+	fsm.assignTransition( st0, ev0, st1 );
+	fsm.assignTransition( st1, ev1, st2 );
+	fsm.assignTransition( st2, ev2, st3 );
+	fsm.assignTransition( st1, ev2, st3 );
+	fsm.assignTransition( st3, ev0, st0 );
+}
+
+/// On state st1, the callback sends events ev1 and ev2, either with processEvent() or with postEvent()
+void
+assignCallbacks( fsm_t& fsm, bool post )
+{
+	g_maxDepth = 0;
+	fsm.assignCallbackAutoval( [&fsm,post]( int s )                              // lambda
+	{
+		DepthCounter dc;
+		std::cout << " enter S" << s << ", depth=" << g_depth << '\n';
+		if( s == st1 )
+			for( auto ev: { ev1, ev2 } )
+			{
+				if( post )
+					fsm.postEvent( ev );
+				else
+					fsm.processEvent( ev );
+			}
+		std::cout << " leave S" << s << '\n';
+	} );
+}
+
+//-----------------------------------------------------------------------------------
+int main()
+{
+	for( auto post: { false, true } )
+	{
+		std::cout << "\n*** callback uses " << ( post ? "postEvent()" : "processEvent()" ) << '\n';
+		fsm_t fsm;
+		configure( fsm );
+		assignCallbacks( fsm, post );
+		fsm.start();
+		fsm.processEvent( ev0 );
+		std::cout << "state=" << fsm.currentState() << ", max depth=" << g_maxDepth << '\n';
+	}
+	{
+		std::cout << "\n*** chain of 100000 posted events\n";
+		fsm_t fsm;
+		configure( fsm );
+		g_maxDepth = 0;
+		int nb = 0;
+		fsm.assignCallbackAutoval( [&fsm,&nb]( int s )                            // lambda
+		{
+			DepthCounter dc;
+			if( ++nb < 100000 )
+				fsm.postEvent( s == st0 ? ev0 : ( s == st1 ? ev2 : ev0 ) );
+		} );
+		fsm.start();
+		std::cout << "nb callbacks=" << nb << ", state=" << fsm.currentState() << ", max depth=" << g_maxDepth << '\n';
+	}
+	{
+		std::cout << "\n*** postEvent() outside of a callback\n";
+		fsm_t fsm;
+		configure( fsm );
+		fsm.start();
+		fsm.postEvent( ev0 );
+		std::cout << "state=" << fsm.currentState() << '\n';
+	}
+	{
+		std::cout << "\n*** queue full (capacity=" << spag::FsmTraits::postQueueSize << ")\n";
+		fsm_t fsm;
+		configure( fsm );
+		fsm.assignCallback( st1, [&fsm]( int )                             // lambda
+		{
+			for( size_t i=0; i<=spag::FsmTraits::postQueueSize; i++ )
+				fsm.postEvent( ev2 );
+		} );
+		fsm.start();
+		try
+		{
+			fsm.processEvent( ev0 );
+		}
+		catch( const std::runtime_error& )
+		{
+			std::cout << "postEvent(): error caught\n";
+		}
+		std::cout << "state=" << fsm.currentState() << '\n';
+		fsm.processEvent( ev2 );                   // posted events have been dropped
+		std::cout << "state=" << fsm.currentState() << '\n';
+	}
+	{
+		std::cout << "\n*** callback stops the FSM\n";
+		fsm_t fsm;
+		configure( fsm );
+		fsm.assignCallback( st1, [&fsm]( int )                             // lambda
+		{
+			fsm.postEvent( ev1 );
+			fsm.postEvent( ev2 );
+			fsm.stop();
+		} );
+		fsm.start();
+		fsm.processEvent( ev0 );
+		std::cout << "state=" << fsm.currentState() << '\n';
+	}
+}
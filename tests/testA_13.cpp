@@ -0,0 +1,103 @@
+/**
+\file testA_13.cpp
+\brief checks pushEvent(): events pushed in the thread-safe input queue, then processed by the thread running the event loop,
+with both queue full policies, and with several producer threads
+*/
+
+#include "spaghetti.hpp"
+#include "test_common.hpp"
+
+enum States { st0, st1, st2, st3, NB_STATES };
+enum Events { ev0, ev1, ev2, NB_EVENTS };
+
+using test::WakeTimer;
+
+struct DropTraits : spag::FsmTraits
+{
+	static constexpr size_t inputQueueSize = 8;
+};
+
+struct BlockTraits : spag::FsmTraits
+{
+	static constexpr size_t inputQueueSize = 16;
+	static constexpr spag::QueueFullPolicy inputQueuePolicy = spag::QueueFullPolicy::Block;
+};
+
+using wtimer_t = WakeTimer<States,Events,int>;
+template<typename TRAITS>
+using fsm_t = spag::SpagFSM<States,Events,wtimer_t,int,TRAITS>;
+
+//-----------------------------------------------------------------------------------
+/// Ring of states: ev0 moves to next state, ev1 goes back to st0
+template<typename FSM>
+void
+configure( FSM& fsm, wtimer_t& timer )
+{
+	fsm.assignEventHandler( &timer );
+	fsm.assignTransition( st0, ev0, st1 );
+	fsm.assignTransition( st1, ev0, st2 );
+	fsm.assignTransition( st2, ev0, st3 );
+	fsm.assignTransition( st3, ev0, st0 );
+	fsm.assignTransition( ev1, st0 );
+}
+
+//-----------------------------------------------------------------------------------
+int main()
+{
+	{
+		std::cout << "\n*** drop policy, capacity=8\n";
+		wtimer_t timer;
+		fsm_t<DropTraits> fsm;
+		configure( fsm, timer );
+		fsm.assignCallbackAutoval( []( int s ){ std::cout << " callback: state=" << s << '\n'; } );   // lambda
+		fsm.start();
+		int nbOk = 0;
+		for( int i=0; i<10; i++ )
+			nbOk += fsm.pushEvent( ev0 );
+		std::cout << "pushed=" << nbOk << ", dropped=" << fsm.nbDroppedEvents() << ", wake-ups=" << timer._nbWakeUp << '\n';
+		std::cout << "state=" << fsm.currentState() << '\n';
+		auto nb = fsm.processPushedEvents();
+		std::cout << "processed=" << nb << ", state=" << fsm.currentState() << '\n';
+		nb = fsm.processPushedEvents();
+		std::cout << "processed=" << nb << '\n';
+
+		fsm.pushEvent( ev1 );
+		fsm.pushEvent( ev0 );
+		std::cout << "wake-ups=" << timer._nbWakeUp << '\n';
+		nb = fsm.processPushedEvents();
+		std::cout << "processed=" << nb << ", state=" << fsm.currentState() << '\n';
+	}
+	{
+		std::cout << "\n*** block policy, 4 producer threads\n";
+		constexpr int nbThreads = 4;
+		constexpr int nbEvents  = 20000;
+		wtimer_t timer;
+		fsm_t<BlockTraits> fsm;
+		configure( fsm, timer );
+		int nbCallbacks = 0;
+		fsm.assignCallback( [&nbCallbacks]( int ){ nbCallbacks++; } );   // lambda
+		fsm.start();
+
+		std::vector<std::thread> v_thread;
+		for( int t=0; t<nbThreads; t++ )
+			v_thread.emplace_back( [&fsm]()                                // lambda
+			{
+				for( int i=0; i<nbEvents; i++ )
+					fsm.pushEvent( ev0 );
+			} );
+
+		size_t nb = 0;                                  // this thread acts as the event loop
+		while( nb < nbThreads * nbEvents )
+		{
+			auto n = fsm.processPushedEvents();
+			if( n == 0 )
+				std::this_thread::yield();
+			nb += n;
+		}
+		for( auto& th: v_thread )
+			th.join();
+		nb += fsm.processPushedEvents();
+
+		std::cout << "processed=" << nb << ", callbacks=" << nbCallbacks << ", state=" << fsm.currentState() << '\n';
+	}
+}
@@ -0,0 +1,66 @@
+/**
+\file testA_14.cpp
+\brief checks that two FSM using inner events and pass states can run in the same process, on the same external event loop
+(the deferred processing is posted in the event loop of each FSM, no OS signal is involved)
+*/
+
+#define SPAG_USE_ASIO_WRAPPER
+#define SPAG_EXTERNAL_EVENT_LOOP
+#define SPAG_USE_SIGNALS
+#include "spaghetti.hpp"
+
+enum States { st0, st1, st2, st3, NB_STATES };
+enum Events { ev0, iev, NB_EVENTS };
+
+SPAG_DECLARE_FSM_TYPE_ASIO( fsm_t, States, Events, int );
+
+fsm_t fsm_A;      ///< timeouts and a chain of two pass states
+fsm_t fsm_B;      ///< timeouts and an inner event
+
+std::string g_trace_A;
+std::string g_trace_B;   // traces are printed at the end, so that the output does not depend on how the two FSM interleave
+int g_count_A = 0;
+int g_count_B = 0;
+
+//-----------------------------------------------------------------------------------
+void cb_A( int s )
+{
+	g_trace_A += std::to_string( s ) + ' ';
+	if( ++g_count_A == 13 )     // 3 cycles: stops the event loop, so B must have finished before
+		fsm_A.stop();
+}
+
+void cb_B( int s )
+{
+	g_trace_B += std::to_string( s ) + ' ';
+	if( ++g_count_B == 3 )
+		fsm_B.activateInnerEvent( iev );
+}
+
+//-----------------------------------------------------------------------------------
+int main()
+{
+	boost::asio::io_context io;
+	spag::AsioEL asio_A( io );
+	spag::AsioEL asio_B( io );
+	fsm_A.assignEventHandler( &asio_A );
+	fsm_B.assignEventHandler( &asio_B );
+
+	fsm_A.assignCallbackAutoval( cb_A );
+	fsm_A.assignTimeOut( st0, 100, "ms", st1 );
+	fsm_A.assignAAT( st1, st2 );
+	fsm_A.assignAAT( st2, st3 );
+	fsm_A.assignTimeOut( st3, 50, "ms", st0 );
+
+	fsm_B.assignCallbackAutoval( cb_B );
+	fsm_B.assignTimeOut( st0, 30, "ms", st1 );
+	fsm_B.assignTimeOut( st1, 30, "ms", st0 );
+	fsm_B.assignInnerTransition( st0, iev, st2 );   // st2 has no timeout: B stays there
+
+	fsm_A.start();      // not blocking, because of SPAG_EXTERNAL_EVENT_LOOP
+	fsm_B.start();
+	io.run();
+
+	std::cout << "A: " << g_trace_A << "\nB: " << g_trace_B << '\n';
+	std::cout << "A state=" << fsm_A.currentState() << ", B state=" << fsm_B.currentState() << '\n';
+}
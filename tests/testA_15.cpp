@@ -0,0 +1,98 @@
+/**
+\file testA_15.cpp
+\brief checks inner events and pass states without signals nor Boost: with the default timer (NoTimer) or with a timer class
+that has neither \c postInnerEvent() nor \c raiseSignal(), the FSM processes them itself, once the transition has completed
+*/
+
+#include "spaghetti.hpp"
+#include "test_common.hpp"
+
+enum States { st0, st1, st2, st3, st4, NB_STATES };
+enum Events { ev0, ev1, iev, NB_EVENTS };
+
+struct Traits : spag::FsmTraits
+{
+	static constexpr bool innerEvents = true;     // SPAG_USE_SIGNALS is not defined
+};
+
+struct NoQueueTraits : Traits
+{
+	static constexpr size_t postQueueSize = 0;
+};
+
+/// User timer class, without postInnerEvent() nor raiseSignal()
+template<typename ST, typename EV, typename CBA>
+using UserTimer = test::NoSignalTimer<ST,EV,CBA>;
+
+using fsm_t   = spag::SpagFSM<States,Events,spag::priv::NoTimer<States,Events,int>,int,Traits>;
+using utimer_t = UserTimer<States,Events,int>;
+template<typename TRAITS>
+using ufsm_t  = spag::SpagFSM<States,Events,utimer_t,int,TRAITS>;
+
+int g_depth    = 0;   ///< number of callbacks currently running
+int g_maxDepth = 0;
+
+/// Counts the nested callbacks, during its lifetime
+struct DepthCounter
+{
+	DepthCounter()  { g_maxDepth = std::max( g_maxDepth, ++g_depth ); }
+	~DepthCounter() { g_depth--; }
+};
+
+//-----------------------------------------------------------------------------------
+/// All the states are pass states, on a ring. Once started, the FSM hops until the callback stops it
+template<typename FSM>
+void
+runRing( FSM& fsm, int nbHops )
+{
+	for( int s=0; s<NB_STATES; s++ )
+		fsm.assignAAT( static_cast<States>(s), static_cast<States>( (s+1) % NB_STATES ) );
+	int count = 0;
+	g_maxDepth = 0;
+	fsm.assignCallback( [&]( int )                                 // lambda
+	{
+		DepthCounter dc;
+		if( ++count == nbHops )
+			fsm.stop();
+	} );
+	fsm.start();
+	std::cout << "hops=" << count << ", max depth=" << g_maxDepth << ", state=" << fsm.currentState() << '\n';
+}
+
+//-----------------------------------------------------------------------------------
+int main()
+{
+	{
+		std::cout << "\n*** NoTimer, pass states and inner event\n";
+		fsm_t fsm;
+		fsm.assignTransition( st0, ev0, st1 );
+		fsm.assignAAT( st1, st2 );
+		fsm.assignAAT( st2, st3 );
+		fsm.assignInnerTransition( st3, iev, st4 );
+		fsm.assignTransition( st4, ev1, st0 );
+		fsm.assignCallbackAutoval( [&fsm]( int s )                     // lambda
+		{
+			DepthCounter dc;
+			std::cout << " enter S" << s << ", depth=" << g_depth << '\n';
+			if( s == st3 )
+				fsm.activateInnerEvent( iev );
+		} );
+		fsm.start();
+		fsm.processEvent( ev0 );
+		std::cout << "state=" << fsm.currentState() << ", max depth=" << g_maxDepth << '\n';
+		fsm.processEvent( ev1 );
+		std::cout << "state=" << fsm.currentState() << '\n';
+	}
+	{
+		std::cout << "\n*** NoTimer, 100000 hops\n";
+		fsm_t fsm;
+		runRing( fsm, 100000 );
+	}
+	{
+		std::cout << "\n*** user timer, no post queue, 100000 hops\n";
+		utimer_t timer;
+		ufsm_t<NoQueueTraits> fsm;
+		fsm.assignEventHandler( &timer );
+		runRing( fsm, 100000 );
+	}
+}
@@ -0,0 +1,95 @@
+/**
+\file testA_16.cpp
+\brief checks FsmTraits::collapseAAT: once finalized, the chains of pass states are crossed right away,
+without deferred processing by the event handler, and the callbacks of the pass states are called in a loop
+*/
+
+#include "spaghetti.hpp"
+#include "test_common.hpp"
+
+enum States { st0, st1, st2, st3, st4, st5, NB_STATES };
+enum Events { ev0, ev1, NB_EVENTS };
+
+using test::PostTimer;
+
+struct Traits : spag::FsmTraits
+{
+	static constexpr bool innerEvents = true;
+};
+
+struct CollapseTraits : Traits
+{
+	static constexpr bool collapseAAT = true;
+};
+
+using ptimer_t = PostTimer<States,Events,int>;
+template<typename TRAITS>
+using fsm_t = spag::SpagFSM<States,Events,ptimer_t,int,TRAITS>;
+
+//-----------------------------------------------------------------------------------
+/// st0 -> st1 -> st2 -> st3 -> st4 -> st5, with AAT from st1 to st4. Only st3 (a pass state) and st5 have a callback
+template<typename FSM>
+void
+configure( FSM& fsm, ptimer_t& timer )
+{
+	fsm.assignEventHandler( &timer );
+	fsm.assignTransition( st0, ev0, st1 );
+	fsm.assignAAT( st1, st2 );
+	fsm.assignAAT( st2, st3 );
+	fsm.assignAAT( st3, st4 );
+	fsm.assignTransition( st4, ev0, st5 );
+	fsm.assignTransition( st5, ev1, st0 );
+	fsm.assignTransition( st4, ev1, st0 );
+	fsm.assignCallback( st3, []( int ){ std::cout << " callback S3\n"; } );   // lambda
+	fsm.assignCallback( st5, []( int ){ std::cout << " callback S5\n"; } );   // lambda
+}
+
+template<typename FSM>
+void
+run( FSM& fsm, ptimer_t& timer )
+{
+	fsm.start();
+	fsm.processEvent( ev0 );
+	std::cout << "state=" << fsm.currentState() << ", previous=" << fsm.previousState() << ", deferred=" << timer._nbPost << '\n';
+}
+
+//-----------------------------------------------------------------------------------
+int main()
+{
+	{
+		std::cout << "\n*** default, finalized: hops are deferred\n";
+		ptimer_t timer;
+		fsm_t<Traits> fsm;
+		configure( fsm, timer );
+		fsm.finalize();
+		run( fsm, timer );
+	}
+	{
+		std::cout << "\n*** collapsed, not finalized: hops are deferred\n";
+		ptimer_t timer;
+		fsm_t<CollapseTraits> fsm;
+		configure( fsm, timer );
+		run( fsm, timer );
+	}
+	{
+		std::cout << "\n*** collapsed, finalized\n";
+		ptimer_t timer;
+		fsm_t<CollapseTraits> fsm;
+		configure( fsm, timer );
+		fsm.finalize();
+		run( fsm, timer );
+		fsm.processEvent( ev0 );
+		fsm.processEvent( ev1 );
+		std::cout << "state=" << fsm.currentState() << ", deferred=" << timer._nbPost << '\n';
+	}
+	{
+		std::cout << "\n*** collapsed, initial state is a pass state\n";
+		ptimer_t timer;
+		fsm_t<CollapseTraits> fsm;
+		configure( fsm, timer );
+		fsm.assignAAT( st0, st1 );
+		fsm.finalize();
+		fsm.start();
+		std::cout << "state=" << fsm.currentState() << ", previous=" << fsm.previousState() << ", deferred=" << timer._nbPost << '\n';
+	}
+}
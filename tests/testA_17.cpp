@@ -0,0 +1,78 @@
+/**
+\file testA_17.cpp
+\brief checks inner transitions when several inner events are assigned on the same states:
+which one is processed, the ones that stay active, and disableInnerTransition()
+*/
+
+#include "spaghetti.hpp"
+
+enum States { st0, st1, st2, st3, NB_STATES };
+enum Events { ev0, iev1, iev2, iev3, NB_EVENTS };
+
+struct Traits : spag::FsmTraits
+{
+	static constexpr bool innerEvents = true;
+};
+
+using fsm_t = spag::SpagFSM<States,Events,spag::priv::NoTimer<States,Events,int>,int,Traits>;
+
+//-----------------------------------------------------------------------------------
+void
+configure( fsm_t& fsm )
+{
+	fsm.assignTransition( st0, ev0, st1 );
+	fsm.assignTransition( st1, ev0, st0 );
+	fsm.assignTransition( st2, ev0, st0 );
+	fsm.assignTransition( st3, ev0, st0 );
+	fsm.assignInnerTransition( st1, iev3, st3 );   // assigned first, but highest index
+	fsm.assignInnerTransition( st1, iev2, st2 );
+	fsm.assignInnerTransition( iev1, st0 );        // on all states but st0
+	fsm.disableInnerTransition( iev1, st3 );
+	fsm.assignCallbackAutoval( []( int s ){ std::cout << " enter S" << s << '\n'; } );   // lambda
+}
+
+//-----------------------------------------------------------------------------------
+int main()
+{
+	for( bool finalized: { false, true } )
+	{
+		std::cout << "\n*** finalized=" << finalized << '\n';
+		fsm_t fsm;
+		configure( fsm );
+		if( finalized )
+			fsm.finalize();
+		fsm.start();
+
+		std::cout << "- activate iev2 and iev3\n";
+		fsm.activateInnerEvent( iev3 );
+		fsm.activateInnerEvent( iev2 );
+		fsm.processEvent( ev0 );                       // st1, then st2 with iev2, iev3 stays active
+		std::cout << "state=" << fsm.currentState() << '\n';
+
+		std::cout << "- back to st1: iev3 is still active\n";
+		fsm.processEvent( ev0 );
+		fsm.processEvent( ev0 );
+		std::cout << "state=" << fsm.currentState() << '\n';
+
+		std::cout << "- iev1 is disabled on st3\n";
+		fsm.activateInnerEvent( iev1 );
+		std::cout << "state=" << fsm.currentState() << '\n';
+		fsm.processEvent( ev0 );                       // st0: iev1 has no transition there either
+		std::cout << "state=" << fsm.currentState() << '\n';
+		fsm.processEvent( ev0 );                       // st1: iev1 leads back to st0
+		std::cout << "state=" << fsm.currentState() << '\n';
+	}
+	{
+		std::cout << "\n*** disabling a transition that does not exist\n";
+		fsm_t fsm;
+		configure( fsm );
+		try
+		{
+			fsm.disableInnerTransition( iev2, st0 );
+		}
+		catch( const std::logic_error& )
+		{
+			std::cout << "disableInnerTransition(): error caught\n";
+		}
+	}
+}
@@ -0,0 +1,104 @@
+/**
+\file testA_18.cpp
+\brief checks activateInnerEvent(): if the current state has the inner transition, it is processed right away,
+and several threads can activate inner events while the event loop runs (AsioWrapper)
+*/
+
+#define SPAG_USE_ASIO_WRAPPER
+#define SPAG_EXTERNAL_EVENT_LOOP
+#define SPAG_USE_SIGNALS
+#include "spaghetti.hpp"
+
+enum States { st0, st1, st2, st3, st4, NB_STATES };
+enum Events { ev0, iev0, iev1, iev2, iev3, NB_EVENTS };
+
+constexpr int nbThreads     = 4;
+constexpr int nbActivations = 10000;  ///< per thread
+
+SPAG_DECLARE_FSM_TYPE_ASIO( fsm_t, States, Events, int );
+
+using nfsm_t = spag::SpagFSM<States,Events,spag::priv::NoTimer<States,Events,int>>;
+
+fsm_t fsm;
+
+std::atomic<int> g_count[nbThreads];   ///< inner transitions processed, for each producer thread
+int g_payload[nbThreads];              ///< written by each producer before activating, read by the callback (not atomic)
+int g_nbMismatch = 0;
+int g_total      = 0;
+
+//-----------------------------------------------------------------------------------
+/// On st1..st4, checks that the payload written by the producer is visible, then tells it that its activation has been consumed
+void cb( int s )
+{
+	if( s == st0 )
+	{
+		if( g_total == nbThreads * nbActivations )
+			fsm.stop();
+		return;
+	}
+	auto t = s - 1;
+	if( g_payload[t] != g_count[t].load( std::memory_order_relaxed ) )
+		g_nbMismatch++;
+	g_total++;
+	g_count[t].store( g_count[t] + 1, std::memory_order_release );
+}
+
+//-----------------------------------------------------------------------------------
+int main()
+{
+	{
+		std::cout << "\n*** no event loop (NoTimer)\n";
+		nfsm_t nfsm;
+		nfsm.assignTransition( st0, ev0, st2 );
+		nfsm.assignInnerTransition( st0, iev0, st1 );
+		nfsm.assignInnerTransition( st2, iev1, st3 );
+		nfsm.assignTransition( st1, ev0, st0 );
+		nfsm.assignTransition( st3, ev0, st4 );
+		nfsm.assignTransition( st4, ev0, st0 );
+		nfsm.assignCallbackAutoval( []( int s ){ std::cout << " callback: state=" << s << '\n'; } );   // lambda
+		nfsm.start();
+		std::cout << "activate iev0 on st0\n";
+		nfsm.activateInnerEvent( iev0 );                   // st0 has this inner transition: processed right away
+		std::cout << "state=" << nfsm.currentState() << '\n';
+		nfsm.processEvent( ev0 );
+		std::cout << "activate iev1 on st0\n";
+		nfsm.activateInnerEvent( iev1 );                   // not for st0: stays active
+		std::cout << "state=" << nfsm.currentState() << '\n';
+		nfsm.processEvent( ev0 );                          // st2 has it: processed once the transition has completed
+		std::cout << "state=" << nfsm.currentState() << '\n';
+	}
+	{
+		std::cout << "\n*** " << nbThreads << " threads activating inner events, AsioWrapper\n";
+		boost::asio::io_context io;
+		auto work = boost::asio::make_work_guard( io );   // io.run() waits for the activations, until stop()
+		spag::AsioEL asio( io );
+		fsm.assignEventHandler( &asio );
+		for( int t=0; t<nbThreads; t++ )
+		{
+			fsm.assignInnerTransition( st0, static_cast<Events>(iev0+t), static_cast<States>(st1+t) );
+			fsm.assignAAT( static_cast<States>(st1+t), st0 );
+		}
+		fsm.assignCallbackAutoval( cb );
+		fsm.start();                   // not blocking, because of SPAG_EXTERNAL_EVENT_LOOP
+
+		std::vector<std::thread> v_thread;
+		for( int t=0; t<nbThreads; t++ )
+			v_thread.emplace_back( [t]()                                                  // lambda
+			{
+				for( int i=0; i<nbActivations; i++ )
+				{
+					g_payload[t] = i;
+					fsm.activateInnerEvent( static_cast<Events>(iev0+t) );
+					while( g_count[t].load( std::memory_order_acquire ) == i )   // wait until it has been consumed
+						std::this_thread::yield();
+				}
+			} );
+		io.run();                      // this thread runs the event loop, until the callback stops the FSM
+		for( auto& th: v_thread )
+			th.join();
+
+		for( int t=0; t<nbThreads; t++ )
+			std::cout << "thread " << t << ": transitions=" << g_count[t] << '\n';
+		std::cout << "total=" << g_total << ", payload mismatches=" << g_nbMismatch << ", state=" << fsm.currentState() << '\n';
+	}
+}
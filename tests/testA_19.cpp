@@ -0,0 +1,89 @@
+/**
+\file testA_19.cpp
+\brief checks the timing wheel: WheelTimer objects of several FSM sharing a TimingWheel, that is driven tick by tick
+(short timeouts, timeouts spread over the upper levels, cancellation, many FSM instances)
+*/
+
+#include "spaghetti.hpp"
+
+#include <deque>
+
+enum States { st_BlinkOn, st_BlinkOff, st_Wait, st_Long, NB_STATES };
+enum Events { ev_Stop, ev_Start, NB_EVENTS };
+
+using wtimer_t = spag::WheelTimer<States,Events,int>;
+using fsm_t    = spag::SpagFSM<States,Events,wtimer_t>;
+using inst_t   = spag::FsmInstance<fsm_t>;
+
+//-----------------------------------------------------------------------------------
+void
+configure( fsm_t& fsm )
+{
+	fsm.assignTimeOut( st_BlinkOn,  5, "ms", st_BlinkOff );
+	fsm.assignTimeOut( st_BlinkOff, 3, "ms", st_BlinkOn );
+	fsm.assignTransition( st_BlinkOn,  ev_Stop, st_Wait );
+	fsm.assignTransition( st_BlinkOff, ev_Stop, st_Wait );
+	fsm.assignTransition( st_Wait, ev_Start, st_Long );
+	fsm.assignTimeOut( st_Long, 70, "sec", st_BlinkOn );          // 70000 ticks: stored in level 2
+}
+
+//-----------------------------------------------------------------------------------
+int main()
+{
+	spag::TimingWheel wheel;                                      // 1 ms ticks
+	{
+		std::cout << "\n*** one FSM, tick by tick\n";
+		wtimer_t timer( wheel );
+		fsm_t fsm;
+		fsm.assignEventHandler( &timer );
+		configure( fsm );
+		fsm.assignCallbackAutoval( [&wheel]( int s ){ std::cout << " tick " << wheel.currentTick() << ": state=" << s << '\n'; } );   // lambda
+		fsm.start();                                              // not blocking
+		for( int i=0; i<20; i++ )
+			wheel.tick();
+		fsm.processEvent( ev_Stop );
+		std::cout << "armed=" << wheel.size() << '\n';
+		wheel.tick( 100 );
+
+		fsm.processEvent( ev_Start );
+		std::cout << "armed=" << wheel.size() << '\n';
+		auto nb = wheel.tick( 70000 );
+		std::cout << "after 70000 ticks: timeouts=" << nb << ", state=" << fsm.currentState() << '\n';
+		nb = wheel.tick();
+		std::cout << "after 1 more tick: timeouts=" << nb << ", state=" << fsm.currentState() << '\n';
+		fsm.stop();
+		std::cout << "stopped, armed=" << wheel.size() << '\n';
+	}
+	{
+		std::cout << "\n*** 1000 FSM instances\n";
+		constexpr int nbFsm = 1000;
+		auto p_fsm = std::make_shared<fsm_t>();
+		configure( *p_fsm );
+		int nbOn  = 0;
+		int nbOff = 0;
+		p_fsm->assignCallback( st_BlinkOn,  [&nbOn]( int ){ nbOn++; } );    // lambda
+		p_fsm->assignCallback( st_BlinkOff, [&nbOff]( int ){ nbOff++; } );  // lambda
+		spag::FsmConfig<fsm_t> config( p_fsm );
+
+		std::deque<wtimer_t> v_timer;                              // not movable
+		std::vector<inst_t>  v_fsm( nbFsm, inst_t( config ) );
+		for( auto& fsm: v_fsm )
+		{
+			v_timer.emplace_back( wheel );
+			fsm.assignEventHandler( &v_timer.back() );
+		}
+		for( int i=0; i<nbFsm; i++ )                               // one started per tick, so that they do not expire together
+		{
+			v_fsm[i].start();
+			wheel.tick();
+		}
+		auto nb = wheel.tick( 8000 );
+		std::cout << "timeouts=" << nb << ", armed=" << wheel.size() << '\n';
+		for( int i=0; i<nbFsm; i+=2 )
+			v_fsm[i].processEvent( ev_Stop );
+		std::cout << "half stopped, armed=" << wheel.size() << '\n';
+		nbOn = nbOff = 0;
+		nb = wheel.tick( 8000 );
+		std::cout << "timeouts=" << nb << ", BlinkOn=" << nbOn << ", BlinkOff=" << nbOff << '\n';
+	}
+}
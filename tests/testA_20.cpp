@@ -0,0 +1,70 @@
+/**
+\file testA_20.cpp
+\brief checks the lazy timer cancelation of AsioWrapper (see AsioWrapper::setLazyCancel()): a pending wait is reused when the next
+timeout expires later, replaced when it expires earlier, and ignored when the timeout has been canceled
+*/
+
+#define SPAG_USE_ASIO_WRAPPER
+#define SPAG_EXTERNAL_EVENT_LOOP
+#include "spaghetti.hpp"
+
+enum States { st0, st1, st2, st3, st4, st5, st6, NB_STATES };
+enum Events { ev0, ev1, NB_EVENTS };
+
+SPAG_DECLARE_FSM_TYPE_ASIO( fsm_t, States, Events, int );
+
+fsm_t fsm;
+
+//-----------------------------------------------------------------------------------
+/// Runs \c action at time \c ms, from the start of the event loop
+template<typename F>
+void
+at( boost::asio::io_context& io, int ms, F action )
+{
+	auto p_timer = std::make_shared<boost::asio::steady_timer>( io, std::chrono::milliseconds( ms ) );
+	p_timer->async_wait( [p_timer,action,ms]( const boost::system::error_code& ){ std::cout << ms << " ms: "; action(); } );   // lambda
+}
+
+void checkState()
+{
+	std::cout << "state=" << fsm.currentState() << '\n';
+}
+template<Events EV>
+void sendEvent()
+{
+	std::cout << "event " << EV << '\n';
+	fsm.processEvent( EV );
+}
+
+//-----------------------------------------------------------------------------------
+int main()
+{
+	boost::asio::io_context io;
+	spag::AsioEL asio( io );
+	asio.setLazyCancel( true );
+	fsm.assignEventHandler( &asio );
+
+	fsm.assignTimeOut( st0, 400, "ms", st1 );
+	fsm.assignTimeOut( st2, 600, "ms", st3 );
+	fsm.assignTimeOut( st4, 100, "ms", st5 );
+	fsm.assignTransition( st0, ev0, st2 );
+	fsm.assignTransition( st2, ev0, st4 );
+	fsm.assignTransition( st5, ev0, st0 );
+	fsm.assignTransition( st0, ev1, st6 );
+	fsm.assignTransition( st6, ev0, st0 );
+	fsm.assignTransition( st1, ev0, st0 );
+	fsm.assignTransition( st3, ev0, st0 );
+	fsm.assignCallbackAutoval( []( int s ){ std::cout << " callback: state=" << s << '\n'; } );   // lambda
+
+	at( io, 100,  sendEvent<ev0> );   // st0 -> st2: its timeout (700 ms) expires after the pending wait (400 ms), that is reused
+	at( io, 450,  checkState );       // the wait has expired, and waits again until 700 ms
+	at( io, 500,  sendEvent<ev0> );   // st2 -> st4: its timeout (600 ms) expires before the pending wait, that is replaced
+	at( io, 650,  checkState );
+	at( io, 800,  sendEvent<ev0> );   // st5 -> st0, timeout at 1200 ms
+	at( io, 850,  sendEvent<ev1> );   // st0 -> st6: the timeout is canceled, the pending wait stays
+	at( io, 1300, checkState );       // the wait has expired at 1200 ms, and has been ignored
+	at( io, 1350, [](){ std::cout << "stop\n"; fsm.stop(); } );   // lambda
+
+	fsm.start();                      // not blocking, because of SPAG_EXTERNAL_EVENT_LOOP
+	io.run();
+}
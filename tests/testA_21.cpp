@@ -0,0 +1,66 @@
+/**
+\file testA_21.cpp
+\brief checks the timeout durations stored as \c std::chrono values (see timeOutChrono()), with all the units,
+and sub-millisecond timeouts processed by a timing wheel with 100 us ticks
+*/
+
+#include "spaghetti.hpp"
+
+enum States { st0, st1, st2, st3, NB_STATES };
+enum Events { ev0, NB_EVENTS };
+
+using wtimer_t = spag::WheelTimer<States,Events,int>;
+using fsm_t    = spag::SpagFSM<States,Events,wtimer_t>;
+
+//-----------------------------------------------------------------------------------
+/// Prints the durations of all the states of \c fsm
+template<typename FSM>
+void
+printDurations( const FSM& fsm )
+{
+	for( size_t i=0; i<NB_STATES; i++ )
+	{
+		auto st  = static_cast<States>( i );
+		auto dur = fsm.timeOutDuration( st );
+		std::cout << "S" << i << ": " << dur.first << ' ' << spag::priv::stringFromTimeUnit( dur.second )
+			<< " = " << fsm.timeOutChrono( st ).count() << " ns\n";
+	}
+}
+
+//-----------------------------------------------------------------------------------
+int main()
+{
+	spag::TimingWheel wheel( std::chrono::microseconds(100) );
+	wtimer_t timer( wheel );
+	fsm_t fsm;
+	fsm.assignEventHandler( &timer );
+	fsm.assignTimeOut( st0, 200,  "us",   st1 );
+	fsm.assignTimeOut( st1, 1500, "nsec", st2 );
+	fsm.assignTimeOut( st2, 3,    spag::DurUnit::ms, st3 );
+	fsm.assignTimeOut( st3, 2,    "min",  st0 );
+	fsm.assignTransition( st3, ev0, st0 );
+	fsm.assignCallbackAutoval( [&wheel]( int s ){ std::cout << " tick " << wheel.currentTick() << ": state=" << s << '\n'; } );   // lambda
+
+	std::cout << "\n*** durations\n";
+	printDurations( fsm );
+	fsm.finalize();
+	std::cout << "finalized\n";
+	printDurations( fsm );
+
+	try
+	{
+		fsm_t fsm2;
+		fsm2.assignTimeOut( st0, 1, "ps", st1 );
+	}
+	catch( const std::exception& e )
+	{
+		std::cout << "exception: " << e.what() << '\n';
+	}
+
+	std::cout << "\n*** one tick is 100 us\n";
+	fsm.start();
+	wheel.tick( 40 );             // 200 us: 2 ticks, 1500 ns: rounded up to 1 tick, 3 ms: 30 ticks (each counted from the next tick)
+	fsm.processEvent( ev0 );
+	wheel.tick( 5 );
+	fsm.stop();
+}
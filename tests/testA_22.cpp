@@ -0,0 +1,71 @@
+/**
+\file testA_22.cpp
+\brief checks the drift-free timeouts (see SpagFSM::setDriftFreeTimeOut()) with AsioWrapper: the event loop is blocked
+when a timeout expires, so it is processed late, and the next timeout is measured from its deadline, or from the current time
+*/
+
+#define SPAG_USE_ASIO_WRAPPER
+#define SPAG_EXTERNAL_EVENT_LOOP
+#include "spaghetti.hpp"
+
+#include <thread>
+
+enum States { st0, st1, st2, NB_STATES };
+enum Events { ev0, NB_EVENTS };
+
+SPAG_DECLARE_FSM_TYPE_ASIO( fsm_t, States, Events, int );
+
+using Clock = std::chrono::steady_clock;
+
+//-----------------------------------------------------------------------------------
+/// Runs \c action at time \c ms, from \c t0
+template<typename F>
+void
+at( boost::asio::io_context& io, Clock::time_point t0, int ms, F action )
+{
+	auto p_timer = std::make_shared<boost::asio::steady_timer>( io, t0 + std::chrono::milliseconds( ms ) );
+	p_timer->async_wait( [p_timer,action]( const boost::system::error_code& ){ action(); } );   // lambda
+}
+
+//-----------------------------------------------------------------------------------
+/// Blocks the event loop from 90 ms to \c blockEnd, so that the first timeout (100 ms) is processed late,
+/// and sends \c ev0 at \c evTime, if not 0
+void
+runCase( std::string title, bool driftFree, int blockEnd, int evTime )
+{
+	std::cout << "\n*** " << title << '\n';
+	boost::asio::io_context io;
+	spag::AsioEL asio( io );
+	fsm_t fsm;
+	fsm.assignEventHandler( &asio );
+	fsm.assignTimeOut( st0, 100, "ms", st1 );
+	fsm.assignTimeOut( st1, 100, "ms", st0 );
+	fsm.assignTimeOut( st2, 100, "ms", st0 );
+	fsm.assignTransition( st1, ev0, st2 );
+	fsm.assignTransition( st2, ev0, st0 );
+	fsm.setDriftFreeTimeOuts( driftFree );
+
+	auto t0 = Clock::now();
+	fsm.assignCallbackAutoval( [t0]( int s )                                                      // lambda
+		{
+			auto ms = std::chrono::duration_cast<std::chrono::milliseconds>( Clock::now() - t0 ).count();
+			std::cout << " " << ms / 10 * 10 << " ms: state=" << s << '\n';                   // rounded down to 10 ms, as the timeouts are never early
+		}
+	);
+	at( io, t0, 90, [t0,blockEnd](){ std::this_thread::sleep_until( t0 + std::chrono::milliseconds( blockEnd ) ); } );   // lambda
+	if( evTime )
+		at( io, t0, evTime, [&fsm](){ std::cout << " event\n"; fsm.processEvent( ev0 ); } );   // lambda
+	at( io, t0, 450, [&fsm](){ fsm.stop(); } );                                                // lambda
+
+	fsm.start();                      // not blocking, because of SPAG_EXTERNAL_EVENT_LOOP
+	io.run();
+}
+
+//-----------------------------------------------------------------------------------
+int main()
+{
+	runCase( "default: each timeout is measured from the time the previous one was processed", false, 120, 0 );
+	runCase( "drift-free: each timeout is measured from the deadline of the previous one",     true,  120, 0 );
+	runCase( "drift-free, blocked until 340 ms: the missed timeouts are caught up",           true,  340, 0 );
+	runCase( "drift-free, state entered from an event: measured from the current time",      true,  120, 150 );
+}
@@ -0,0 +1,104 @@
+/**
+\file testA_23.cpp
+\brief checks EpollWrapper, with an external event loop: timeouts (a canceled one is ignored), events read from a pipe
+added with addFd(), a pass state (AAT processed by a posted handler), and an event pushed by another thread
+*/
+
+#define SPAG_USE_EPOLL_WRAPPER
+#define SPAG_EXTERNAL_EVENT_LOOP
+#define SPAG_USE_SIGNALS
+#include "spaghetti.hpp"
+
+enum States { st0, st1, st2, st3, st4, NB_STATES };
+enum Events { ev0, ev1, NB_EVENTS };
+
+struct Traits : spag::FsmTraits
+{
+	static constexpr size_t inputQueueSize = 16;
+};
+
+using epoll_t = spag::EpollWrapper<States,Events,int>;
+using fsm_t   = spag::SpagFSM<States,Events,epoll_t,int,Traits>;
+using Clock   = std::chrono::steady_clock;
+
+fsm_t fsm;
+Clock::time_point t0;
+
+//-----------------------------------------------------------------------------------
+/// Prints the time since \c t0, rounded down to 10 ms (the timeouts are never early)
+void printTime()
+{
+	auto ms = std::chrono::duration_cast<std::chrono::milliseconds>( Clock::now() - t0 ).count();
+	std::cout << ms / 10 * 10 << " ms:";
+}
+
+//-----------------------------------------------------------------------------------
+/// Runs \c action at time \c ms, from \c t0, with a timerfd added to the event loop
+template<typename F>
+void
+at( epoll_t& ep, int ms, F action )
+{
+	int fd = timerfd_create( CLOCK_MONOTONIC, TFD_NONBLOCK );
+	auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>( ( t0 + std::chrono::milliseconds( ms ) ).time_since_epoch() ).count();
+	itimerspec spec{};
+	spec.it_value.tv_sec  = ns / 1000000000;
+	spec.it_value.tv_nsec = ns % 1000000000;
+	timerfd_settime( fd, TFD_TIMER_ABSTIME, &spec, nullptr );
+	ep.addFd( fd, [&ep,fd,action]( uint32_t )          // lambda
+		{
+			ep.removeFd( fd );                         // the handler is kept alive until it returns
+			::close( fd );
+			printTime();
+			action();
+		}
+	);
+}
+
+//-----------------------------------------------------------------------------------
+int main()
+{
+	epoll_t ep;
+	fsm.assignEventHandler( &ep );
+	fsm.assignTimeOut( st0, 100, "ms", st1 );
+	fsm.assignTransition( st1, ev0, st2 );
+	fsm.assignAAT( st2, st3 );
+	fsm.assignTimeOut( st3, 100, "ms", st0 );
+	fsm.assignTransition( st3, ev1, st4 );
+	fsm.assignTransition( st4, ev0, st0 );
+	fsm.assignCallbackAutoval( []( int s ){ printTime(); std::cout << " state=" << s << '\n'; } );   // lambda
+
+	int pipeFd[2];
+	if( pipe( pipeFd ) != 0 )
+		return 1;
+	ep.addFd( pipeFd[0], [&pipeFd]( uint32_t )        // lambda
+		{
+			char c;
+			if( ::read( pipeFd[0], &c, 1 ) == 1 )
+			{
+				printTime();
+				std::cout << " read '" << c << "' from pipe\n";
+				fsm.processEvent( ev0 );
+			}
+		}
+	);
+	auto writePipe = [&pipeFd](){ std::cout << " write pipe\n"; if( ::write( pipeFd[1], "a", 1 ) != 1 ) std::cout << "write error\n"; };   // lambda
+
+	t0 = Clock::now();
+	at( ep, 150, writePipe );                          // st1 -> st2 (pass state) -> st3, timeout at 250 ms
+	at( ep, 400, writePipe );                          // st4 -> st0, timeout at 500 ms
+	at( ep, 550, [](){ std::cout << " stop\n"; fsm.stop(); } );   // lambda
+	std::thread th( []()                               // lambda
+		{
+			std::this_thread::sleep_until( t0 + std::chrono::milliseconds( 200 ) );
+			fsm.pushEvent( ev1 );                      // st3 -> st4: the timeout (250 ms) is canceled
+		}
+	);
+
+	fsm.start();                                       // not blocking, because of SPAG_EXTERNAL_EVENT_LOOP
+	ep.run();
+	th.join();
+	ep.removeFd( pipeFd[0] );
+	::close( pipeFd[0] );
+	::close( pipeFd[1] );
+	std::cout << "state=" << fsm.currentState() << '\n';
+}
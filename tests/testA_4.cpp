@@ -0,0 +1,92 @@
+/**
+\file testA_4.cpp
+\brief checks that all the transition table storage policies behave the same
+*/
+
+#define SPAG_ENUM_STRINGS
+#include "spaghetti.hpp"
+#include "test_common.hpp"
+
+enum States { st0, st1, st2, st3, NB_STATES };
+enum Events { ev0, ev1, ev2, NB_EVENTS };
+
+/// Dummy timer, only prints out the calls, without the durations
+template<typename ST, typename EV, typename CBA>
+using PrintTimer = test::PrintTimer<ST,EV,CBA,test::PrintDuration::None>;
+
+struct PackedTraits : spag::FsmTraits
+{
+	using Table = spag::PackedTable;
+};
+
+struct SplitSMTraits : spag::FsmTraits
+{
+	static constexpr spag::TableLayout layout = spag::TableLayout::StateMajor;
+};
+
+struct PackedSMTraits : PackedTraits
+{
+	static constexpr spag::TableLayout layout = spag::TableLayout::StateMajor;
+};
+
+struct SparseTraits : spag::FsmTraits
+{
+	using Table = spag::SparseTable;
+};
+
+struct WideTraits : spag::FsmTraits
+{
+	static constexpr bool narrowCells = false;
+};
+
+struct PackedWideTraits : PackedTraits
+{
+	static constexpr bool narrowCells = false;
+};
+
+void cb( int s )
+{
+	std::cout << " callback: state=" << s << '\n';
+}
+
+//-----------------------------------------------------------------------------------
+template<typename TRAITS>
+void
+runTest( std::string name )
+{
+	std::cout << "\n*** Table type: " << name << '\n';
+	using fsm_t = spag::SpagFSM<States,Events,PrintTimer<States,Events,int>,int,TRAITS>;
+	PrintTimer<States,Events,int> timer;
+	fsm_t fsm;
+	fsm.assignEventHandler( &timer );
+	fsm.assignCallbackAutoval( cb );
+
+	fsm.assignTransition( st0, ev0, st1 );
+	fsm.assignTransition( st1, ev1, st2 );
+	fsm.assignTransition( st2, ev0, st3 );
+	fsm.assignTransition( ev2, st0 );
+	fsm.assignTimeOut( st1, 100, "ms", st0 );
+	fsm.assignTimeOut( st3, 100, "ms", st1 );
+	fsm.clearTimeOut( st3 );
+	fsm.allowEvent( st3, ev1 );
+
+	fsm.printConfig( std::cout );
+	fsm.start();
+	for( auto ev: { ev0, ev0, ev1, ev1, ev0, ev1, ev2, ev0, ev2 } )
+	{
+		std::cout << "event " << ev << '\n';
+		fsm.processEvent( ev );
+	}
+}
+
+//-----------------------------------------------------------------------------------
+int main()
+{
+	runTest<spag::FsmTraits>( "SplitTable" );
+	runTest<PackedTraits>( "PackedTable" );
+	runTest<SplitSMTraits>( "SplitTable, state-major" );
+	runTest<PackedSMTraits>( "PackedTable, state-major" );
+	runTest<SparseTraits>( "SparseTable" );
+	runTest<WideTraits>( "SplitTable, wide cells" );
+	runTest<PackedWideTraits>( "PackedTable, wide cells" );
+}
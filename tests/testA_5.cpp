@@ -0,0 +1,79 @@
+/**
+\file testA_5.cpp
+\brief checks that DynamicSpagFSM behaves the same as SpagFSM
+*/
+
+#include "spaghetti.hpp"
+#include "test_common.hpp"
+
+enum States { st0, st1, st2, st3, NB_STATES };
+enum Events { ev0, ev1, ev2, NB_EVENTS };
+
+using test::PrintTimer;
+
+void cb( int s )
+{
+	std::cout << " callback: state=" << s << '\n';
+}
+
+void ignored( size_t s, size_t e )
+{
+	std::cout << " ignored event " << e << " on state " << s << '\n';
+}
+
+//-----------------------------------------------------------------------------------
+/// Same configuration for both types. Types \c S and \c E are the enums for SpagFSM, and \c size_t for DynamicSpagFSM
+template<typename S, typename E, typename FSM>
+void
+configure( FSM& fsm )
+{
+	fsm.assignCallbackAutoval( cb );
+	fsm.assignIgnoredEventsCallback( []( S s, E e ){ ignored( s, e ); } );   // lambda
+	fsm.assignTransition( S(st0), E(ev0), S(st1) );
+	fsm.assignTransition( S(st1), E(ev1), S(st2) );
+	fsm.assignTransition( S(st2), E(ev0), S(st3) );
+	fsm.assignTransition( E(ev2), S(st0) );
+	fsm.assignTimeOut( S(st1), 100, "ms", S(st0) );
+	fsm.assignTimeOut( S(st3), 200, "ms", S(st1) );
+	fsm.clearTimeOut( S(st3) );
+	fsm.assignTimeOut( S(st2), 300, "ms", S(st0) );
+	fsm.allowEvent( S(st3), E(ev1) );
+}
+
+//-----------------------------------------------------------------------------------
+template<typename E, typename FSM>
+void
+run( FSM& fsm )
+{
+	fsm.start();
+	for( auto ev: { ev0, ev0, ev1, ev1, ev0, ev1, ev2, ev0, ev2, ev0, ev1 } )
+	{
+		std::cout << "event " << ev << '\n';
+		fsm.processEvent( E(ev) );
+	}
+	std::cout << "timeout\n";
+	fsm.processTimeOut();
+	std::cout << "current state=" << fsm.currentState() << ", previous state=" << fsm.previousState() << '\n';
+}
+
+//-----------------------------------------------------------------------------------
+int main()
+{
+	{
+		std::cout << "\n*** SpagFSM\n";
+		PrintTimer<States,Events,int> timer;
+		spag::SpagFSM<States,Events,PrintTimer<States,Events,int>> fsm;
+		fsm.assignEventHandler( &timer );
+		configure<States,Events>( fsm );
+		run<Events>( fsm );
+	}
+	{
+		std::cout << "\n*** DynamicSpagFSM\n";
+		using timer_t = PrintTimer<size_t,size_t,int>;
+		timer_t timer;
+		spag::DynamicSpagFSM<timer_t> fsm( NB_STATES, NB_EVENTS );
+		fsm.assignEventHandler( &timer );
+		configure<size_t,size_t>( fsm );
+		run<size_t>( fsm );
+	}
+}
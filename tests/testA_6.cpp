@@ -0,0 +1,77 @@
+/**
+\file testA_6.cpp
+\brief checks that processEvents() (batch) behaves the same as processEvent() called for each event
+*/
+
+#include "spaghetti.hpp"
+#include "test_common.hpp"
+
+enum States { st0, st1, st2, st3, NB_STATES };
+enum Events { ev0, ev1, ev2, NB_EVENTS };
+
+using test::PrintTimer;
+
+using fsm_t = spag::SpagFSM<States,Events,PrintTimer<States,Events,int>>;
+
+void cb( int s )
+{
+	std::cout << " callback: state=" << s << '\n';
+}
+
+//-----------------------------------------------------------------------------------
+void
+configure( fsm_t& fsm )
+{
+	fsm.assignCallbackAutoval( cb );
+	fsm.assignIgnoredEventsCallback( []( States s, Events e ){ std::cout << " ignored event " << e << " on state " << s << '\n'; } );   // lambda
+	fsm.assignTransition( st0, ev0, st1 );
+	fsm.assignTransition( st1, ev1, st2 );
+	fsm.assignTransition( st2, ev0, st3 );
+	fsm.assignTransition( ev2, st0 );
+	fsm.assignTimeOut( st1, 100, "ms", st0 );
+	fsm.assignTimeOut( st2, 300, "ms", st0 );
+	fsm.allowEvent( st3, ev1 );
+}
+
+const std::vector<Events> v_ev{ ev0, ev0, ev1, ev1, ev0, ev1, ev2, ev0, ev2, ev0, ev1 };
+
+//-----------------------------------------------------------------------------------
+int main()
+{
+	PrintTimer<States,Events,int> timer;
+	{
+		std::cout << "\n*** processEvent()\n";
+		fsm_t fsm;
+		fsm.assignEventHandler( &timer );
+		configure( fsm );
+		fsm.start();
+		for( auto ev: v_ev )
+		{
+			fsm.processEvent( ev );
+			std::cout << "state=" << fsm.currentState() << '\n';
+		}
+	}
+	{
+		std::cout << "\n*** processEvents()\n";
+		fsm_t fsm;
+		fsm.assignEventHandler( &timer );
+		configure( fsm );
+		fsm.start();
+		std::vector<States> v_trace( v_ev.size() );
+		auto n = fsm.processEvents( v_ev, v_trace.data() );
+		std::cout << "processed " << n << " events, trace:";
+		for( auto st: v_trace )
+			std::cout << ' ' << st;
+		std::cout << '\n';
+	}
+	{
+		std::cout << "\n*** processEvents(), stop on S3\n";
+		fsm_t fsm;
+		fsm.assignEventHandler( &timer );
+		configure( fsm );
+		fsm.assignCallback( st3, [&fsm]( int ){ std::cout << " callback: stop\n"; fsm.stop(); } );   // lambda
+		fsm.start();
+		auto n = fsm.processEvents( v_ev.data(), v_ev.data() + v_ev.size() );
+		std::cout << "processed " << n << " events, state=" << fsm.currentState() << '\n';
+	}
+}
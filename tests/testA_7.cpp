@@ -0,0 +1,144 @@
+/**
+\file testA_7.cpp
+\brief checks that all the callback policies behave the same
+*/
+
+#include "spaghetti.hpp"
+#include "test_common.hpp"
+
+enum States { st0, st1, st2, st3, NB_STATES };
+enum Events { ev0, ev1, ev2, NB_EVENTS };
+
+/// Dummy timer, only prints out the calls, without the durations
+template<typename ST, typename EV, typename CBA>
+using PrintTimer = test::PrintTimer<ST,EV,CBA,test::PrintDuration::None>;
+
+void cb( int s )
+{
+	std::cout << " callback: value=" << s << '\n';
+}
+
+void cbCtx( void* ctx, int s )
+{
+	std::cout << " callback: value=" << s << ", context=" << *static_cast<std::string*>(ctx) << '\n';
+}
+
+/// Handler for HandlerCallback policy
+struct Handler
+{
+	std::string _name;
+	void operator()( States st, const int& s ) const
+	{
+		std::cout << " callback: state=" << st << ", value=" << s << ", handler=" << _name << '\n';
+	}
+};
+
+struct FnPtrTraits : spag::FsmTraits
+{
+	using Callback = spag::FnPtrCallback;
+};
+
+struct FunctionRefTraits : spag::FsmTraits
+{
+	using Callback = spag::FunctionRefCallback;
+};
+
+struct HandlerTraits : spag::FsmTraits
+{
+	using Callback = spag::HandlerCallback<Handler>;
+};
+
+struct ByRefTraits : spag::FsmTraits
+{
+	static constexpr bool callbackArgByRef = true;
+};
+
+/// Callback argument type that counts its copies
+struct Payload
+{
+	static int s_nbCopies;
+	std::string _value;
+
+	Payload() = default;
+	Payload( std::string v ) : _value( v ) {}
+	Payload( const Payload& p ) : _value( p._value ) { s_nbCopies++; }
+	Payload( Payload&& ) = default;
+	Payload& operator = ( const Payload& p ) { _value = p._value; s_nbCopies++; return *this; }
+	Payload& operator = ( Payload&& ) = default;
+	friend std::ostream& operator << ( std::ostream& s, const Payload& p ) { return s << p._value; }
+};
+int Payload::s_nbCopies = 0;
+
+//-----------------------------------------------------------------------------------
+template<typename CBA=int, typename FSM>
+void
+run( FSM& fsm )
+{
+	PrintTimer<States,Events,CBA> timer;
+	fsm.assignEventHandler( &timer );
+	fsm.assignTransition( st0, ev0, st1 );
+	fsm.assignTransition( st1, ev1, st2 );
+	fsm.assignTransition( st2, ev0, st3 );
+	fsm.assignTransition( ev2, st0 );
+	fsm.assignTimeOut( st1, 100, "ms", st0 );
+
+	fsm.start();
+	for( auto ev: { ev0, ev0, ev1, ev1, ev0, ev1, ev2, ev0, ev2 } )
+	{
+		std::cout << "event " << ev << '\n';
+		fsm.processEvent( ev );
+	}
+}
+
+//-----------------------------------------------------------------------------------
+int main()
+{
+	{
+		std::cout << "\n*** StdFunctionCallback\n";
+		spag::SpagFSM<States,Events,PrintTimer<States,Events,int>> fsm;
+		fsm.assignCallbackAutoval( cb );
+		fsm.assignCallback( st3, [](int v){ cb( v*10 ); }, 3 );   // lambda
+		run( fsm );
+	}
+	{
+		std::cout << "\n*** FnPtrCallback\n";
+		std::string ctx( "ctx" );
+		spag::SpagFSM<States,Events,PrintTimer<States,Events,int>,int,FnPtrTraits> fsm;
+		fsm.assignCallbackAutoval( { cbCtx, &ctx } );
+		fsm.assignCallback( st3, { cbCtx, &ctx }, 30 );
+		run( fsm );
+	}
+	{
+		std::cout << "\n*** FunctionRefCallback\n";
+		int factor = 10;
+		auto lambda = [&factor](int v){ cb( v*factor ); };
+		spag::SpagFSM<States,Events,PrintTimer<States,Events,int>,int,FunctionRefTraits> fsm;
+		fsm.assignCallbackAutoval( cb );
+		fsm.assignCallback( st3, lambda, 3 );
+		run( fsm );
+	}
+	{
+		std::cout << "\n*** HandlerCallback\n";
+		Handler handler{ "H1" };
+		spag::SpagFSM<States,Events,PrintTimer<States,Events,int>,int,HandlerTraits> fsm;
+		fsm.assignCallbackHandler( &handler );
+		for( int i=0; i<NB_STATES; i++ )
+			fsm.assignCallbackValue( static_cast<States>(i), i );
+		fsm.assignCallbackValue( st3, 30 );
+		run( fsm );
+	}
+	{
+		std::cout << "\n*** StdFunctionCallback, argument by reference\n";
+		spag::SpagFSM<States,Events,PrintTimer<States,Events,Payload>,Payload,ByRefTraits> fsm;
+		fsm.assignCallback( []( const Payload& p ){ std::cout << " callback: value=" << p << '\n'; } );   // lambda
+		for( int i=0; i<NB_STATES; i++ )
+		{
+			Payload p( "payload_" + std::to_string( i ) );
+			fsm.assignCallbackValue( static_cast<States>(i), std::move( p ) );
+		}
+		std::cout << "value on S3=" << fsm.callbackValue( st3 ) << '\n';
+		Payload::s_nbCopies = 0;
+		run<Payload>( fsm );
+		std::cout << "nb of copies=" << Payload::s_nbCopies << '\n';
+	}
+}
@@ -0,0 +1,81 @@
+/**
+\file testA_8.cpp
+\brief checks that FsmInstance objects sharing a FsmConfig behave as SpagFSM, and independently of each other
+*/
+
+#include "spaghetti.hpp"
+#include "test_common.hpp"
+
+enum States { st0, st1, st2, st3, NB_STATES };
+enum Events { ev0, ev1, ev2, NB_EVENTS };
+
+using test::PrintTimer;
+
+using ptimer_t = PrintTimer<States,Events,int>;
+using fsm_t   = spag::SpagFSM<States,Events,ptimer_t>;
+
+void cb( int s )
+{
+	std::cout << " callback: state=" << s << '\n';
+}
+
+//-----------------------------------------------------------------------------------
+void
+configure( fsm_t& fsm )
+{
+	fsm.assignCallbackAutoval( cb );
+	fsm.assignTransition( st0, ev0, st1 );
+	fsm.assignTransition( st1, ev1, st2 );
+	fsm.assignTransition( st2, ev0, st3 );
+	fsm.assignTransition( ev2, st0 );
+	fsm.assignTimeOut( st1, 100, "ms", st0 );
+	fsm.assignTimeOut( st2, 300, "ms", st0 );
+	fsm.allowEvent( st3, ev1 );
+}
+
+const std::vector<Events> v_ev{ ev0, ev0, ev1, ev1, ev0, ev1, ev2, ev0 };
+
+//-----------------------------------------------------------------------------------
+int main()
+{
+	{
+		std::cout << "\n*** SpagFSM\n";
+		ptimer_t timer{ "T" };
+		fsm_t fsm;
+		fsm.assignEventHandler( &timer );
+		configure( fsm );
+		fsm.start();
+		for( auto ev: v_ev )
+			fsm.processEvent( ev );
+		fsm.processTimeOut();
+		std::cout << "state=" << fsm.currentState() << ", previous=" << fsm.previousState() << '\n';
+	}
+	{
+		std::cout << "\n*** FsmInstance\n";
+		auto p_fsm = std::make_shared<fsm_t>();
+		configure( *p_fsm );
+		spag::FsmConfig<fsm_t> config( p_fsm );
+
+		ptimer_t timer1{ "T1" };
+		ptimer_t timer2{ "T2" };
+		spag::FsmInstance<fsm_t> inst1( config );
+		spag::FsmInstance<fsm_t> inst2( config );
+		inst1.assignEventHandler( &timer1 );
+		inst2.assignEventHandler( &timer2 );
+
+		inst1.start();
+		for( auto ev: v_ev )
+			inst1.processEvent( ev );
+		inst1.processTimeOut();
+		std::cout << "inst1: state=" << inst1.currentState() << ", previous=" << inst1.previousState() << '\n';
+
+		std::cout << "inst2: running=" << inst2.isRunning() << '\n';
+		inst2.start();
+		inst2.processEvent( ev0 );
+		std::cout << "inst2: state=" << inst2.currentState() << ", inst1: state=" << inst1.currentState() << '\n';
+		inst2.processTimeOut();
+		inst1.processEvent( ev0 );
+		std::cout << "inst2: state=" << inst2.currentState() << ", inst1: state=" << inst1.currentState() << '\n';
+		std::cout << "sizeof(FsmInstance)<=64: " << ( sizeof(inst1) <= 64 ) << '\n';
+	}
+}
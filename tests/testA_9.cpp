@@ -0,0 +1,134 @@
+/**
+\file testA_9.cpp
+\brief checks that a finalized FSM behaves as a non-finalized one, and that its configuration can not be changed anymore
+*/
+
+#define SPAG_USE_SIGNALS
+#include "spaghetti.hpp"
+#include "test_common.hpp"
+
+enum States { st0, st1, st2, st3, st4, NB_STATES };
+enum Events { ev0, ev1, iev, NB_EVENTS };
+
+/// Dummy timer, only prints out the calls. The signal is handled by the test loop
+template<typename ST, typename EV, typename CBA>
+using PrintTimer = test::PrintTimer<ST,EV,CBA,test::PrintDuration::Ms>;
+
+using ptimer_t = PrintTimer<States,Events,int>;
+using fsm_t    = spag::SpagFSM<States,Events,ptimer_t>;
+
+void cb( int s )
+{
+	std::cout << " callback: state=" << s << '\n';
+}
+
+//-----------------------------------------------------------------------------------
+void
+configure( fsm_t& fsm )
+{
+	fsm.assignCallbackAutoval( cb );
+	fsm.assignTransition( st0, ev0, st1 );
+	fsm.assignTransition( st1, ev1, st2 );
+	fsm.assignTransition( st2, ev0, st0 );
+	fsm.assignInnerTransition( st2, iev, st3 );
+	fsm.assignAAT( st3, st4 );
+	fsm.assignTransition( st4, ev0, st0 );
+	fsm.assignTimeOut( st1, 2, "sec", st0 );
+	fsm.assignTimeOut( st4, 150, "ms", st0 );
+}
+
+//-----------------------------------------------------------------------------------
+/// Processes the inner events, as the signal handler of the event loop would do
+void
+processSignals( fsm_t& fsm, ptimer_t& timer )
+{
+	while( timer._signal )
+	{
+		timer._signal = false;
+		fsm.processInnerEvent( fsm.getStateInfo( fsm.currentState() ) );
+	}
+}
+
+//-----------------------------------------------------------------------------------
+void
+run( fsm_t& fsm, ptimer_t& timer )
+{
+	fsm.start();
+	fsm.processEvent( ev0 );
+	fsm.activateInnerEvent( iev );
+	fsm.processEvent( ev1 );
+	processSignals( fsm, timer );
+	std::cout << "state=" << fsm.currentState() << '\n';
+	try
+	{
+		fsm.processEvent( iev );
+	}
+	catch( const std::runtime_error& )
+	{
+		std::cout << "processing inner event: error caught\n";
+	}
+	fsm.processEvent( ev1 );   // ignored
+	fsm.processEvent( ev0 );
+	std::cout << "state=" << fsm.currentState() << '\n';
+}
+
+//-----------------------------------------------------------------------------------
+int main()
+{
+	{
+		std::cout << "\n*** not finalized\n";
+		ptimer_t timer;
+		fsm_t fsm;
+		fsm.assignEventHandler( &timer );
+		configure( fsm );
+		run( fsm, timer );
+	}
+	{
+		std::cout << "\n*** finalized\n";
+		ptimer_t timer;
+		fsm_t fsm;
+		fsm.assignEventHandler( &timer );
+		configure( fsm );
+		fsm.finalize();
+		fsm.finalize();   // does nothing
+		std::cout << "isFinalized=" << fsm.isFinalized() << '\n';
+		run( fsm, timer );
+	}
+	{
+		std::cout << "\n*** configuration after finalize\n";
+		fsm_t fsm;
+		configure( fsm );
+		fsm.finalize();
+		try
+		{
+			fsm.assignTransition( st0, ev1, st2 );
+		}
+		catch( const std::logic_error& )
+		{
+			std::cout << "assignTransition(): error caught\n";
+		}
+		try
+		{
+			fsm.assignTimeOut( st2, 100, "ms", st0 );
+		}
+		catch( const std::logic_error& )
+		{
+			std::cout << "assignTimeOut(): error caught\n";
+		}
+	}
+	{
+		std::cout << "\n*** cycle of pass-states\n";
+		fsm_t fsm;
+		configure( fsm );
+		fsm.assignAAT( st4, st3 );
+		try
+		{
+			fsm.finalize();
+		}
+		catch( const std::logic_error& )
+		{
+			std::cout << "finalize(): error caught\n";
+		}
+		std::cout << "isFinalized=" << fsm.isFinalized() << '\n';
+	}
+}
@@ -0,0 +1,114 @@
+/**
+\file test_common.hpp
+\brief holds the dummy timer classes shared by the test programs
+
+None of them runs an event loop: the tests call the member functions of the FSM (processEvent(), processTimeOut(), ...) themselves.
+
+This file is part of Spaghetti, a C++ library for implementing Finite State Machines
+
+Homepage: https://github.com/skramm/spaghetti
+*/
+
+#ifndef HG_SPAG_TEST_COMMON_HPP
+#define HG_SPAG_TEST_COMMON_HPP
+
+#include <chrono>
+#include <string>
+#include <atomic>
+#include <iostream>
+
+namespace test {
+
+//-----------------------------------------------------------------------------------
+/// Dummy timer class, does nothing.
+/**
+It has no \c raiseSignal() member function, so the FSM processes the inner events and AAT itself (see SpagFSM::drainInnerEvents()).
+*/
+template<typename ST, typename EV, typename CBA>
+struct NoSignalTimer
+{
+	template<typename FSM>
+	void timerStart( const FSM* ) {}
+	template<typename FSM>
+	void init( const FSM* ) {}
+	void timerCancel() {}
+	void kill() {}
+};
+
+/// Dummy timer class, does nothing, and has a \c raiseSignal() member function that does nothing either
+template<typename ST, typename EV, typename CBA>
+struct DummyTimer : NoSignalTimer<ST,EV,CBA>
+{
+	void raiseSignal() {}
+};
+
+/// Dummy timer class, counts the calls to wakeUp() (see SpagFSM::pushEvent()). Can be called from any thread
+template<typename ST, typename EV, typename CBA>
+struct WakeTimer : DummyTimer<ST,EV,CBA>
+{
+	std::atomic<int> _nbWakeUp{0};
+
+	template<typename FSM>
+	void wakeUp( const FSM* ) { _nbWakeUp++; }
+};
+
+/// Dummy timer class, counts the calls to postInnerEvent(): the inner events and AAT are deferred, the test processes them
+template<typename ST, typename EV, typename CBA>
+struct PostTimer : NoSignalTimer<ST,EV,CBA>
+{
+	int _nbPost = 0;
+
+	template<typename FSM>
+	void postInnerEvent( const FSM* ) { _nbPost++; }
+};
+
+//-----------------------------------------------------------------------------------
+/// How PrintTimer prints the duration of the timeouts it starts
+enum class PrintDuration
+{
+	None,     ///< not printed
+	Value,    ///< the value it was assigned with, in its unit (see SpagFSM::timeOutDuration())
+	Ms,       ///< in ms
+	ValueMs   ///< both
+};
+
+/// Dummy timer class, only prints out the calls
+template<typename ST, typename EV, typename CBA, PrintDuration PD=PrintDuration::Value>
+struct PrintTimer
+{
+	std::string _name;           ///< printed before each call, if not empty
+	bool        _signal = false; ///< set by raiseSignal()
+
+	template<typename FSM>
+	void timerStart( const FSM* fsm )
+	{
+		std::cout << ' ' << prefix() << "timer start on S" << fsm->currentState();
+		if constexpr( PD == PrintDuration::Value )
+			std::cout << ", duration=" << fsm->timeOutDuration( fsm->currentState() ).first;
+		if constexpr( PD == PrintDuration::Ms )
+			std::cout << ", duration=" << durationMs( fsm ) << " ms";
+		if constexpr( PD == PrintDuration::ValueMs )
+			std::cout << ", duration=" << fsm->timeOutDuration( fsm->currentState() ).first << " (" << durationMs( fsm ) << " ms)";
+		std::cout << '\n';
+	}
+	template<typename FSM>
+	void init( const FSM* ) {}
+	void timerCancel() { std::cout << ' ' << prefix() << "timer cancel\n"; }
+	void raiseSignal() { std::cout << ' ' << prefix() << "raise signal\n"; _signal = true; }
+	void kill() {}
+
+	private:
+		std::string prefix() const
+		{
+			return _name.empty() ? std::string() : _name + ": ";
+		}
+		template<typename FSM>
+		static auto durationMs( const FSM* fsm )
+		{
+			return std::chrono::duration_cast<std::chrono::milliseconds>( fsm->timeOutChrono( fsm->currentState() ) ).count();
+		}
+};
+
+} // namespace test
+
+#endif // HG_SPAG_TEST_COMMON_HPP